@@ -7,6 +7,8 @@ endif()
 
 message(STATUS "Third-party: creating target 'tinyexpr::tinyexpr'")
 
+# utils/ExpressionValue.cpp evaluates the compiled expression trees directly,
+# check the node types there when updating the tag
 include(CPM)
 CPMAddPackage(
     NAME tinyexpr
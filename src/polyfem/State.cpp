@@ -2,6 +2,7 @@
 #include <polyfem/Common.hpp>
 
 #include <polyfem/io/MatrixIO.hpp>
+#include <polyfem/io/Snapshot.hpp>
 
 #include <polyfem/assembler/Mass.hpp>
 #include <polyfem/assembler/MultiModel.hpp>
@@ -590,6 +591,7 @@ namespace polyfem
 		polys.clear();
 		poly_edge_to_data.clear();
 		rhs.resize(0, 0);
+		out_geom.clear_vis_mesh_cache();
 
 		if (assembler::MultiModel *mm = dynamic_cast<assembler::MultiModel *>(assembler.get()))
 		{
@@ -1016,18 +1018,28 @@ namespace polyfem
 
 		ass_vals_cache.clear();
 		mass_ass_vals_cache.clear();
-		if (n_bases <= args["solver"]["advanced"]["cache_size"])
+		// the full cache is retrieved without copies, when it is too large the reference tables
+		// keep only the geometric mapping per element and the bases are mapped on the fly
+		const bool fits_cache = n_bases <= args["solver"]["advanced"]["cache_size"];
+		const bool use_reference_tables = !fits_cache && args["solver"]["advanced"]["cache_reference_bases"];
+		if (fits_cache || use_reference_tables)
 		{
 			timer.start();
-			logger().info("Building cache...");
-			ass_vals_cache.init(mesh->is_volume(), bases, curret_bases);
-			mass_ass_vals_cache.init(mesh->is_volume(), bases, curret_bases, true);
+			logger().info(use_reference_tables ? "Building reference cache..." : "Building cache...");
+			ass_vals_cache.init(mesh->is_volume(), bases, curret_bases, false, use_reference_tables);
+			mass_ass_vals_cache.init(mesh->is_volume(), bases, curret_bases, true, use_reference_tables);
 			if (mixed_assembler != nullptr)
-				pressure_ass_vals_cache.init(mesh->is_volume(), pressure_bases, curret_bases);
+				pressure_ass_vals_cache.init(mesh->is_volume(), pressure_bases, curret_bases, false, use_reference_tables);
 
 			logger().info(" took {}s", timer.getElapsedTime());
 		}
 
+		// the bases changed, the coloring is rebuilt by the nonlinear solve if needed
+		element_coloring.clear();
+
+		// checked against the new bases, throws if it was saved for another discretization
+		input_snapshot = load_snapshot();
+
 		out_geom.build_grid(*mesh, args["output"]["advanced"]["sol_on_grid"]);
 
 		if (!problem->is_time_dependent() && boundary_nodes.empty())
@@ -1322,6 +1334,19 @@ namespace polyfem
 		collision_mesh.init_area_jacobians();
 	}
 
+	void State::build_element_coloring()
+	{
+		if (!element_coloring.empty())
+			return;
+
+		igl::Timer timer;
+		timer.start();
+		logger().info("Coloring elements...");
+		element_coloring.init(AssemblerUtils::element_global_nodes(bases), n_bases);
+		timer.stop();
+		logger().info(" took {}s, {} colors", timer.getElapsedTime(), element_coloring.n_colors());
+	}
+
 	void State::assemble_mass_mat()
 	{
 		if (!mesh)
@@ -1352,6 +1377,22 @@ namespace polyfem
 
 		igl::Timer timer;
 		timer.start();
+
+		if (can_load_snapshot_mass())
+		{
+			mass = input_snapshot->sparse("mass");
+			avg_mass = input_snapshot->matrix("avg_mass")(0);
+
+			timer.stop();
+			timings.assembling_mass_mat_time = timer.getElapsedTime();
+			logger().info("Loaded mass mat from {}, took {}s", input_snapshot->path(), timings.assembling_mass_mat_time);
+
+			stats.nn_zero = mass.nonZeros();
+			stats.num_dofs = mass.rows();
+			stats.mat_size = (long long)mass.rows() * (long long)mass.cols();
+			return;
+		}
+
 		logger().info("Assembling mass mat...");
 
 		if (mixed_assembler != nullptr)
@@ -1526,6 +1567,19 @@ namespace polyfem
 		// pressure.resize(0, 0);
 		stats.spectrum.setZero();
 
+		const bool profile = args["output"]["advanced"]["profile"];
+		if (profile)
+		{
+			Profiler::get().clear();
+			Profiler::get().enable(true);
+		}
+
+		const json &async_args = args["output"]["advanced"]["async_writer"];
+		if (async_args["enabled"])
+			out_geom.set_async_writer(std::make_shared<io::AsyncWriter>(async_args["threads"], async_args["queue_size"]));
+		else
+			out_geom.set_async_writer(nullptr);
+
 		igl::Timer timer;
 		timer.start();
 		logger().info("Solving {}", assembler->name());
@@ -1585,6 +1639,18 @@ namespace polyfem
 		timer.stop();
 		timings.solving_time = timer.getElapsedTime();
 		logger().info(" took {}s", timings.solving_time);
+
+		out_geom.flush_output();
+		out_geom.close_time_sequence();
+
+		if (profile)
+		{
+			// next to stats.csv
+			const std::string profile_path = resolve_output_path("profile.json");
+			Profiler::get().enable(false);
+			Profiler::get().write_trace(profile_path);
+			logger().info("Profiler trace written to {}", profile_path);
+		}
 	}
 
 } // namespace polyfem
@@ -26,6 +26,7 @@
 #include <polyfem/utils/ElasticityUtils.hpp>
 #include <polyfem/utils/JSONUtils.hpp>
 #include <polyfem/utils/Logger.hpp>
+#include <polyfem/utils/ElementColoring.hpp>
 
 #include <polyfem/io/OutData.hpp>
 
@@ -64,6 +65,11 @@ namespace polyfem
 		class Mesh3D;
 	} // namespace mesh
 
+	namespace io
+	{
+		class SnapshotReader;
+	} // namespace io
+
 	/// main class that contains the polyfem solver and all its state
 	class State
 	{
@@ -186,6 +192,14 @@ namespace polyfem
 		/// used to store assembly values for pressure for small problems
 		assembler::AssemblyValsCache pressure_ass_vals_cache;
 
+		/// coloring of the elements (two elements sharing a basis have different colors), used for race-free parallel assembly
+		/// built on demand by build_element_coloring, cleared by build_basis
+		utils::ElementColoring element_coloring;
+
+		/// snapshot of args["input"]["data"]["snapshot"] checked against the bases (see load_snapshot),
+		/// opened once by build_basis, nullptr if none is given
+		std::shared_ptr<io::SnapshotReader> input_snapshot;
+
 		/// Mass matrix, it is computed only for time dependent problems
 		StiffnessMatrix mass;
 		/// average system mass, used for contact with IPC
@@ -218,6 +232,8 @@ namespace polyfem
 		/// dirichlet_nodes, neumann_nodes, local_boundary, total_local_boundary
 		/// local_neumann_boundary, polys, poly_edge_to_data, rhs
 		void build_basis();
+		/// colors the elements of the bases if not already done, used by the nonlinear assembly
+		void build_element_coloring();
 		/// compute rhs, step 3 of solve
 		/// build rhs vector based on defined basis and given rhs of the problem
 		/// modifies rhs (and maybe more?)
@@ -595,6 +611,20 @@ namespace polyfem
 		/// @param t current time to restart at
 		void save_restart_json(const double t0, const double dt, const int t) const;
 
+		/// @brief Save a binary snapshot (node ordering, mass matrix, and time integrator history, with the mesh vertices
+		/// to check that it is loaded on the same mesh) used by a restart to skip the mass matrix assembly and to load the
+		/// initial conditions
+		/// @param path snapshot file
+		/// @param time_integrator time integrator whose history is saved
+		void save_snapshot(const std::string &path, const time_integrator::ImplicitTimeIntegrator &time_integrator) const;
+
+		/// @brief Open the snapshot of args["input"]["data"]["snapshot"], throws if it was saved for another discretization
+		/// @return the snapshot, nullptr if none is given
+		std::shared_ptr<io::SnapshotReader> load_snapshot() const;
+
+		/// @brief true if input_snapshot has a mass matrix assembled with the current materials and mass lumping
+		bool can_load_snapshot_mass() const;
+
 		//-----------PATH management
 		/// Get the root path for the state (e.g., args["root_path"] or ".")
 		/// @return root path
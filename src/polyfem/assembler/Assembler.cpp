@@ -1,7 +1,9 @@
 #include "Assembler.hpp"
+#include "Assembler.tpp"
 
 #include <polyfem/utils/Logger.hpp>
 #include <polyfem/utils/MaybeParallelFor.hpp>
+#include <polyfem/utils/Timer.hpp>
 
 #include <igl/Timer.h>
 
@@ -164,223 +166,149 @@ namespace polyfem::assembler
 		StiffnessMatrix &stiffness,
 		const bool is_mass) const
 	{
+		assemble_with(
+			is_volume, n_basis, bases, gbases, cache, t, stiffness, is_mass,
+			[this](const LinearAssemblerData &data) { return assemble(data); });
+	}
+
+	void LinearAssembler::assemble(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		BlockSparseMatrix &stiffness) const
+	{
+		POLYFEM_PROFILE_SCOPE("block linear assembly");
 		assert(size() > 0);
 
 		const int max_triplets_size = int(1e7);
 		const int buffer_size = std::min(long(max_triplets_size), long(n_basis) * size());
-		// #ifdef POLYFEM_WITH_TBB
-		// 		buffer_size /= tbb::task_scheduler_init::default_num_threads();
-		// #endif
-		// logger().trace("buffer_size {}", buffer_size);
+		const int bs = size();
+
 		try
 		{
-			stiffness.resize(n_basis * size(), n_basis * size());
-			stiffness.setZero();
-
-			auto storage = create_thread_storage(LocalThreadMatStorage(buffer_size, stiffness.rows(), stiffness.cols()));
+			auto storage = create_thread_storage(LocalThreadMatStorage(buffer_size, BlockSparseMatrixCache(n_basis * bs, bs)));
 
-			const int n_bases = int(bases.size());
-			igl::Timer timer;
-			timer.start();
-			assert(cache.is_mass() == is_mass);
-
-			// (potentially parallel) loop over elements
-			// Note that n_bases is the number of elements since ach ElementBases object stores
-			// all local basis functions on a given element
-			maybe_parallel_for(n_bases, [&](int start, int end, int thread_id) {
+			maybe_parallel_for(int(bases.size()), [&](int start, int end, int thread_id) {
+				POLYFEM_PROFILE_SCOPE("local assembly");
 				LocalThreadMatStorage &local_storage = get_local_thread_storage(storage, thread_id);
+				std::array<double, 9> block, block_t;
 
 				for (int e = start; e < end; ++e)
 				{
-					ElementAssemblyValues &vals = local_storage.vals;
-					// igl::Timer timer; timer.start();
-					// vals.compute(e, is_volume, bases[e], gbases[e]);
-
-					// compute geometric mapping
-					// evaluate and store basis functions/their gradients at quadrature points
-					cache.compute(e, is_volume, bases[e], gbases[e], vals);
+					const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], local_storage.vals);
 
-					const Quadrature &quadrature = vals.quadrature;
-
-					assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
-					local_storage.da = vals.det.array() * quadrature.weights.array();
+					assert(MAX_QUAD_POINTS == -1 || vals.quadrature.weights.size() < MAX_QUAD_POINTS);
+					local_storage.da = vals.det.array() * vals.quadrature.weights.array();
 					const int n_loc_bases = int(vals.basis_values.size());
 
 					for (int i = 0; i < n_loc_bases; ++i)
 					{
-						// const AssemblyValues &values_i = vals.basis_values[i];
-						// const Eigen::MatrixXd &gradi = values_i.grad_t_m;
 						const auto &global_i = vals.basis_values[i].global;
 
-						// loop over other bases up to the current one, taking advantage of symmetry
+						// symmetric, the block (j, i) is the transpose of (i, j)
 						for (int j = 0; j <= i; ++j)
 						{
-							// const AssemblyValues &values_j = vals.basis_values[j];
-							// const Eigen::MatrixXd &gradj = values_j.grad_t_m;
 							const auto &global_j = vals.basis_values[j].global;
 
-							// compute local entry in stiffness matrix
 							const auto stiffness_val = assemble(LinearAssemblerData(vals, t, i, j, local_storage.da));
-							assert(stiffness_val.size() == size() * size());
+							assert(stiffness_val.size() == bs * bs);
 
-							// igl::Timer t1; t1.start();
-							// loop over dimensions of the problem
-							for (int n = 0; n < size(); ++n)
+							for (size_t ii = 0; ii < global_i.size(); ++ii)
 							{
-								for (int m = 0; m < size(); ++m)
+								for (size_t jj = 0; jj < global_j.size(); ++jj)
 								{
-									const double local_value = stiffness_val(n * size() + m);
+									const double w = global_i[ii].val * global_j[jj].val;
 
-									// loop over the global nodes corresponding to local element (useful for non-conforming cases)
-									for (size_t ii = 0; ii < global_i.size(); ++ii)
+									// same entries as the scalar assembly: (gi * bs + m, gj * bs + n) gets stiffness_val(n * bs + m)
+									for (int m = 0; m < bs; ++m)
 									{
-										const auto gi = global_i[ii].index * size() + m;
-										const auto wi = global_i[ii].val;
-
-										for (size_t jj = 0; jj < global_j.size(); ++jj)
+										for (int n = 0; n < bs; ++n)
 										{
-											const auto gj = global_j[jj].index * size() + n;
-											const auto wj = global_j[jj].val;
-
-											// add local value to the global matrix (weighted by corresponding nodes)
-											local_storage.cache->add_value(e, gi, gj, local_value * wi * wj);
-											if (j < i)
-											{
-												local_storage.cache->add_value(e, gj, gi, local_value * wj * wi);
-											}
-
-											if (local_storage.cache->entries_size() >= max_triplets_size)
-											{
-												local_storage.cache->prune();
-												logger().trace("cleaning memory. Current storage: {}. mat nnz: {}", local_storage.cache->capacity(), local_storage.cache->non_zeros());
-											}
+											block[m * bs + n] = stiffness_val(n * bs + m) * w;
+											block_t[n * bs + m] = block[m * bs + n];
 										}
 									}
+
+									local_storage.cache->add_block(e, global_i[ii].index, global_j[jj].index, bs, block.data());
+									if (j < i)
+										local_storage.cache->add_block(e, global_j[jj].index, global_i[ii].index, bs, block_t.data());
+
+									if (local_storage.cache->entries_size() >= max_triplets_size)
+										local_storage.cache->prune();
 								}
 							}
-
-							// t1.stop();
-							// if (!vals.has_parameterization) { std::cout << "-- t1: " << t1.getElapsedTime() << std::endl; }
 						}
 					}
-
-					// timer.stop();
-					// if (!vals.has_parameterization) { std::cout << "-- Timer: " << timer.getElapsedTime() << std::endl; }
 				}
 			});
 
-			timer.stop();
-			logger().trace("done separate assembly {}s...", timer.getElapsedTime());
-
-			// Assemble the stiffness matrix by concatenating the tuples in each local storage
-
-			// Collect thread storages
-			std::vector<LocalThreadMatStorage *> storages(storage.size());
-			int index = 0;
+			// merge the thread blocks, every thread first compresses its own blocks
+			std::vector<LocalThreadMatStorage *> storages;
 			for (auto &local_storage : storage)
-			{
-				storages[index++] = &local_storage;
-			}
-
-			timer.start();
-			maybe_parallel_for(storages.size(), [&](int i) {
-				storages[i]->cache->prune();
-			});
-			timer.stop();
-			logger().trace("done pruning triplets {}s...", timer.getElapsedTime());
-
-			// Prepares for parallel concatenation
-			std::vector<int> offsets(storage.size());
+				storages.push_back(&local_storage);
 
-			index = 0;
-			int triplet_count = 0;
-			for (auto &local_storage : storage)
 			{
-				offsets[index++] = triplet_count;
-				triplet_count += local_storage.cache->triplet_count();
+				POLYFEM_PROFILE_SCOPE("prune blocks");
+				maybe_parallel_for(storages.size(), [&](int i) {
+					storages[i]->cache->prune();
+				});
 			}
 
-			std::vector<Eigen::Triplet<double>> triplets;
+			BlockSparseMatrixCache &merged = dynamic_cast<BlockSparseMatrixCache &>(*storages[0]->cache);
+			for (size_t i = 1; i < storages.size(); ++i)
+				merged += *storages[i]->cache;
 
-			assert(storages.size() >= 1);
-			if (storages[0]->cache->is_dense())
-			{
-				timer.start();
-				// Serially merge local storages
-				Eigen::MatrixXd tmp(stiffness);
-				for (const LocalThreadMatStorage &local_storage : storage)
-					tmp += dynamic_cast<const DenseMatrixCache &>(*local_storage.cache).mat();
-				stiffness = tmp.sparseView();
-				stiffness.makeCompressed();
-				timer.stop();
-
-				logger().trace("Serial assembly time: {}s...", timer.getElapsedTime());
-			}
-			else if (triplet_count >= triplets.max_size())
-			{
-				// Serial fallback version in case the vector of triplets cannot be allocated
+			stiffness = merged.block_matrix();
+		}
+		catch (std::bad_alloc &ba)
+		{
+			log_and_throw_error("bad alloc {}", ba.what());
+		}
+	}
 
-				logger().warn("Cannot allocate space for triplets, switching to serial assembly.");
+	void LinearAssembler::apply_local(const ElementAssemblyValues &vals, const double t, const QuadratureVector &da, const Eigen::MatrixXd &u, Eigen::MatrixXd &y) const
+	{
+		const int n_loc_bases = int(vals.basis_values.size());
+		assert(u.rows() == n_loc_bases && u.cols() == size());
 
-				timer.start();
-				// Serially merge local storages
-				for (LocalThreadMatStorage &local_storage : storage)
-					stiffness += local_storage.cache->get_matrix(false); // will also prune
-				stiffness.makeCompressed();
-				timer.stop();
+		y.setZero(n_loc_bases, size());
 
-				logger().trace("Serial assembly time: {}s...", timer.getElapsedTime());
-			}
-			else
+		// same symmetric blocks as in assemble, entry (i, m), (j, n) is stiffness_val(n * size() + m)
+		for (int i = 0; i < n_loc_bases; ++i)
+		{
+			for (int j = 0; j <= i; ++j)
 			{
-				timer.start();
-				triplets.resize(triplet_count);
-				timer.stop();
-
-				logger().trace("done allocate triplets {}s...", timer.getElapsedTime());
-				logger().trace("Triplets Count: {}", triplet_count);
-
-				timer.start();
-				// Parallel copy into triplets
-				maybe_parallel_for(storages.size(), [&](int i) {
-					const SparseMatrixCache &cache = dynamic_cast<const SparseMatrixCache &>(*storages[i]->cache);
-					int offset = offsets[i];
-
-					std::copy(cache.entries().begin(), cache.entries().end(), triplets.begin() + offset);
-					offset += cache.entries().size();
+				const auto stiffness_val = assemble(LinearAssemblerData(vals, t, i, j, da));
+				assert(stiffness_val.size() == size() * size());
 
-					if (cache.mat().nonZeros() > 0)
+				for (int n = 0; n < size(); ++n)
+				{
+					for (int m = 0; m < size(); ++m)
 					{
-						int count = 0;
-						for (int k = 0; k < cache.mat().outerSize(); ++k)
-						{
-							for (Eigen::SparseMatrix<double>::InnerIterator it(cache.mat(), k); it; ++it)
-							{
-								assert(count < cache.mat().nonZeros());
-								triplets[offset + count++] = Eigen::Triplet<double>(it.row(), it.col(), it.value());
-							}
-						}
+						const double local_value = stiffness_val(n * size() + m);
+						y(i, m) += local_value * u(j, n);
+						if (j < i)
+							y(j, n) += local_value * u(i, m);
 					}
-				});
-
-				timer.stop();
-				logger().trace("done concatenate triplets {}s...", timer.getElapsedTime());
-
-				timer.start();
-				// Sort and assemble
-				stiffness.setFromTriplets(triplets.begin(), triplets.end());
-				timer.stop();
-
-				logger().trace("done setFromTriplets assembly {}s...", timer.getElapsedTime());
+				}
 			}
 		}
-		catch (std::bad_alloc &ba)
+	}
+
+	void LinearAssembler::local_diagonal(const ElementAssemblyValues &vals, const double t, const QuadratureVector &da, Eigen::MatrixXd &diag) const
+	{
+		const int n_loc_bases = int(vals.basis_values.size());
+		diag.resize(n_loc_bases, size());
+
+		for (int i = 0; i < n_loc_bases; ++i)
 		{
-			log_and_throw_error("bad alloc {}", ba.what());
+			const auto stiffness_val = assemble(LinearAssemblerData(vals, t, i, i, da));
+			for (int m = 0; m < size(); ++m)
+				diag(i, m) = stiffness_val(m * size() + m);
 		}
-
-		// stiffness.resize(n_basis*size(), n_basis*size());
-		// stiffness.setFromTriplets(entries.begin(), entries.end());
 	}
 
 	MixedAssembler::MixedAssembler()
@@ -416,15 +344,16 @@ namespace polyfem::assembler
 		timer.start();
 
 		maybe_parallel_for(n_bases, [&](int start, int end, int thread_id) {
+			POLYFEM_PROFILE_SCOPE("local assembly");
 			LocalThreadMatStorage &local_storage = get_local_thread_storage(storage, thread_id);
-			ElementAssemblyValues psi_vals, phi_vals;
+			ElementAssemblyValues psi_tmp, phi_tmp;
 
 			for (int e = start; e < end; ++e)
 			{
 				// psi_vals.compute(e, is_volume, psi_bases[e], gbases[e]);
 				// phi_vals.compute(e, is_volume, phi_bases[e], gbases[e]);
-				psi_cache.compute(e, is_volume, psi_bases[e], gbases[e], psi_vals);
-				phi_cache.compute(e, is_volume, phi_bases[e], gbases[e], phi_vals);
+				const ElementAssemblyValues &psi_vals = psi_cache.get(e, is_volume, psi_bases[e], gbases[e], psi_tmp);
+				const ElementAssemblyValues &phi_vals = phi_cache.get(e, is_volume, phi_bases[e], gbases[e], phi_tmp);
 
 				const Quadrature &quadrature = phi_vals.quadrature;
 
@@ -502,32 +431,18 @@ namespace polyfem::assembler
 		const Eigen::MatrixXd &displacement,
 		const Eigen::MatrixXd &displacement_prev) const
 	{
-		auto storage = create_thread_storage(LocalThreadScalarStorage());
-		const int n_bases = int(bases.size());
-
-		maybe_parallel_for(n_bases, [&](int start, int end, int thread_id) {
-			LocalThreadScalarStorage &local_storage = get_local_thread_storage(storage, thread_id);
-			ElementAssemblyValues &vals = local_storage.vals;
-
-			for (int e = start; e < end; ++e)
-			{
-				cache.compute(e, is_volume, bases[e], gbases[e], vals);
-
-				const Quadrature &quadrature = vals.quadrature;
-
-				assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
-				local_storage.da = vals.det.array() * quadrature.weights.array();
-
-				const double val = compute_energy(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da));
-				local_storage.val += val;
-			}
-		});
+		if (use_batched_kernels())
+		{
+			POLYFEM_PROFILE_SCOPE("energy assembly");
+			if (size() == 2)
+				return assemble_energy_batched<TriangleBatch>(is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev);
+			else if (size() == 3)
+				return assemble_energy_batched<TetBatch>(is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev);
+		}
 
-		double res = 0;
-		// Serially merge local storages
-		for (const LocalThreadScalarStorage &local_storage : storage)
-			res += local_storage.val;
-		return res;
+		return assemble_energy_with(
+			is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev,
+			[this](const NonLinearAssemblerData &data) { return compute_energy(data); });
 	}
 
 	Eigen::VectorXd NLAssembler::assemble_energy_per_element(
@@ -540,24 +455,24 @@ namespace polyfem::assembler
 		const Eigen::MatrixXd &displacement,
 		const Eigen::MatrixXd &displacement_prev) const
 	{
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
 		auto storage = create_thread_storage(LocalThreadScalarStorage());
 		const int n_bases = int(bases.size());
 		Eigen::VectorXd out(bases.size());
 
 		maybe_parallel_for(n_bases, [&](int start, int end, int thread_id) {
 			LocalThreadScalarStorage &local_storage = get_local_thread_storage(storage, thread_id);
-			ElementAssemblyValues &vals = local_storage.vals;
-
 			for (int e = start; e < end; ++e)
 			{
-				cache.compute(e, is_volume, bases[e], gbases[e], vals);
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], local_storage.vals);
 
 				const Quadrature &quadrature = vals.quadrature;
 
 				assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
 				local_storage.da = vals.det.array() * quadrature.weights.array();
 
-				const double val = compute_energy(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da));
+				const double val = compute_energy(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da, material_state));
 				out[e] = val;
 			}
 		});
@@ -583,62 +498,279 @@ namespace polyfem::assembler
 		const Eigen::MatrixXd &displacement_prev,
 		Eigen::MatrixXd &rhs) const
 	{
-		rhs.resize(n_basis * size(), 1);
-		rhs.setZero();
+		if (use_batched_kernels())
+		{
+			POLYFEM_PROFILE_SCOPE("gradient assembly");
+			if (size() == 2)
+				return assemble_gradient_batched<TriangleBatch>(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+			else if (size() == 3)
+				return assemble_gradient_batched<TetBatch>(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+		}
+
+		assemble_gradient_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev,
+			[this](const NonLinearAssemblerData &data) { return assemble_gradient(data); },
+			rhs);
+	}
+
+	void NLAssembler::assemble_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		const ElementColoring &coloring,
+		Eigen::MatrixXd &rhs) const
+	{
+		// batches mix elements of different colors
+		if (use_batched_kernels())
+		{
+			assemble_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+			return;
+		}
+
+		assemble_gradient_colored_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring,
+			[this](const NonLinearAssemblerData &data) { return assemble_gradient(data); },
+			rhs);
+	}
+
+	double NLAssembler::assemble_energy_and_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		Eigen::MatrixXd &rhs) const
+	{
+		// the batched kernels have their own element loops
+		if (use_batched_kernels())
+			return Assembler::assemble_energy_and_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+
+		return assemble_energy_and_gradient_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev,
+			[this](const NonLinearAssemblerData &data, Eigen::VectorXd &gradient) { return compute_energy_and_gradient(data, gradient); },
+			rhs);
+	}
+
+	double NLAssembler::assemble_energy_and_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		const ElementColoring &coloring,
+		Eigen::MatrixXd &rhs) const
+	{
+		// batches mix elements of different colors
+		if (use_batched_kernels())
+			return assemble_energy_and_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+
+		return assemble_energy_and_gradient_colored_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring,
+			[this](const NonLinearAssemblerData &data, Eigen::VectorXd &gradient) { return compute_energy_and_gradient(data, gradient); },
+			rhs);
+	}
+
+	const MaterialStateBuffer *NLAssembler::valid_material_state(const double t, const Eigen::MatrixXd &displacement) const
+	{
+		if (material_state_ && material_state_->is_valid(t, displacement))
+			return material_state_.get();
+		return nullptr;
+	}
 
-		auto storage = create_thread_storage(LocalThreadVecStorage(rhs.size()));
+	void NLAssembler::compute_batch_params(const ElementAssemblyValues &vals, const double t, Eigen::MatrixXd &params) const
+	{
+		log_and_throw_error("Batched kernels not implemented for {}!", name());
+	}
+
+	void NLAssembler::compute_energy_batch(const TriangleBatch &batch, TriangleBatch::Lane &energy) const
+	{
+		log_and_throw_error("Batched kernels not implemented for {}!", name());
+	}
+
+	void NLAssembler::compute_energy_batch(const TetBatch &batch, TetBatch::Lane &energy) const
+	{
+		log_and_throw_error("Batched kernels not implemented for {}!", name());
+	}
+
+	void NLAssembler::compute_gradient_batch(const TriangleBatch &batch, TriangleBatch::LaneDofs &gradient) const
+	{
+		log_and_throw_error("Batched kernels not implemented for {}!", name());
+	}
+
+	void NLAssembler::compute_gradient_batch(const TetBatch &batch, TetBatch::LaneDofs &gradient) const
+	{
+		log_and_throw_error("Batched kernels not implemented for {}!", name());
+	}
+
+	template <class Batch>
+	double NLAssembler::assemble_energy_batched(
+		const bool is_volume,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev) const
+	{
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		struct LocalThreadBatchStorage : LocalThreadScalarStorage
+		{
+			Batch batch;
+			typename Batch::Lane lane_energy;
+			Eigen::MatrixXd params;
+		};
 
+		auto storage = create_thread_storage(LocalThreadBatchStorage());
 		const int n_bases = int(bases.size());
 
 		maybe_parallel_for(n_bases, [&](int start, int end, int thread_id) {
-			LocalThreadVecStorage &local_storage = get_local_thread_storage(storage, thread_id);
+			LocalThreadBatchStorage &local_storage = get_local_thread_storage(storage, thread_id);
+			Batch &batch = local_storage.batch;
+
+			const auto flush = [&]() {
+				compute_energy_batch(batch, local_storage.lane_energy);
+				local_storage.val += local_storage.lane_energy.sum();
+				batch.clear();
+			};
 
 			for (int e = start; e < end; ++e)
 			{
-				// igl::Timer timer; timer.start();
-
-				ElementAssemblyValues &vals = local_storage.vals;
-				// vals.compute(e, is_volume, bases[e], gbases[e]);
-				cache.compute(e, is_volume, bases[e], gbases[e], vals);
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], local_storage.vals);
 
 				const Quadrature &quadrature = vals.quadrature;
 
 				assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
 				local_storage.da = vals.det.array() * quadrature.weights.array();
-				const int n_loc_bases = int(vals.basis_values.size());
 
-				const auto val = assemble_gradient(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da));
-				assert(val.size() == n_loc_bases * size());
+				// other elements (e.g., higher order or polygons) use the per-element kernel
+				if (!Batch::is_compatible(vals))
+				{
+					local_storage.val += compute_energy(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da, material_state));
+					continue;
+				}
 
-				for (int j = 0; j < n_loc_bases; ++j)
+				compute_batch_params(vals, t, local_storage.params);
+				for (int p = 0; p < local_storage.da.size(); ++p)
 				{
-					const auto &global_j = vals.basis_values[j].global;
+					batch.push(vals, p, displacement, local_storage.da(p), local_storage.params);
+					if (batch.full())
+						flush();
+				}
+			}
 
-					// igl::Timer t1; t1.start();
-					for (int m = 0; m < size(); ++m)
-					{
-						const double local_value = val(j * size() + m);
+			if (!batch.empty())
+				flush();
+		});
 
-						for (size_t jj = 0; jj < global_j.size(); ++jj)
-						{
-							const auto gj = global_j[jj].index * size() + m;
-							const auto wj = global_j[jj].val;
+		double res = 0;
+		// Serially merge local storages
+		for (const LocalThreadBatchStorage &local_storage : storage)
+			res += local_storage.val;
+		return res;
+	}
 
-							local_storage.vec(gj) += local_value * wj;
-						}
-					}
+	template <class Batch>
+	void NLAssembler::assemble_gradient_batched(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		Eigen::MatrixXd &rhs) const
+	{
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		struct LocalThreadBatchStorage : LocalThreadVecStorage
+		{
+			LocalThreadBatchStorage(const int size) : LocalThreadVecStorage(size) {}
+
+			Batch batch;
+			typename Batch::LaneDofs lane_gradient;
+			Eigen::MatrixXd params;
+		};
+
+		rhs.resize(n_basis * size(), 1);
+		rhs.setZero();
+
+		auto storage = create_thread_storage(LocalThreadBatchStorage(rhs.size()));
+
+		const int n_bases = int(bases.size());
+
+		maybe_parallel_for(n_bases, [&](int start, int end, int thread_id) {
+			LocalThreadBatchStorage &local_storage = get_local_thread_storage(storage, thread_id);
+			Batch &batch = local_storage.batch;
+
+			const auto scatter = [&](const int e, const int j, const int m, const double local_value) {
+				const auto &global_j = bases[e].bases[j].global();
+				for (size_t jj = 0; jj < global_j.size(); ++jj)
+					local_storage.vec(global_j[jj].index * size() + m) += local_value * global_j[jj].val;
+			};
+
+			const auto flush = [&]() {
+				compute_gradient_batch(batch, local_storage.lane_gradient);
+				for (int k = 0; k < batch.size(); ++k)
+					for (int j = 0; j < Batch::n_basis; ++j)
+						for (int m = 0; m < Batch::dim; ++m)
+							scatter(batch.element[k], j, m, local_storage.lane_gradient[j * Batch::dim + m](k));
+				batch.clear();
+			};
+
+			for (int e = start; e < end; ++e)
+			{
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], local_storage.vals);
 
-					// t1.stop();
-					// if (!vals.has_parameterization) { std::cout << "-- t1: " << t1.getElapsedTime() << std::endl; }
+				const Quadrature &quadrature = vals.quadrature;
+
+				assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
+				local_storage.da = vals.det.array() * quadrature.weights.array();
+
+				// other elements (e.g., higher order or polygons) use the per-element kernel
+				if (!Batch::is_compatible(vals))
+				{
+					const auto val = assemble_gradient(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da, material_state));
+					const int n_loc_bases = int(vals.basis_values.size());
+					assert(val.size() == n_loc_bases * size());
+					for (int j = 0; j < n_loc_bases; ++j)
+						for (int m = 0; m < size(); ++m)
+							scatter(e, j, m, val(j * size() + m));
+					continue;
 				}
 
-				// timer.stop();
-				// if (!vals.has_parameterization) { std::cout << "-- Timer: " << timer.getElapsedTime() << std::endl; }
+				compute_batch_params(vals, t, local_storage.params);
+				for (int p = 0; p < local_storage.da.size(); ++p)
+				{
+					batch.push(vals, p, displacement, local_storage.da(p), local_storage.params);
+					if (batch.full())
+						flush();
+				}
 			}
+
+			if (!batch.empty())
+				flush();
 		});
 
 		// Serially merge local storages
-		for (const LocalThreadVecStorage &local_storage : storage)
+		for (const LocalThreadBatchStorage &local_storage : storage)
 			rhs += local_storage.vec;
 	}
 
@@ -656,6 +788,9 @@ namespace polyfem::assembler
 		MatrixCache &mat_cache,
 		StiffnessMatrix &hess) const
 	{
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		POLYFEM_PROFILE_SCOPE("hessian assembly");
 		const int max_triplets_size = int(1e7);
 		const int buffer_size = std::min(long(max_triplets_size), long(n_basis) * size());
 		// std::cout<<"buffer_size "<<buffer_size<<std::endl;
@@ -677,8 +812,7 @@ namespace polyfem::assembler
 
 			for (int e = start; e < end; ++e)
 			{
-				ElementAssemblyValues &vals = local_storage.vals;
-				cache.compute(e, is_volume, bases[e], gbases[e], vals);
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], local_storage.vals);
 
 				const Quadrature &quadrature = vals.quadrature;
 
@@ -686,7 +820,7 @@ namespace polyfem::assembler
 				local_storage.da = vals.det.array() * quadrature.weights.array();
 				const int n_loc_bases = int(vals.basis_values.size());
 
-				auto stiffness_val = assemble_hessian(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da));
+				auto stiffness_val = assemble_hessian(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da, material_state));
 				assert(stiffness_val.rows() == n_loc_bases * size());
 				assert(stiffness_val.cols() == n_loc_bases * size());
 
@@ -759,15 +893,113 @@ namespace polyfem::assembler
 		timer.start();
 
 		// Serially merge local storages
-		for (LocalThreadMatStorage &local_storage : storage)
 		{
-			local_storage.cache->prune();
-			mat_cache += *local_storage.cache;
+			POLYFEM_PROFILE_SCOPE("merge triplets");
+			for (LocalThreadMatStorage &local_storage : storage)
+			{
+				local_storage.cache->prune();
+				mat_cache += *local_storage.cache;
+			}
+		}
+		{
+			POLYFEM_PROFILE_SCOPE("setFromTriplets");
+			hess = mat_cache.get_matrix();
 		}
-		hess = mat_cache.get_matrix();
 
 		timer.stop();
 		logger().trace("done merge assembly {}s...", timer.getElapsedTime());
 	}
 
+	void NLAssembler::assemble_hessian(
+		const bool is_volume,
+		const int n_basis,
+		const bool project_to_psd,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		ElementScatterMap &scatter_map,
+		StiffnessMatrix &hess) const
+	{
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		POLYFEM_PROFILE_SCOPE("hessian assembly");
+		if (!scatter_map.is_valid_for(n_basis, size(), bases) || !scatter_map.has_element_indices())
+			scatter_map.init(n_basis, size(), bases);
+		scatter_map.set_zero();
+
+		auto storage = create_thread_storage(LocalThreadVecStorage(0));
+
+		const ElementColoring &coloring = scatter_map.element_coloring();
+		assert(coloring.n_elements() == bases.size());
+
+		igl::Timer timer;
+		timer.start();
+
+		const auto assemble_element = [&](const int e, const int thread_id) {
+			LocalThreadVecStorage &local_storage = get_local_thread_storage(storage, thread_id);
+
+			const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], local_storage.vals);
+
+			const Quadrature &quadrature = vals.quadrature;
+
+			assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
+			local_storage.da = vals.det.array() * quadrature.weights.array();
+			const int n_loc_bases = int(vals.basis_values.size());
+
+			auto stiffness_val = assemble_hessian(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, local_storage.da, material_state));
+			assert(stiffness_val.rows() == n_loc_bases * size());
+			assert(stiffness_val.cols() == n_loc_bases * size());
+
+			if (project_to_psd)
+				stiffness_val = ipc::project_to_psd(stiffness_val);
+
+			// same loop order used to build the scatter map
+			const ElementScatterMap::StorageIndex *indices = scatter_map.element_indices(e);
+			size_t k = 0;
+
+			for (int i = 0; i < n_loc_bases; ++i)
+			{
+				const auto &global_i = vals.basis_values[i].global;
+
+				for (int j = 0; j < n_loc_bases; ++j)
+				{
+					const auto &global_j = vals.basis_values[j].global;
+
+					for (int n = 0; n < size(); ++n)
+					{
+						for (int m = 0; m < size(); ++m)
+						{
+							const double local_value = stiffness_val(i * size() + m, j * size() + n);
+
+							for (size_t ii = 0; ii < global_i.size(); ++ii)
+							{
+								const auto wi = global_i[ii].val;
+
+								for (size_t jj = 0; jj < global_j.size(); ++jj)
+								{
+									const auto wj = global_j[jj].val;
+									scatter_map.add_value(indices[k++], local_value * wi * wj);
+								}
+							}
+						}
+					}
+				}
+			}
+			assert(k == scatter_map.n_element_entries(e));
+		};
+
+		// one color at the time, the sums do not depend on the number of threads
+		coloring.maybe_parallel_for(assemble_element);
+
+		timer.stop();
+		logger().trace("done scatter assembly {}s...", timer.getElapsedTime());
+
+		POLYFEM_PROFILE_SCOPE("scatter to matrix");
+		scatter_map.get_matrix(hess);
+	}
+
 } // namespace polyfem::assembler
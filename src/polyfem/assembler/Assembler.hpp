@@ -4,8 +4,12 @@
 
 #include <polyfem/assembler/AssemblerData.hpp>
 #include <polyfem/assembler/AssemblyValsCache.hpp>
+#include <polyfem/assembler/ElementScatterMap.hpp>
+#include <polyfem/assembler/ElementBatch.hpp>
+#include <polyfem/assembler/MaterialStateBuffer.hpp>
 
 #include <polyfem/utils/MatrixCache.hpp>
+#include <polyfem/utils/ElementColoring.hpp>
 #include <polyfem/utils/ElasticityUtils.hpp>
 #include <polyfem/utils/AutodiffTypes.hpp>
 #include <polyfem/utils/Logger.hpp>
@@ -109,6 +113,55 @@ namespace polyfem::assembler
 			const Eigen::MatrixXd &displacement_prev,
 			Eigen::MatrixXd &rhs) const { log_and_throw_error("Assemble grad not implemented by {}!", name()); }
 
+		// assemble gradient of energy (rhs) directly in rhs, the elements of a color are assembled in parallel
+		virtual void assemble_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			Eigen::MatrixXd &rhs) const { log_and_throw_error("Assemble grad not implemented by {}!", name()); }
+
+		// assemble energy and its gradient (rhs), the assemblers override it to traverse the elements once
+		virtual double assemble_energy_and_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			Eigen::MatrixXd &rhs) const
+		{
+			assemble_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+			return assemble_energy(is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev);
+		}
+
+		// same as above, the gradient is assembled with the element coloring
+		virtual double assemble_energy_and_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			Eigen::MatrixXd &rhs) const
+		{
+			assemble_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring, rhs);
+			return assemble_energy(is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev);
+		}
+
 		// assemble hessian of energy (grad)
 		virtual void assemble_hessian(
 			const bool is_volume,
@@ -124,6 +177,22 @@ namespace polyfem::assembler
 			utils::MatrixCache &mat_cache,
 			StiffnessMatrix &grad) const { log_and_throw_error("Assemble hessian not implemented by {}!", name()); }
 
+		// assemble hessian of energy (grad) directly in the fixed pattern of scatter_map
+		// scatter_map is (re)built if it does not match the bases
+		virtual void assemble_hessian(
+			const bool is_volume,
+			const int n_basis,
+			const bool project_to_psd,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			ElementScatterMap &scatter_map,
+			StiffnessMatrix &grad) const { log_and_throw_error("Assemble hessian not implemented by {}!", name()); }
+
 		// plotting (eg von mises), assembler is the name of the formulation
 		virtual void compute_scalar_value(
 			const OutputData &data,
@@ -227,11 +296,50 @@ namespace polyfem::assembler
 			StiffnessMatrix &stiffness,
 			const bool is_mass = false) const override;
 
+		/// assembles the stiffness matrix in block sparse format, with one size() x size() block per pair of nodes
+		/// the local matrices are added block-wise, the values are the same as the scalar assemble
+		void assemble(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			utils::BlockSparseMatrix &stiffness) const;
+
+		/// same as the scalar assemble, with a local kernel known at compile time. Assemblers can pass a non-virtual
+		/// call (e.g., [this](const LinearAssemblerData &data) { return Laplacian::assemble(data); }) so that it is
+		/// inlined in the element loop. Defined in Assembler.tpp, include it where it is instantiated.
+		template <typename LocalKernel>
+		void assemble_with(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			StiffnessMatrix &stiffness,
+			const bool is_mass,
+			LocalKernel &&local_kernel) const;
+
 		virtual bool is_linear() const override { return true; }
 
 		/// local assembly function that defines the bilinear form (LHS)
 		/// computes and returns a single local stiffness value
 		virtual Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1> assemble(const LinearAssemblerData &data) const = 0;
+
+		/// applies the local stiffness matrix of the element without storing it, used by MatrixFreeOperator
+		/// the default implementation goes through assemble(LinearAssemblerData), assemblers should override it
+		/// with a quadrature point kernel (i.e., compute the flux of u and test it against the basis gradients)
+		/// @param[in] vals element values
+		/// @param[in] t time
+		/// @param[in] da quadrature weights times jacobian determinant
+		/// @param[in] u local coefficients, one row per local basis and size() columns
+		/// @param[out] y local result, same layout as u
+		virtual void apply_local(const ElementAssemblyValues &vals, const double t, const QuadratureVector &da, const Eigen::MatrixXd &u, Eigen::MatrixXd &y) const;
+
+		/// diagonal of the local stiffness matrix, one row per local basis and size() columns
+		virtual void local_diagonal(const ElementAssemblyValues &vals, const double t, const QuadratureVector &da, Eigen::MatrixXd &diag) const;
 	};
 
 	// non-linear assembler (eg neohookean elasticity)
@@ -275,6 +383,47 @@ namespace polyfem::assembler
 			const Eigen::MatrixXd &displacement_prev,
 			Eigen::MatrixXd &rhs) const override;
 
+		// assemble gradient of energy (rhs) without per-thread copies, using the element coloring
+		void assemble_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			Eigen::MatrixXd &rhs) const override;
+
+		// assemble energy and gradient (rhs) in a single element loop, sharing the assembly values of every element
+		double assemble_energy_and_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			Eigen::MatrixXd &rhs) const override;
+
+		// same as above, the gradient is assembled directly in rhs using the element coloring
+		double assemble_energy_and_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			Eigen::MatrixXd &rhs) const override;
+
 		// assemble hessian of energy (grad)
 		void assemble_hessian(
 			const bool is_volume,
@@ -290,13 +439,163 @@ namespace polyfem::assembler
 			utils::MatrixCache &mat_cache,
 			StiffnessMatrix &grad) const override;
 
+		// assemble hessian of energy (grad), element blocks are added directly to the values of scatter_map
+		// one element color at the time, so the result does not depend on the number of threads
+		void assemble_hessian(
+			const bool is_volume,
+			const int n_basis,
+			const bool project_to_psd,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			ElementScatterMap &scatter_map,
+			StiffnessMatrix &grad) const override;
+
 		virtual bool is_linear() const override { return false; }
 
+		// enables the batched kernels in assemble_energy and assemble_gradient, only used if the material has them
+		void set_use_batched_kernels(const bool val) { use_batched_kernels_ = val; }
+		bool use_batched_kernels() const { return use_batched_kernels_ && has_batched_kernels(); }
+
+		// opt-in buffer of the deformation state at the quadrature points, updated by ElasticForm when the solution changes
+		// and passed to the element kernels (NonLinearAssemblerData::material_state) when it matches the assembled solution
+		void set_material_state(const std::shared_ptr<MaterialStateBuffer> &state) { material_state_ = state; }
+		const std::shared_ptr<MaterialStateBuffer> &material_state() const { return material_state_; }
+
+		// opt-in batched kernels working on ElementBatch (P1 triangles and tets), materials supporting them
+		// override has_batched_kernels and all the functions below
+		virtual bool has_batched_kernels() const { return false; }
+		// material parameters at the quadrature points of the element, one row per point and at most ElementBatch::max_params columns
+		virtual void compute_batch_params(const ElementAssemblyValues &vals, const double t, Eigen::MatrixXd &params) const;
+		// energy times da for every lane
+		virtual void compute_energy_batch(const TriangleBatch &batch, TriangleBatch::Lane &energy) const;
+		virtual void compute_energy_batch(const TetBatch &batch, TetBatch::Lane &energy) const;
+		// gradient of the energy times da wrt the local displacement for every lane
+		virtual void compute_gradient_batch(const TriangleBatch &batch, TriangleBatch::LaneDofs &gradient) const;
+		virtual void compute_gradient_batch(const TetBatch &batch, TetBatch::LaneDofs &gradient) const;
+
 	protected:
+		// the material state buffer if it was computed for displacement at time t, nullptr otherwise
+		const MaterialStateBuffer *valid_material_state(const double t, const Eigen::MatrixXd &displacement) const;
+
 		// energy, gradient, and hessian used in newton method
 		virtual double compute_energy(const NonLinearAssemblerData &data) const = 0;
 		virtual Eigen::VectorXd assemble_gradient(const NonLinearAssemblerData &data) const = 0;
 		virtual Eigen::MatrixXd assemble_hessian(const NonLinearAssemblerData &data) const = 0;
+		// energy and local gradient of one element, materials computing both in the same quadrature loop override it
+		virtual double compute_energy_and_gradient(const NonLinearAssemblerData &data, Eigen::VectorXd &gradient) const
+		{
+			gradient = assemble_gradient(data);
+			return compute_energy(data);
+		}
+
+		// energy and gradient assembly with a kernel known at compile time, materials can pass a non-virtual call
+		// (e.g., [this](const auto &data) { return Material::compute_energy(data); }) so that it is inlined in the
+		// element loop. They are defined in Assembler.tpp, include it where they are instantiated.
+		template <typename EnergyKernel>
+		double assemble_energy_with(
+			const bool is_volume,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			EnergyKernel &&energy_kernel) const;
+
+		template <typename GradientKernel>
+		void assemble_gradient_with(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			GradientKernel &&gradient_kernel,
+			Eigen::MatrixXd &rhs) const;
+
+		// same as above, the elements of a color are assembled in parallel directly in rhs
+		template <typename GradientKernel>
+		void assemble_gradient_colored_with(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			GradientKernel &&gradient_kernel,
+			Eigen::MatrixXd &rhs) const;
+
+		// the kernel returns the energy of the element and saves its local gradient in the second argument
+		template <typename EnergyGradientKernel>
+		double assemble_energy_and_gradient_with(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			EnergyGradientKernel &&energy_gradient_kernel,
+			Eigen::MatrixXd &rhs) const;
+
+		// same as above, the elements of a color are assembled in parallel directly in rhs
+		template <typename EnergyGradientKernel>
+		double assemble_energy_and_gradient_colored_with(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			EnergyGradientKernel &&energy_gradient_kernel,
+			Eigen::MatrixXd &rhs) const;
+
+	private:
+		template <class Batch>
+		double assemble_energy_batched(
+			const bool is_volume,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev) const;
+
+		template <class Batch>
+		void assemble_gradient_batched(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			Eigen::MatrixXd &rhs) const;
+
+		bool use_batched_kernels_ = false;
+		std::shared_ptr<MaterialStateBuffer> material_state_;
 	};
 
 	class ElasticityAssembler : virtual public Assembler
@@ -340,9 +639,7 @@ namespace polyfem::assembler
 								   Eigen::MatrixXd &stresses) const
 		{
 			assign_stress_tensor(data, size() * size(), type, stresses, [&](const Eigen::MatrixXd &stress) {
-				Eigen::MatrixXd tmp = stress;
-				auto a = Eigen::Map<Eigen::MatrixXd>(tmp.data(), 1, size() * size());
-				return Eigen::MatrixXd(a);
+				return Eigen::MatrixXd(stress.reshaped(1, size() * size()));
 			});
 		}
 
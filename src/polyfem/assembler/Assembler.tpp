@@ -0,0 +1,379 @@
+#pragma once
+
+#include <polyfem/assembler/Assembler.hpp>
+#include <polyfem/utils/MaybeParallelFor.hpp>
+#include <polyfem/utils/Logger.hpp>
+#include <polyfem/utils/Timer.hpp>
+
+#include <igl/Timer.h>
+
+namespace polyfem::assembler
+{
+	namespace internal
+	{
+		// per thread buffers of the element loops
+		struct ElementScratch
+		{
+			ElementAssemblyValues vals;
+			QuadratureVector da;
+			Eigen::VectorXd gradient;
+			double energy = 0;
+		};
+	} // namespace internal
+
+	template <typename LocalKernel>
+	void LinearAssembler::assemble_with(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		StiffnessMatrix &stiffness,
+		const bool is_mass,
+		LocalKernel &&local_kernel) const
+	{
+		POLYFEM_PROFILE_SCOPE("linear assembly");
+		assert(size() > 0);
+
+		try
+		{
+			// the matrix is assembled once, only the pattern is kept and the entries are located on the fly
+			ElementScatterMap scatter_map;
+			scatter_map.init(n_basis, size(), bases, /*with_element_indices=*/false);
+
+			auto storage = utils::create_thread_storage(internal::ElementScratch());
+
+			igl::Timer timer;
+			timer.start();
+			assert(cache.is_mass() == is_mass);
+
+			const int dim = size();
+
+			// (potentially parallel) loop over elements, one color at the time
+			// elements of the same color do not share nodes, so they add directly to the values of scatter_map
+			// Note that each ElementBases object stores all local basis functions on a given element
+			const auto assemble_element = [&](const int e, const int thread_id) {
+				internal::ElementScratch &scratch = utils::get_local_thread_storage(storage, thread_id);
+
+				// compute geometric mapping
+				// evaluate and store basis functions/their gradients at quadrature points
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], scratch.vals);
+
+				const quadrature::Quadrature &quadrature = vals.quadrature;
+
+				assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
+				scratch.da = vals.det.array() * quadrature.weights.array();
+				const int n_loc_bases = int(vals.basis_values.size());
+
+				for (int i = 0; i < n_loc_bases; ++i)
+				{
+					const auto &global_i = vals.basis_values[i].global;
+
+					// loop over other bases up to the current one, taking advantage of symmetry
+					for (int j = 0; j <= i; ++j)
+					{
+						const auto &global_j = vals.basis_values[j].global;
+
+						// compute local entry in stiffness matrix
+						const auto stiffness_val = local_kernel(LinearAssemblerData(vals, t, i, j, scratch.da));
+						assert(stiffness_val.size() == dim * dim);
+
+						// loop over dimensions of the problem
+						for (int n = 0; n < dim; ++n)
+						{
+							for (int m = 0; m < dim; ++m)
+							{
+								const double local_value = stiffness_val(n * dim + m);
+
+								// loop over the global nodes corresponding to local element (useful for non-conforming cases)
+								for (size_t ii = 0; ii < global_i.size(); ++ii)
+								{
+									const auto gi = global_i[ii].index * dim + m;
+									const auto wi = global_i[ii].val;
+
+									for (size_t jj = 0; jj < global_j.size(); ++jj)
+									{
+										const auto gj = global_j[jj].index * dim + n;
+										const auto wj = global_j[jj].val;
+
+										// add local value to the global matrix (weighted by corresponding nodes)
+										scatter_map.add_value(scatter_map.find(gi, gj), local_value * wi * wj);
+										if (j < i)
+											scatter_map.add_value(scatter_map.find(gj, gi), local_value * wj * wi);
+									}
+								}
+							}
+						}
+					}
+				}
+			};
+
+			{
+				POLYFEM_PROFILE_SCOPE("local assembly");
+				scatter_map.element_coloring().maybe_parallel_for(assemble_element);
+			}
+
+			timer.stop();
+			logger().trace("done colored assembly {}s...", timer.getElapsedTime());
+
+			scatter_map.get_matrix(stiffness);
+		}
+		catch (std::bad_alloc &ba)
+		{
+			log_and_throw_error("bad alloc {}", ba.what());
+		}
+	}
+
+	template <typename EnergyKernel>
+	double NLAssembler::assemble_energy_with(
+		const bool is_volume,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		EnergyKernel &&energy_kernel) const
+	{
+		POLYFEM_PROFILE_SCOPE("energy assembly");
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		return utils::parallel_reduce_sum(
+			int(bases.size()), internal::ElementScratch(),
+			[&](const int e, internal::ElementScratch &scratch) {
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], scratch.vals);
+
+				const quadrature::Quadrature &quadrature = vals.quadrature;
+
+				assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
+				scratch.da = vals.det.array() * quadrature.weights.array();
+
+				return energy_kernel(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, scratch.da, material_state));
+			});
+	}
+
+	template <typename GradientKernel>
+	void NLAssembler::assemble_gradient_with(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		GradientKernel &&gradient_kernel,
+		Eigen::MatrixXd &rhs) const
+	{
+		POLYFEM_PROFILE_SCOPE("gradient assembly");
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		const int dim = size();
+
+		utils::parallel_reduce_vector(
+			int(bases.size()), n_basis * dim, internal::ElementScratch(),
+			[&](const int e, internal::ElementScratch &scratch, Eigen::MatrixXd &vec) {
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], scratch.vals);
+
+				const quadrature::Quadrature &quadrature = vals.quadrature;
+
+				assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
+				scratch.da = vals.det.array() * quadrature.weights.array();
+				const int n_loc_bases = int(vals.basis_values.size());
+
+				const auto val = gradient_kernel(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, scratch.da, material_state));
+				assert(val.size() == n_loc_bases * dim);
+
+				for (int j = 0; j < n_loc_bases; ++j)
+				{
+					const auto &global_j = vals.basis_values[j].global;
+
+					for (int m = 0; m < dim; ++m)
+					{
+						const double local_value = val(j * dim + m);
+
+						for (size_t jj = 0; jj < global_j.size(); ++jj)
+							vec(global_j[jj].index * dim + m) += local_value * global_j[jj].val;
+					}
+				}
+			},
+			rhs);
+	}
+
+	template <typename GradientKernel>
+	void NLAssembler::assemble_gradient_colored_with(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		const utils::ElementColoring &coloring,
+		GradientKernel &&gradient_kernel,
+		Eigen::MatrixXd &rhs) const
+	{
+		POLYFEM_PROFILE_SCOPE("gradient assembly");
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		assert(coloring.n_elements() == bases.size());
+
+		const int dim = size();
+
+		rhs.resize(n_basis * dim, 1);
+		rhs.setZero();
+
+		// only the assembly values are thread local, the elements of a color never share a global node
+		auto storage = utils::create_thread_storage(internal::ElementScratch());
+
+		coloring.maybe_parallel_for([&](int e, int thread_id) {
+			internal::ElementScratch &scratch = utils::get_local_thread_storage(storage, thread_id);
+
+			const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], scratch.vals);
+
+			const quadrature::Quadrature &quadrature = vals.quadrature;
+
+			assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
+			scratch.da = vals.det.array() * quadrature.weights.array();
+			const int n_loc_bases = int(vals.basis_values.size());
+
+			const auto val = gradient_kernel(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, scratch.da, material_state));
+			assert(val.size() == n_loc_bases * dim);
+
+			for (int j = 0; j < n_loc_bases; ++j)
+			{
+				const auto &global_j = vals.basis_values[j].global;
+
+				for (int m = 0; m < dim; ++m)
+				{
+					const double local_value = val(j * dim + m);
+
+					for (size_t jj = 0; jj < global_j.size(); ++jj)
+						rhs(global_j[jj].index * dim + m) += local_value * global_j[jj].val;
+				}
+			}
+		});
+	}
+
+	template <typename EnergyGradientKernel>
+	double NLAssembler::assemble_energy_and_gradient_with(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		EnergyGradientKernel &&energy_gradient_kernel,
+		Eigen::MatrixXd &rhs) const
+	{
+		POLYFEM_PROFILE_SCOPE("energy and gradient assembly");
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		const int dim = size();
+		const int n_dofs = n_basis * dim;
+
+		// the energy is reduced together with the gradient, in the extra last entry
+		Eigen::MatrixXd res;
+		utils::parallel_reduce_vector(
+			int(bases.size()), n_dofs + 1, internal::ElementScratch(),
+			[&](const int e, internal::ElementScratch &scratch, Eigen::MatrixXd &vec) {
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], scratch.vals);
+
+				const quadrature::Quadrature &quadrature = vals.quadrature;
+
+				assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
+				scratch.da = vals.det.array() * quadrature.weights.array();
+				const int n_loc_bases = int(vals.basis_values.size());
+
+				vec(n_dofs) += energy_gradient_kernel(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, scratch.da, material_state), scratch.gradient);
+				assert(scratch.gradient.size() == n_loc_bases * dim);
+
+				for (int j = 0; j < n_loc_bases; ++j)
+				{
+					const auto &global_j = vals.basis_values[j].global;
+
+					for (int m = 0; m < dim; ++m)
+					{
+						const double local_value = scratch.gradient(j * dim + m);
+
+						for (size_t jj = 0; jj < global_j.size(); ++jj)
+							vec(global_j[jj].index * dim + m) += local_value * global_j[jj].val;
+					}
+				}
+			},
+			res);
+
+		rhs = res.topRows(n_dofs);
+		return res(n_dofs);
+	}
+
+	template <typename EnergyGradientKernel>
+	double NLAssembler::assemble_energy_and_gradient_colored_with(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		const utils::ElementColoring &coloring,
+		EnergyGradientKernel &&energy_gradient_kernel,
+		Eigen::MatrixXd &rhs) const
+	{
+		POLYFEM_PROFILE_SCOPE("energy and gradient assembly");
+		const MaterialStateBuffer *material_state = valid_material_state(t, displacement);
+
+		assert(coloring.n_elements() == bases.size());
+
+		const int dim = size();
+
+		rhs.resize(n_basis * dim, 1);
+		rhs.setZero();
+
+		// the gradient is shared, only the energy is reduced over the threads
+		auto storage = utils::create_thread_storage(internal::ElementScratch());
+
+		coloring.maybe_parallel_for([&](int e, int thread_id) {
+			internal::ElementScratch &scratch = utils::get_local_thread_storage(storage, thread_id);
+
+			const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], scratch.vals);
+
+			const quadrature::Quadrature &quadrature = vals.quadrature;
+
+			assert(MAX_QUAD_POINTS == -1 || quadrature.weights.size() < MAX_QUAD_POINTS);
+			scratch.da = vals.det.array() * quadrature.weights.array();
+			const int n_loc_bases = int(vals.basis_values.size());
+
+			scratch.energy += energy_gradient_kernel(NonLinearAssemblerData(vals, t, dt, displacement, displacement_prev, scratch.da, material_state), scratch.gradient);
+			assert(scratch.gradient.size() == n_loc_bases * dim);
+
+			for (int j = 0; j < n_loc_bases; ++j)
+			{
+				const auto &global_j = vals.basis_values[j].global;
+
+				for (int m = 0; m < dim; ++m)
+				{
+					const double local_value = scratch.gradient(j * dim + m);
+
+					for (size_t jj = 0; jj < global_j.size(); ++jj)
+						rhs(global_j[jj].index * dim + m) += local_value * global_j[jj].val;
+				}
+			}
+		});
+
+		double energy = 0;
+		for (const internal::ElementScratch &scratch : storage)
+			energy += scratch.energy;
+		return energy;
+	}
+} // namespace polyfem::assembler
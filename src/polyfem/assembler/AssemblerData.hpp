@@ -4,6 +4,8 @@
 
 namespace polyfem::assembler
 {
+	class MaterialStateBuffer;
+
 	class NonLinearAssemblerData
 	{
 	public:
@@ -13,8 +15,9 @@ namespace polyfem::assembler
 			const double dt,
 			const Eigen::MatrixXd &x,
 			const Eigen::MatrixXd &x_prev,
-			const QuadratureVector &da)
-			: vals(vals), t(t), dt(dt), x(x), x_prev(x_prev), da(da)
+			const QuadratureVector &da,
+			const MaterialStateBuffer *material_state = nullptr)
+			: vals(vals), t(t), dt(dt), x(x), x_prev(x_prev), da(da), material_state(material_state)
 		{
 		}
 
@@ -24,6 +27,8 @@ namespace polyfem::assembler
 		const Eigen::MatrixXd &x;
 		const Eigen::MatrixXd &x_prev;
 		const QuadratureVector &da;
+		/// state of x at the quadrature points of the element (vals.element_id), nullptr if not available
+		const MaterialStateBuffer *material_state;
 	};
 
 	class LinearAssemblerData
@@ -214,5 +214,20 @@ namespace polyfem
 			}
 		}
 
+		std::vector<std::vector<int>> AssemblerUtils::element_global_nodes(const std::vector<basis::ElementBases> &bases)
+		{
+			std::vector<std::vector<int>> element_nodes(bases.size());
+			for (size_t e = 0; e < bases.size(); ++e)
+			{
+				for (const basis::Basis &b : bases[e].bases)
+				{
+					for (const auto &g : b.global())
+						element_nodes[e].push_back(g.index);
+				}
+			}
+
+			return element_nodes;
+		}
+
 	} // namespace assembler
 } // namespace polyfem
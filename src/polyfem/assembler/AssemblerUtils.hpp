@@ -36,5 +36,8 @@ namespace polyfem::assembler
 		
 		/// utility for retrieving the needed quadrature order to precisely integrate the given form on the given element basis
 		static int quadrature_order(const std::string &assembler, const int basis_degree, const BasisType &b_type, const int dim);
+
+		/// utility to list the global nodes touched by every element, used to color the elements
+		static std::vector<std::vector<int>> element_global_nodes(const std::vector<basis::ElementBases> &bases);
 	};
 } // namespace polyfem::assembler
@@ -1,5 +1,6 @@
 #include "AssemblyValsCache.hpp"
 
+#include <polyfem/utils/Logger.hpp>
 #include <polyfem/utils/MaybeParallelFor.hpp>
 
 namespace polyfem
@@ -8,9 +9,14 @@ namespace polyfem
 
 	namespace assembler
 	{
-		void AssemblyValsCache::init(const bool is_volume, const std::vector<ElementBases> &bases, const std::vector<ElementBases> &gbases, const bool is_mass)
+		void AssemblyValsCache::init(const bool is_volume, const std::vector<ElementBases> &bases, const std::vector<ElementBases> &gbases, const bool is_mass, const bool use_reference_tables)
 		{
+			clear();
 			is_mass_ = is_mass;
+
+			if (use_reference_tables && init_reference_tables(is_volume, bases, gbases))
+				return;
+
 			const int n_bases = bases.size();
 			cache.resize(n_bases);
 
@@ -30,9 +36,127 @@ namespace polyfem
 			});
 		}
 
+		bool AssemblyValsCache::init_reference_tables(const bool is_volume, const std::vector<ElementBases> &bases, const std::vector<ElementBases> &gbases)
+		{
+			const int n_elements = bases.size();
+			if (n_elements == 0)
+				return false;
+
+			for (int e = 0; e < n_elements; ++e)
+			{
+				if (bases[e].reference_key < 0 || !bases[e].has_parameterization || !gbases[e].has_parameterization)
+					return false;
+			}
+
+			dim_ = is_volume ? 3 : 2;
+			element_table_.resize(n_elements);
+			offsets_.resize(n_elements + 1);
+			offsets_[0] = 0;
+
+			// find the reference table of every element, there are only a few of them
+			quadrature::Quadrature quadrature;
+			for (int e = 0; e < n_elements; ++e)
+			{
+				if (is_mass_)
+					bases[e].compute_mass_quadrature(quadrature);
+				else
+					bases[e].compute_quadrature(quadrature);
+
+				int table = -1;
+				for (int t = 0; t < tables_.size(); ++t)
+				{
+					const ReferenceTable &other = tables_[t];
+					if (other.reference_key == bases[e].reference_key
+						&& other.quadrature.points.rows() == quadrature.points.rows()
+						&& other.quadrature.points == quadrature.points
+						&& other.quadrature.weights == quadrature.weights)
+					{
+						table = t;
+						break;
+					}
+				}
+
+				if (table < 0)
+				{
+					table = tables_.size();
+					tables_.emplace_back();
+					ReferenceTable &new_table = tables_.back();
+					new_table.reference_key = bases[e].reference_key;
+					new_table.quadrature = quadrature;
+					bases[e].evaluate_bases(quadrature.points, new_table.basis_values);
+					bases[e].evaluate_grads(quadrature.points, new_table.basis_values);
+				}
+
+				element_table_[e] = table;
+				offsets_[e + 1] = offsets_[e] + quadrature.points.rows();
+			}
+
+			points_.resize(offsets_.back(), dim_);
+			jac_it_.resize(dim_ * dim_, offsets_.back());
+			det_.resize(offsets_.back());
+
+			// only the geometric mapping is stored per element, computing the values of the
+			// geometric bases alone gives it without evaluating the (higher order) bases
+			auto storage = utils::create_thread_storage(ElementAssemblyValues());
+			utils::maybe_parallel_for(n_elements, [&](int start, int end, int thread_id) {
+				ElementAssemblyValues &vals = utils::get_local_thread_storage(storage, thread_id);
+
+				for (int e = start; e < end; ++e)
+				{
+					const ReferenceTable &table = tables_[element_table_[e]];
+					vals.compute(e, is_volume, table.quadrature.points, gbases[e], gbases[e]);
+
+					const int n_pts = offsets_[e + 1] - offsets_[e];
+					points_.middleRows(offsets_[e], n_pts) = vals.val;
+					det_.segment(offsets_[e], n_pts) = vals.det;
+					for (int k = 0; k < n_pts; ++k)
+						jac_it_.col(offsets_[e] + k) = Eigen::Map<const Eigen::VectorXd>(vals.jac_it[k].data(), dim_ * dim_);
+				}
+			});
+
+			logger().debug("Assembly cache with {} reference tables for {} elements", tables_.size(), n_elements);
+
+			return true;
+		}
+
+		void AssemblyValsCache::map_reference_values(const int el_index, const ElementBases &basis, ElementAssemblyValues &vals) const
+		{
+			assert(el_index < element_table_.size());
+			const ReferenceTable &table = tables_[element_table_[el_index]];
+			const int offset = offsets_[el_index];
+			const int n_pts = offsets_[el_index + 1] - offset;
+			assert(basis.bases.size() == table.basis_values.size());
+
+			vals.element_id = el_index;
+			vals.has_parameterization = true;
+			vals.quadrature = table.quadrature;
+			vals.val = points_.middleRows(offset, n_pts);
+			vals.det = det_.segment(offset, n_pts);
+
+			vals.jac_it.resize(n_pts);
+			for (int k = 0; k < n_pts; ++k)
+				vals.jac_it[k] = Eigen::Map<const Eigen::MatrixXd>(jac_it_.col(offset + k).data(), dim_, dim_);
+
+			vals.basis_values.resize(table.basis_values.size());
+			for (size_t j = 0; j < table.basis_values.size(); ++j)
+			{
+				const AssemblyValues &ref = table.basis_values[j];
+				AssemblyValues &ass_val = vals.basis_values[j];
+
+				ass_val.global = basis.bases[j].global();
+				ass_val.val = ref.val;
+				ass_val.grad = ref.grad;
+				ass_val.finalize();
+				for (int k = 0; k < n_pts; ++k)
+					ass_val.grad_t_m.row(k) = ref.grad.row(k) * vals.jac_it[k];
+			}
+		}
+
 		void AssemblyValsCache::compute(const int el_index, const bool is_volume, const ElementBases &basis, const ElementBases &gbasis, ElementAssemblyValues &vals) const
 		{
-			if (cache.empty())
+			if (uses_reference_tables())
+				map_reference_values(el_index, basis, vals);
+			else if (cache.empty())
 			{
 				if (is_mass_)
 				{
@@ -46,6 +170,18 @@ namespace polyfem
 			else
 				vals = cache[el_index];
 		}
+
+		const ElementAssemblyValues &AssemblyValsCache::get(const int el_index, const bool is_volume, const ElementBases &basis, const ElementBases &gbasis, ElementAssemblyValues &tmp) const
+		{
+			if (uses_reference_tables() || cache.empty())
+			{
+				compute(el_index, is_volume, basis, gbasis, tmp);
+				return tmp;
+			}
+
+			assert(el_index < cache.size());
+			return cache[el_index];
+		}
 	} // namespace assembler
 
 } // namespace polyfem
@@ -6,29 +6,65 @@ namespace polyfem
 {
 	namespace assembler
 	{
-		/// Caches basis evaluation and geometric mapping at every element
+		/// Caches basis evaluation and geometric mapping at every element.
+		/// With reference tables and Lagrange bases on every element (ElementBases::reference_key), the basis values
+		/// and gradients on the reference element are stored once per (element type, order, quadrature) and every
+		/// element only stores its geometric mapping (quadrature points, inverse transpose Jacobian and determinant).
+		/// The physical gradients are then mapped every time the element is retrieved, so the tables are meant for
+		/// meshes whose full cache does not fit in memory.
 		class AssemblyValsCache
 		{
 		public:
 			/// computes the basis evaluation and geometric mapping
 			/// for each of the given ElementBases in bases
 			/// initializes cache member
-			void init(const bool is_volume, const std::vector<basis::ElementBases> &bases, const std::vector<basis::ElementBases> &gbases, const bool is_mass = false);
+			/// @param[in] use_reference_tables share the reference evaluations between elements when possible
+			void init(const bool is_volume, const std::vector<basis::ElementBases> &bases, const std::vector<basis::ElementBases> &gbases, const bool is_mass = false, const bool use_reference_tables = false);
 
 			/// retrieves cached basis evaluation and geometric for the given element
 			/// if it doesn't exist, computes and caches it (modifies cache member in the latter case)
 			void compute(const int el_index, const bool is_volume, const basis::ElementBases &basis, const basis::ElementBases &gbasis, ElementAssemblyValues &vals) const;
 
+			/// retrieves cached basis evaluation and geometric mapping for the given element without copying them
+			/// if the cache is empty, computes them in tmp and returns a reference to it
+			/// if the cache uses reference tables, maps the reference values of the element in tmp and returns a reference to it
+			const ElementAssemblyValues &get(const int el_index, const bool is_volume, const basis::ElementBases &basis, const basis::ElementBases &gbasis, ElementAssemblyValues &tmp) const;
+
 			void clear()
 			{
 				cache.clear();
+				tables_.clear();
+				element_table_.clear();
+				offsets_.clear();
 			}
 
 			inline bool is_mass() const { return is_mass_; }
 
+			/// true if the cache stores the reference tables and the per element geometric mapping
+			inline bool uses_reference_tables() const { return !tables_.empty(); }
+
 		private:
+			/// basis values and gradients on the reference element, shared by all elements with the same bases and quadrature
+			struct ReferenceTable
+			{
+				int reference_key;
+				quadrature::Quadrature quadrature;
+				std::vector<AssemblyValues> basis_values;
+			};
+
+			bool init_reference_tables(const bool is_volume, const std::vector<basis::ElementBases> &bases, const std::vector<basis::ElementBases> &gbases);
+			void map_reference_values(const int el_index, const basis::ElementBases &basis, ElementAssemblyValues &vals) const;
+
 			std::vector<ElementAssemblyValues> cache; ///< vector of basis values and geometric mapping with one entry per element
 			bool is_mass_;
+
+			int dim_ = 0;
+			std::vector<ReferenceTable> tables_;
+			std::vector<int> element_table_; ///< reference table of every element
+			std::vector<int> offsets_;       ///< first quadrature point of every element in the flat arrays below
+			Eigen::MatrixXd points_;         ///< quadrature points mapped to the elements, one row per point
+			Eigen::MatrixXd jac_it_;         ///< inverse transpose Jacobian (column major) of every point
+			Eigen::VectorXd det_;            ///< determinant of the Jacobian of every point
 		};
 	} // namespace assembler
 } // namespace polyfem
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <polyfem/assembler/ElementAssemblyValues.hpp>
+
+#include <Eigen/Dense>
+
+#include <array>
+
+namespace polyfem::assembler
+{
+	/// Structure-of-arrays storage of LANES quadrature points of elements with the same
+	/// number of local bases (e.g., P1 triangles or tets). Each lane is one (element, quadrature point)
+	/// pair, all quantities are stored as fixed-size arrays over the lanes so that the batched
+	/// material kernels vectorize across elements. Unused lanes have zero weight and zero displacement.
+	template <int DIM, int N_BASIS, int LANES = 8>
+	class ElementBatch
+	{
+	public:
+		static constexpr int dim = DIM;
+		static constexpr int n_basis = N_BASIS;
+		static constexpr int lanes = LANES;
+		static constexpr int max_params = 2;
+
+		using Lane = Eigen::Array<double, LANES, 1>;
+		/// one lane array per local degree of freedom, indexed by i * DIM + d
+		using LaneDofs = std::array<Lane, N_BASIS * DIM>;
+
+		ElementBatch() { clear(); }
+
+		/// true if vals can be stored in this batch
+		static bool is_compatible(const ElementAssemblyValues &vals)
+		{
+			return vals.basis_values.size() == N_BASIS && (vals.basis_values.empty() || vals.basis_values[0].grad_t_m.cols() == DIM);
+		}
+
+		void clear()
+		{
+			n_active_ = 0;
+			for (int k = 0; k < N_BASIS * DIM; ++k)
+			{
+				grad[k].setZero();
+				disp[k].setZero();
+			}
+			da.setZero();
+			for (auto &p : params)
+				p.setOnes();
+			element.fill(-1);
+		}
+
+		int size() const { return n_active_; }
+		bool empty() const { return n_active_ == 0; }
+		bool full() const { return n_active_ == LANES; }
+
+		/// adds quadrature point p of the element vals, the local displacement is gathered from the global one
+		/// @param[in] vals assembly values of the element
+		/// @param[in] p quadrature point
+		/// @param[in] displacement global displacement
+		/// @param[in] w quadrature weight times jacobian determinant
+		/// @param[in] material_params material parameters of the element, one row per quadrature point
+		void push(const ElementAssemblyValues &vals, const int p, const Eigen::MatrixXd &displacement,
+				  const double w, const Eigen::MatrixXd &material_params)
+		{
+			assert(!full());
+			assert(is_compatible(vals));
+			assert(material_params.cols() <= max_params);
+
+			const int k = n_active_++;
+			for (int i = 0; i < N_BASIS; ++i)
+			{
+				const auto &bs = vals.basis_values[i];
+				for (int d = 0; d < DIM; ++d)
+				{
+					grad[i * DIM + d](k) = bs.grad_t_m(p, d);
+
+					double u = 0;
+					for (const auto &g : bs.global)
+						u += g.val * displacement(g.index * DIM + d);
+					disp[i * DIM + d](k) = u;
+				}
+			}
+
+			da(k) = w;
+			for (int j = 0; j < material_params.cols(); ++j)
+				params[j](k) = material_params(p, j);
+			element[k] = vals.element_id;
+		}
+
+		/// physical gradient of the local bases
+		LaneDofs grad;
+		/// local displacement
+		LaneDofs disp;
+		/// quadrature weight times jacobian determinant
+		Lane da;
+		/// material parameters, their meaning is defined by the material (e.g., lambda and mu)
+		std::array<Lane, max_params> params;
+		/// element of every lane
+		std::array<int, LANES> element;
+
+	private:
+		int n_active_;
+	};
+
+	using TriangleBatch = ElementBatch<2, 3>;
+	using TetBatch = ElementBatch<3, 4>;
+} // namespace polyfem::assembler
@@ -0,0 +1,166 @@
+#include "ElementScatterMap.hpp"
+
+#include <polyfem/assembler/AssemblerUtils.hpp>
+#include <polyfem/utils/Logger.hpp>
+#include <polyfem/utils/MaybeParallelFor.hpp>
+
+#include <igl/Timer.h>
+
+#include <algorithm>
+
+namespace polyfem::assembler
+{
+	using namespace basis;
+	using namespace utils;
+
+	void ElementScatterMap::init(const int n_basis, const int size, const std::vector<ElementBases> &bases, const bool with_element_indices)
+	{
+		igl::Timer timer;
+		timer.start();
+
+		bases_ = &bases;
+		n_elements_ = bases.size();
+		n_basis_ = n_basis;
+		size_ = size;
+		has_element_indices_ = with_element_indices;
+		own_coloring_.clear();
+
+		const int n_elements = int(bases.size());
+		const int n_dofs = n_basis * size;
+
+		// number of entries of every element, the same count as the loop in NLAssembler::assemble_hessian
+		element_offsets_.resize(n_elements + 1);
+		element_offsets_[0] = 0;
+		for (int e = 0; e < n_elements; ++e)
+		{
+			size_t n_globals = 0;
+			for (const Basis &b : bases[e].bases)
+				n_globals += b.global().size();
+			element_offsets_[e + 1] = element_offsets_[e] + n_globals * n_globals * size * size;
+		}
+
+		// rows of every column
+		std::vector<std::vector<StorageIndex>> col_rows(n_dofs);
+		for (int e = 0; e < n_elements; ++e)
+		{
+			const std::vector<Basis> &local_bases = bases[e].bases;
+			for (const Basis &bi : local_bases)
+			{
+				for (const Basis &bj : local_bases)
+				{
+					for (int n = 0; n < size; ++n)
+					{
+						for (int m = 0; m < size; ++m)
+						{
+							for (const auto &gi : bi.global())
+							{
+								for (const auto &gj : bj.global())
+									col_rows[gj.index * size + n].push_back(gi.index * size + m);
+							}
+						}
+					}
+				}
+			}
+		}
+
+		maybe_parallel_for(n_dofs, [&](int start, int end, int thread_id) {
+			for (int c = start; c < end; ++c)
+			{
+				std::vector<StorageIndex> &rows = col_rows[c];
+				std::sort(rows.begin(), rows.end());
+				rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+			}
+		});
+
+		pattern_.resize(n_dofs, n_dofs);
+		Eigen::VectorXi col_sizes(n_dofs);
+		for (int c = 0; c < n_dofs; ++c)
+			col_sizes[c] = col_rows[c].size();
+		pattern_.reserve(col_sizes);
+		for (int c = 0; c < n_dofs; ++c)
+		{
+			for (const StorageIndex r : col_rows[c])
+				pattern_.insert(r, c) = 0;
+			std::vector<StorageIndex>().swap(col_rows[c]);
+		}
+		pattern_.makeCompressed();
+
+		// position of every element entry in the compressed values
+		if (with_element_indices)
+		{
+			indices_.resize(element_offsets_.back());
+
+			maybe_parallel_for(n_elements, [&](int start, int end, int thread_id) {
+				for (int e = start; e < end; ++e)
+				{
+					const std::vector<Basis> &local_bases = bases[e].bases;
+					StorageIndex *out = indices_.data() + element_offsets_[e];
+
+					for (const Basis &bi : local_bases)
+					{
+						for (const Basis &bj : local_bases)
+						{
+							for (int n = 0; n < size; ++n)
+							{
+								for (int m = 0; m < size; ++m)
+								{
+									for (const auto &gi : bi.global())
+									{
+										const StorageIndex row = gi.index * size + m;
+										for (const auto &gj : bj.global())
+										{
+											const StorageIndex col = gj.index * size + n;
+											*(out++) = find(row, col);
+										}
+									}
+								}
+							}
+						}
+					}
+					assert(out == indices_.data() + element_offsets_[e + 1]);
+				}
+			});
+		}
+		else
+			std::vector<StorageIndex>().swap(indices_);
+
+		values_.resize(pattern_.nonZeros());
+		set_zero();
+
+		timer.stop();
+		logger().debug("built element scatter map with {} non zeros and {} element entries ({} MB) in {}s", pattern_.nonZeros(), indices_.size(), memory_size() / (1024. * 1024.), timer.getElapsedTime());
+	}
+
+	void ElementScatterMap::set_zero()
+	{
+		std::fill(values_.begin(), values_.end(), 0.);
+	}
+
+	const ElementColoring &ElementScatterMap::element_coloring()
+	{
+		if (coloring_ != nullptr)
+			return *coloring_;
+
+		if (own_coloring_.empty())
+		{
+			assert(bases_ != nullptr);
+			own_coloring_.init(AssemblerUtils::element_global_nodes(*bases_), n_basis_);
+		}
+		return own_coloring_;
+	}
+
+	size_t ElementScatterMap::memory_size() const
+	{
+		return pattern_.nonZeros() * (sizeof(double) + sizeof(StorageIndex))
+			   + (pattern_.outerSize() + 1) * sizeof(StorageIndex)
+			   + element_offsets_.size() * sizeof(size_t)
+			   + indices_.size() * sizeof(StorageIndex)
+			   + values_.size() * sizeof(double);
+	}
+
+	void ElementScatterMap::get_matrix(StiffnessMatrix &mat) const
+	{
+		mat = pattern_;
+		std::copy(values_.begin(), values_.end(), mat.valuePtr());
+	}
+} // namespace polyfem::assembler
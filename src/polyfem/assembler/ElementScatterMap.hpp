@@ -0,0 +1,92 @@
+#pragma once
+
+#include <polyfem/basis/ElementBases.hpp>
+#include <polyfem/utils/Types.hpp>
+#include <polyfem/utils/ElementColoring.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+namespace polyfem::assembler
+{
+	/// Precomputed map from the local element matrices to the values of a global sparse matrix with fixed pattern.
+	/// The entries of every element are stored in the same order as the assembly loop
+	/// (local basis i, local basis j, dimension n, dimension m, global node of i, global node of j),
+	/// so the assemblers can add the element contributions directly into the final values, without triplets.
+	/// The elements are scattered one color at the time, so every non zero is accumulated in the same order
+	/// independently of the number of threads and the result is bitwise reproducible.
+	/// The scatter indices take one StorageIndex per element entry (see memory_size), about the size of the triplets
+	/// of one assembly, but they are built once and reused by every assembly with the same bases.
+	class ElementScatterMap
+	{
+	public:
+		typedef StiffnessMatrix::StorageIndex StorageIndex;
+
+		/// builds the sparsity pattern and the scatter indices for the given bases
+		/// the matrix has size (n_basis * size) x (n_basis * size)
+		/// if with_element_indices is false only the pattern is built and the entries are located with find
+		void init(const int n_basis, const int size, const std::vector<basis::ElementBases> &bases, const bool with_element_indices = true);
+
+		/// checks if the map was built for these bases
+		/// the bases are compared by address, the map must be re-initialized if they are rebuilt
+		bool is_valid_for(const int n_basis, const int size, const std::vector<basis::ElementBases> &bases) const
+		{
+			return bases_ == &bases && n_elements_ == bases.size() && n_basis_ == n_basis && size_ == size;
+		}
+
+		/// true if the map was built with the scatter indices of every element
+		inline bool has_element_indices() const { return has_element_indices_; }
+
+		/// sets all the values to zero, to be called before adding element contributions
+		void set_zero();
+
+		/// position of the entry (row, col) in the values, the entry must be in the pattern
+		inline StorageIndex find(const StorageIndex row, const StorageIndex col) const
+		{
+			const StorageIndex *inner = pattern_.innerIndexPtr();
+			const StorageIndex *outer = pattern_.outerIndexPtr();
+			const StorageIndex *it = std::lower_bound(inner + outer[col], inner + outer[col + 1], row);
+			assert(it != inner + outer[col + 1] && *it == row);
+			return StorageIndex(it - inner);
+		}
+
+		/// scatter indices of the element e, in assembly order, only available if built with the element indices
+		inline const StorageIndex *element_indices(const int e) const { return indices_.data() + element_offsets_[e]; }
+		/// number of scatter indices of the element e
+		inline size_t n_element_entries(const int e) const { return element_offsets_[e + 1] - element_offsets_[e]; }
+
+		/// adds value to the k-th non zero, no other thread must write the same non zero concurrently
+		/// (i.e., the elements are assembled one color at the time)
+		inline void add_value(const StorageIndex k, const double value) { values_[k] += value; }
+
+		/// sets the element coloring used to scatter the elements, it must be computed from the same bases
+		/// if none is set, the map colors the elements itself
+		inline void set_element_coloring(const utils::ElementColoring *coloring) { coloring_ = coloring; }
+		/// coloring used to scatter the elements, either the one set or the own one (built on the first call)
+		const utils::ElementColoring &element_coloring();
+
+		/// writes the accumulated values in mat, mat gets the pattern of the map
+		void get_matrix(StiffnessMatrix &mat) const;
+
+		inline size_t non_zeros() const { return pattern_.nonZeros(); }
+		inline const StiffnessMatrix &pattern() const { return pattern_; }
+		/// bytes used by the pattern, the scatter indices, and the values
+		size_t memory_size() const;
+
+	private:
+		const std::vector<basis::ElementBases> *bases_ = nullptr;
+		size_t n_elements_ = 0;
+		int n_basis_ = 0;
+		int size_ = 0;
+		bool has_element_indices_ = false;
+
+		StiffnessMatrix pattern_;                            ///< compressed sparsity pattern, all values are zero
+		std::vector<size_t> element_offsets_;                ///< start of every element in indices_
+		std::vector<StorageIndex> indices_;                  ///< position in the values of the pattern of every element entry
+		std::vector<double> values_;                         ///< accumulated values, one per non zero of the pattern
+
+		const utils::ElementColoring *coloring_ = nullptr; ///< optional element coloring, not owned
+		utils::ElementColoring own_coloring_;              ///< coloring used when none is set
+	};
+} // namespace polyfem::assembler
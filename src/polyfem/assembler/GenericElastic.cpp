@@ -1,5 +1,7 @@
 #include "GenericElastic.hpp"
 
+#include <polyfem/assembler/Assembler.tpp>
+
 #include <polyfem/assembler/MooneyRivlinElasticity.hpp>
 #include <polyfem/assembler/MooneyRivlin3ParamElasticity.hpp>
 #include <polyfem/assembler/OgdenElasticity.hpp>
@@ -83,6 +85,70 @@ namespace polyfem::assembler
 		}
 	}
 
+	template <typename Derived>
+	double GenericElastic<Derived>::assemble_energy(
+		const bool is_volume,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev) const
+	{
+		if (use_batched_kernels())
+			return NLAssembler::assemble_energy(is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev);
+
+		return assemble_energy_with(
+			is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev,
+			[this](const NonLinearAssemblerData &data) { return GenericElastic<Derived>::compute_energy(data); });
+	}
+
+	template <typename Derived>
+	void GenericElastic<Derived>::assemble_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		Eigen::MatrixXd &rhs) const
+	{
+		if (use_batched_kernels())
+			return NLAssembler::assemble_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+
+		assemble_gradient_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev,
+			[this](const NonLinearAssemblerData &data) { return GenericElastic<Derived>::assemble_gradient(data); },
+			rhs);
+	}
+
+	template <typename Derived>
+	void GenericElastic<Derived>::assemble_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		const utils::ElementColoring &coloring,
+		Eigen::MatrixXd &rhs) const
+	{
+		if (use_batched_kernels())
+			return NLAssembler::assemble_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring, rhs);
+
+		assemble_gradient_colored_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring,
+			[this](const NonLinearAssemblerData &data) { return GenericElastic<Derived>::assemble_gradient(data); },
+			rhs);
+	}
+
 	template <typename Derived>
 	double GenericElastic<Derived>::compute_energy(const NonLinearAssemblerData &data) const
 	{
@@ -3,6 +3,8 @@
 #include <polyfem/assembler/Assembler.hpp>
 #include <polyfem/utils/ElasticityUtils.hpp>
 
+#include <type_traits>
+
 // non linear NeoHookean material model
 namespace polyfem::assembler
 {
@@ -17,6 +19,42 @@ namespace polyfem::assembler
 		using NLAssembler::assemble_gradient;
 		using NLAssembler::assemble_hessian;
 
+		// energy and gradient assembly calling the element kernels below without virtual dispatch
+		double assemble_energy(
+			const bool is_volume,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev) const override;
+
+		void assemble_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			Eigen::MatrixXd &rhs) const override;
+
+		void assemble_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			Eigen::MatrixXd &rhs) const override;
+
 		GenericElastic();
 		virtual ~GenericElastic() = default;
 
@@ -58,11 +96,27 @@ namespace polyfem::assembler
 		template <typename T>
 		T compute_energy_aux(const NonLinearAssemblerData &data) const
 		{
-			typedef Eigen::Matrix<T, Eigen::Dynamic, 1> AutoDiffVect;
-			typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3> AutoDiffGradMat;
+			if constexpr (std::is_same_v<T, double>)
+			{
+				// no autodiff scalars, the displacement is gathered in the arena
+				utils::ElementArena &arena = utils::ElementArena::thread_local_arena();
+				const utils::ElementArena::Scope scope(arena);
+				utils::ElementArena::VectorMap local_disp = arena.vector(int(data.vals.basis_values.size()) * size());
+				gather_local_disp(data, size(), local_disp);
+				return compute_energy_from_local_disp<T>(data, local_disp);
+			}
+			else
+			{
+				Eigen::Matrix<T, Eigen::Dynamic, 1> local_disp;
+				get_local_disp(data, size(), local_disp);
+				return compute_energy_from_local_disp<T>(data, local_disp);
+			}
+		}
 
-			AutoDiffVect local_disp;
-			get_local_disp(data, size(), local_disp);
+		template <typename T, typename LocalDisp>
+		T compute_energy_from_local_disp(const NonLinearAssemblerData &data, const LocalDisp &local_disp) const
+		{
+			typedef Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3> AutoDiffGradMat;
 
 			AutoDiffGradMat def_grad(size(), size());
 
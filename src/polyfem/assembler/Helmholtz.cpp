@@ -1,4 +1,5 @@
 #include "Helmholtz.hpp"
+#include <polyfem/assembler/Assembler.tpp>
 #include <polyfem/utils/Bessel.hpp>
 
 namespace polyfem::assembler
@@ -8,6 +9,21 @@ namespace polyfem::assembler
 	{
 	}
 
+	void Helmholtz::assemble(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		StiffnessMatrix &stiffness,
+		const bool is_mass) const
+	{
+		assemble_with(
+			is_volume, n_basis, bases, gbases, cache, t, stiffness, is_mass,
+			[this](const LinearAssemblerData &data) { return Helmholtz::assemble(data); });
+	}
+
 	Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1>
 	Helmholtz::assemble(const LinearAssemblerData &data) const
 	{
@@ -13,6 +13,17 @@ namespace polyfem::assembler
 	public:
 		using LinearAssembler::assemble;
 
+		/// stiffness assembly calling the local assemble below without virtual dispatch
+		void assemble(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			StiffnessMatrix &stiffness,
+			const bool is_mass = false) const override;
+
 		Helmholtz();
 
 		Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1>
@@ -1,4 +1,5 @@
 #include "HookeLinearElasticity.hpp"
+#include <polyfem/assembler/Assembler.tpp>
 
 #include <polyfem/autogen/auto_elasticity_rhs.hpp>
 
@@ -80,6 +81,21 @@ namespace polyfem::assembler
 		elasticity_tensor_.resize(size);
 	}
 
+	void HookeLinearElasticity::assemble(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		StiffnessMatrix &stiffness,
+		const bool is_mass) const
+	{
+		assemble_with(
+			is_volume, n_basis, bases, gbases, cache, t, stiffness, is_mass,
+			[this](const LinearAssemblerData &data) { return HookeLinearElasticity::assemble(data); });
+	}
+
 	Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1>
 	HookeLinearElasticity::assemble(const LinearAssemblerData &data) const
 	{
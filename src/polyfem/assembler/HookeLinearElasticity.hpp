@@ -16,6 +16,17 @@ namespace polyfem::assembler
 		using NLAssembler::assemble_gradient;
 		using NLAssembler::assemble_hessian;
 
+		/// stiffness assembly calling the local assemble below without virtual dispatch
+		void assemble(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			StiffnessMatrix &stiffness,
+			const bool is_mass = false) const override;
+
 		HookeLinearElasticity();
 
 		// res is R^{dim²}
@@ -1,4 +1,5 @@
 #include "Laplacian.hpp"
+#include <polyfem/assembler/Assembler.tpp>
 
 namespace polyfem::assembler
 {
@@ -10,6 +11,21 @@ namespace polyfem::assembler
 		}
 	} // namespace
 
+	void Laplacian::assemble(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		StiffnessMatrix &stiffness,
+		const bool is_mass) const
+	{
+		assemble_with(
+			is_volume, n_basis, bases, gbases, cache, t, stiffness, is_mass,
+			[this](const LinearAssemblerData &data) { return Laplacian::assemble(data); });
+	}
+
 	Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1> Laplacian::assemble(const LinearAssemblerData &data) const
 	{
 		const Eigen::MatrixXd &gradi = data.vals.basis_values[data.i].grad_t_m;
@@ -25,6 +41,22 @@ namespace polyfem::assembler
 		return Eigen::Matrix<double, 1, 1>::Constant(res);
 	}
 
+	void Laplacian::apply_local(const ElementAssemblyValues &vals, const double t, const QuadratureVector &da, const Eigen::MatrixXd &u, Eigen::MatrixXd &y) const
+	{
+		const int n_loc_bases = int(vals.basis_values.size());
+		assert(u.rows() == n_loc_bases && u.cols() == 1);
+
+		// gradient of u at the quadrature points, weighted by da
+		Eigen::MatrixXd grad_u = Eigen::MatrixXd::Zero(da.size(), vals.basis_values.empty() ? 0 : vals.basis_values[0].grad_t_m.cols());
+		for (int j = 0; j < n_loc_bases; ++j)
+			grad_u += u(j) * vals.basis_values[j].grad_t_m;
+		grad_u.array().colwise() *= da.array();
+
+		y.resize(n_loc_bases, 1);
+		for (int i = 0; i < n_loc_bases; ++i)
+			y(i) = (vals.basis_values[i].grad_t_m.array() * grad_u.array()).sum();
+	}
+
 	Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 3, 1> Laplacian::compute_rhs(const AutodiffHessianPt &pt) const
 	{
 		Eigen::Matrix<double, 1, 1> result;
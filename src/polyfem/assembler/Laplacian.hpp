@@ -13,6 +13,17 @@ namespace polyfem
 		public:
 			using LinearAssembler::assemble;
 
+			/// stiffness assembly calling the local assemble below without virtual dispatch
+			void assemble(
+				const bool is_volume,
+				const int n_basis,
+				const std::vector<basis::ElementBases> &bases,
+				const std::vector<basis::ElementBases> &gbases,
+				const AssemblyValsCache &cache,
+				const double t,
+				StiffnessMatrix &stiffness,
+				const bool is_mass = false) const override;
+
 			std::string name() const override { return "Laplacian"; }
 			std::map<std::string, ParamFunc> parameters() const override { return std::map<std::string, ParamFunc>(); }
 
@@ -21,6 +32,9 @@ namespace polyfem
 			/// ie integral of grad(phi_i) dot grad(phi_j)
 			Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1> assemble(const LinearAssemblerData &data) const override;
 
+			/// matrix-free application, integral of grad(phi_i) dot grad(u)
+			void apply_local(const ElementAssemblyValues &vals, const double t, const QuadratureVector &da, const Eigen::MatrixXd &u, Eigen::MatrixXd &y) const override;
+
 			/// uses autodiff to compute the rhs for a fabricated solution
 			/// in this case it just return pt.getHessian().trace()
 			/// pt is the evaluation of the solution at a point
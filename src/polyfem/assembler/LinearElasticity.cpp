@@ -1,4 +1,5 @@
 #include "LinearElasticity.hpp"
+#include <polyfem/assembler/Assembler.tpp>
 
 #include <polyfem/autogen/auto_elasticity_rhs.hpp>
 
@@ -27,6 +28,21 @@ namespace polyfem
 			params_.add_multimaterial(index, params, size() == 3, units.stress());
 		}
 
+		void LinearElasticity::assemble(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			StiffnessMatrix &stiffness,
+			const bool is_mass) const
+		{
+			assemble_with(
+				is_volume, n_basis, bases, gbases, cache, t, stiffness, is_mass,
+				[this](const LinearAssemblerData &data) { return LinearElasticity::assemble(data); });
+		}
+
 		Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1>
 		LinearElasticity::assemble(const LinearAssemblerData &data) const
 		{
@@ -37,6 +53,9 @@ namespace polyfem
 			Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1> res(size() * size());
 			res.setZero();
 
+			Eigen::VectorXd lambdas, mus;
+			params_.lambda_mu(data.vals.quadrature.points, data.vals.val, data.t, data.vals.element_id, lambdas, mus);
+
 			for (long k = 0; k < gradi.rows(); ++k)
 			{
 				Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1> res_k(size() * size());
@@ -44,8 +63,8 @@ namespace polyfem
 				const Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3> outer = gradi.row(k).transpose() * gradj.row(k);
 				const double dot = gradi.row(k).dot(gradj.row(k));
 
-				double lambda, mu;
-				params_.lambda_mu(data.vals.quadrature.points.row(k), data.vals.val.row(k), data.t, data.vals.element_id, lambda, mu);
+				const double lambda = lambdas(k);
+				const double mu = mus(k);
 
 				for (int ii = 0; ii < size(); ++ii)
 				{
@@ -62,6 +81,34 @@ namespace polyfem
 			return res;
 		}
 
+		void LinearElasticity::apply_local(const ElementAssemblyValues &vals, const double t, const QuadratureVector &da, const Eigen::MatrixXd &u, Eigen::MatrixXd &y) const
+		{
+			const int n_loc_bases = int(vals.basis_values.size());
+			assert(u.rows() == n_loc_bases && u.cols() == size());
+
+			Eigen::VectorXd lambdas, mus;
+			params_.lambda_mu(vals.quadrature.points, vals.val, t, vals.element_id, lambdas, mus);
+
+			y.setZero(n_loc_bases, size());
+
+			Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3> grad_u(size(), size()), stress(size(), size());
+			for (long k = 0; k < da.size(); ++k)
+			{
+				// grad_u(a, b) = d u_a / d x_b
+				grad_u.setZero();
+				for (int j = 0; j < n_loc_bases; ++j)
+					grad_u += u.row(j).transpose() * vals.basis_values[j].grad_t_m.row(k);
+
+				// sigma = mu (grad_u + grad_u^T) + lambda tr(grad_u) Id
+				stress = mus(k) * (grad_u + grad_u.transpose());
+				stress.diagonal().array() += lambdas(k) * grad_u.trace();
+				stress *= da(k);
+
+				for (int i = 0; i < n_loc_bases; ++i)
+					y.row(i) += vals.basis_values[i].grad_t_m.row(k) * stress;
+			}
+		}
+
 		double LinearElasticity::compute_energy(const NonLinearAssemblerData &data) const
 		{
 			return compute_energy_aux<double>(data);
@@ -117,14 +164,17 @@ namespace polyfem
 			T energy = T(0.0);
 
 			const int n_pts = data.da.size();
+			Eigen::VectorXd lambdas, mus;
+			params_.lambda_mu(data.vals.quadrature.points, data.vals.val, data.t, data.vals.element_id, lambdas, mus);
+
 			for (long p = 0; p < n_pts; ++p)
 			{
 				compute_disp_grad_at_quad(data, local_disp, p, size(), disp_grad);
 
 				const AutoDiffGradMat strain = (disp_grad + disp_grad.transpose()) / T(2);
 
-				double lambda, mu;
-				params_.lambda_mu(data.vals.quadrature.points.row(p), data.vals.val.row(p), data.t, data.vals.element_id, lambda, mu);
+				const double lambda = lambdas(p);
+				const double mu = mus(p);
 
 				const T val = mu * (strain.transpose() * strain).trace() + lambda / 2 * strain.trace() * strain.trace();
 
@@ -16,12 +16,26 @@ namespace polyfem::assembler
 		using NLAssembler::assemble_gradient;
 		using NLAssembler::assemble_hessian;
 
+		/// stiffness assembly calling the local assemble below without virtual dispatch
+		void assemble(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			StiffnessMatrix &stiffness,
+			const bool is_mass = false) const override;
+
 		/// computes local stiffness matrix is R^{dim²} for bases i,j
 		// vals stores the evaluation for that element
 		// da contains both the quadrature weight and the change of metric in the integral
 		Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1>
 		assemble(const LinearAssemblerData &data) const override;
 
+		// matrix-free application, integral of grad(phi_i) : sigma(u)
+		void apply_local(const ElementAssemblyValues &vals, const double t, const QuadratureVector &da, const Eigen::MatrixXd &u, Eigen::MatrixXd &y) const override;
+
 		// compute elastic energy
 		double compute_energy(const NonLinearAssemblerData &data) const override;
 		// neccessary for mixing linear model with non-linear collision response
@@ -1,7 +1,23 @@
 #include "Mass.hpp"
+#include <polyfem/assembler/Assembler.tpp>
 
 namespace polyfem::assembler
 {
+	void Mass::assemble(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		StiffnessMatrix &stiffness,
+		const bool is_mass) const
+	{
+		assemble_with(
+			is_volume, n_basis, bases, gbases, cache, t, stiffness, is_mass,
+			[this](const LinearAssemblerData &data) { return Mass::assemble(data); });
+	}
+
 	Eigen::Matrix<double, Eigen::Dynamic, 1, 0, 9, 1> Mass::assemble(const LinearAssemblerData &data) const
 	{
 		double tmp = 0;
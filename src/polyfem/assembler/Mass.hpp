@@ -11,6 +11,17 @@ namespace polyfem::assembler
 	public:
 		using Assembler::assemble;
 
+		/// stiffness assembly calling the local assemble below without virtual dispatch
+		void assemble(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			StiffnessMatrix &stiffness,
+			const bool is_mass = false) const override;
+
 		/// computes and returns local stiffness matrix (1x1) for 
 		/// bases i,j (where i,j is passed in through data)
 		/// ie integral of phi_i * phi_j on the given element
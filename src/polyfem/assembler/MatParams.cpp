@@ -57,6 +57,15 @@ namespace polyfem::assembler
 		return tmp_param(x, y, z, t, index);
 	}
 
+	void GenericMatParam::evaluate(const Eigen::MatrixXd &pts, double t, int index, Eigen::VectorXd &out) const
+	{
+		assert(param_.size() == 1 || index < param_.size());
+
+		const auto &tmp_param = param_.size() == 1 ? param_[0] : param_[index];
+
+		tmp_param.evaluate(pts, t, out, index);
+	}
+
 	GenericMatParams::GenericMatParams(const std::string &param_name)
 		: param_name_(param_name)
 	{
@@ -347,6 +356,41 @@ namespace polyfem::assembler
 		assert(!std::isinf(mu));
 	}
 
+	void LameParameters::lambda_mu(const Eigen::MatrixXd &param, const Eigen::MatrixXd &p, double t, int el_id, Eigen::VectorXd &lambda, Eigen::VectorXd &mu) const
+	{
+		assert(lambda_or_E_.size() == 1 || el_id < lambda_or_E_.size());
+		assert(mu_or_nu_.size() == 1 || el_id < mu_or_nu_.size());
+		assert(size_ == 2 || size_ == 3);
+		assert(param.rows() == p.rows());
+
+		if (lambda_mat_.size() > el_id && mu_mat_.size() > el_id)
+		{
+			lambda.setConstant(p.rows(), lambda_mat_(el_id));
+			mu.setConstant(p.rows(), mu_mat_(el_id));
+			return;
+		}
+
+		const auto &tmp1 = lambda_or_E_.size() == 1 ? lambda_or_E_[0] : lambda_or_E_[el_id];
+		const auto &tmp2 = mu_or_nu_.size() == 1 ? mu_or_nu_[0] : mu_or_nu_[el_id];
+
+		tmp1.evaluate(p, t, lambda, el_id);
+		tmp2.evaluate(p, t, mu, el_id);
+
+		if (!is_lambda_mu_)
+		{
+			for (int q = 0; q < lambda.size(); ++q)
+			{
+				const double E = lambda(q);
+				const double nu = mu(q);
+				lambda(q) = convert_to_lambda(size_ == 3, E, nu);
+				mu(q) = convert_to_mu(E, nu);
+			}
+		}
+
+		assert(lambda.allFinite());
+		assert(mu.allFinite());
+	}
+
 	void LameParameters::add_multimaterial(const int index, const json &params, const bool is_volume, const std::string &stress_unit)
 	{
 		const int size = is_volume ? 3 : 2;
@@ -407,6 +451,16 @@ namespace polyfem::assembler
 		return res;
 	}
 
+	void Density::operator()(const Eigen::MatrixXd &param, const Eigen::MatrixXd &p, double t, int el_id, Eigen::VectorXd &rho) const
+	{
+		assert(rho_.size() == 1 || el_id < rho_.size());
+		assert(param.rows() == p.rows());
+
+		const auto &tmp = rho_.size() == 1 ? rho_[0] : rho_[el_id];
+		tmp.evaluate(p, t, rho, el_id);
+		assert(rho.allFinite());
+	}
+
 	void Density::add_multimaterial(const int index, const json &params, const std::string &density_unit)
 	{
 		for (int i = rho_.size(); i <= index; ++i)
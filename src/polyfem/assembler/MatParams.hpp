@@ -13,6 +13,8 @@ namespace polyfem::assembler
 
 		double operator()(const RowVectorNd &p, double t, int index) const;
 		double operator()(double x, double y, double z, double t, int index) const;
+		/// evaluates the parameter at all points (rows of pts) of the element index
+		void evaluate(const Eigen::MatrixXd &pts, double t, int index, Eigen::VectorXd &out) const;
 
 		void add_multimaterial(const int index, const json &params, const std::string &unit_type);
 
@@ -82,6 +84,8 @@ namespace polyfem::assembler
 				t,
 				el_id, lambda, mu);
 		}
+		/// batched version evaluating lambda and mu at all quadrature points (rows of p) of element el_id
+		void lambda_mu(const Eigen::MatrixXd &param, const Eigen::MatrixXd &p, double t, int el_id, Eigen::VectorXd &lambda, Eigen::VectorXd &mu) const;
 
 		Eigen::MatrixXd lambda_mat_, mu_mat_;
 
@@ -109,6 +113,8 @@ namespace polyfem::assembler
 						   p(0), p(1), p.size() == 3 ? p(2) : 0.0,
 						   t, el_id);
 		}
+		/// batched version evaluating the density at all quadrature points (rows of p) of element el_id
+		void operator()(const Eigen::MatrixXd &param, const Eigen::MatrixXd &p, double t, int el_id, Eigen::VectorXd &rho) const;
 
 	private:
 		void set_rho(const json &rho);
@@ -0,0 +1,139 @@
+#include "MaterialStateBuffer.hpp"
+
+#include <polyfem/assembler/Assembler.hpp>
+#include <polyfem/utils/MaybeParallelFor.hpp>
+#include <polyfem/utils/Timer.hpp>
+
+#include <atomic>
+
+namespace polyfem::assembler
+{
+	using namespace basis;
+	using namespace utils;
+
+	namespace
+	{
+		struct LocalThreadStorage
+		{
+			ElementAssemblyValues vals;
+			Eigen::MatrixXd local_disp;
+			Eigen::MatrixXd params;
+		};
+	} // namespace
+
+	void MaterialStateBuffer::update(
+		const NLAssembler &assembler,
+		const bool is_volume,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const Eigen::MatrixXd &x)
+	{
+		POLYFEM_PROFILE_SCOPE("material state update");
+		assert(x.cols() == 1);
+
+		const int n_elements = int(bases.size());
+		dim_ = assembler.size();
+		valid_ = false;
+
+		// the quadrature does not depend on the solution, the offsets are computed once
+		if (offsets_.size() != n_elements + 1)
+		{
+			offsets_.resize(n_elements + 1);
+			offsets_[0] = 0;
+
+			ElementAssemblyValues tmp;
+			for (int e = 0; e < n_elements; ++e)
+				offsets_[e + 1] = offsets_[e] + cache.get(e, is_volume, bases[e], gbases[e], tmp).quadrature.weights.size();
+		}
+
+		int n_params = 0;
+		if (assembler.has_batched_kernels() && n_elements > 0)
+		{
+			ElementAssemblyValues tmp;
+			Eigen::MatrixXd params;
+			assembler.compute_batch_params(cache.get(0, is_volume, bases[0], gbases[0], tmp), t, params);
+			n_params = params.cols();
+		}
+
+		F_.resize(offsets_.back(), dim_ * dim_);
+		J_.resize(offsets_.back());
+		params_.resize(offsets_.back(), n_params);
+
+		// set if the quadrature changed since the offsets were computed (e.g., new bases with the same number of elements)
+		std::atomic<bool> stale_offsets{false};
+
+		auto storage = create_thread_storage(LocalThreadStorage());
+		maybe_parallel_for(n_elements, [&](int start, int end, int thread_id) {
+			LocalThreadStorage &local_storage = get_local_thread_storage(storage, thread_id);
+			Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3> def_grad(dim_, dim_);
+
+			for (int e = start; e < end; ++e)
+			{
+				const ElementAssemblyValues &vals = cache.get(e, is_volume, bases[e], gbases[e], local_storage.vals);
+				const int offset = offsets_[e];
+				const int n_pts = n_points(e);
+				const int n_loc_bases = int(vals.basis_values.size());
+				if (vals.quadrature.weights.size() != n_pts)
+				{
+					stale_offsets = true;
+					continue;
+				}
+
+				local_storage.local_disp.setZero(n_loc_bases, dim_);
+				for (int i = 0; i < n_loc_bases; ++i)
+					for (const auto &g : vals.basis_values[i].global)
+						for (int d = 0; d < dim_; ++d)
+							local_storage.local_disp(i, d) += g.val * x(g.index * dim_ + d);
+
+				// F = I + ∑ uᵢ ⊗ ∇φᵢ
+				for (int p = 0; p < n_pts; ++p)
+				{
+					def_grad.setIdentity();
+					for (int i = 0; i < n_loc_bases; ++i)
+						def_grad += local_storage.local_disp.row(i).transpose() * vals.basis_values[i].grad_t_m.row(p);
+
+					for (int j = 0; j < dim_; ++j)
+						for (int i = 0; i < dim_; ++i)
+							F_(offset + p, j * dim_ + i) = def_grad(i, j);
+					J_(offset + p) = def_grad.determinant();
+				}
+
+				if (n_params > 0)
+				{
+					assembler.compute_batch_params(vals, t, local_storage.params);
+					assert(local_storage.params.rows() == n_pts && local_storage.params.cols() == n_params);
+					params_.middleRows(offset, n_pts) = local_storage.params;
+				}
+			}
+		});
+
+		if (stale_offsets)
+		{
+			offsets_.clear();
+			update(assembler, is_volume, bases, gbases, cache, t, x);
+			return;
+		}
+
+		t_ = t;
+		x_ = x;
+		valid_ = true;
+	}
+
+	bool MaterialStateBuffer::is_valid(const double t, const Eigen::MatrixXd &x) const
+	{
+		return valid_ && t == t_ && x.cols() == 1 && x.size() == x_.size()
+			   && Eigen::Map<const Eigen::VectorXd>(x.data(), x.size()) == x_;
+	}
+
+	void MaterialStateBuffer::clear()
+	{
+		valid_ = false;
+		x_.resize(0);
+		offsets_.clear();
+		F_.resize(0, 0);
+		J_.resize(0);
+		params_.resize(0, 0);
+	}
+} // namespace polyfem::assembler
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <polyfem/assembler/AssemblyValsCache.hpp>
+#include <polyfem/basis/ElementBases.hpp>
+
+#include <Eigen/Dense>
+
+#include <vector>
+
+namespace polyfem::assembler
+{
+	class NLAssembler;
+
+	/// Deformation state at every quadrature point of the mesh for one solution, shared by the energy, gradient,
+	/// and hessian assembly of the same iterate. The values are stored as structure of arrays with one row per
+	/// quadrature point (the points of element e start at offset(e)):
+	/// - F: deformation gradient I + ∇u, dim x dim column major entries per row
+	/// - J: determinant of F
+	/// - params: material parameters of the assembler (see NLAssembler::compute_batch_params), empty if not available
+	class MaterialStateBuffer
+	{
+	public:
+		/// recomputes the state for the solution x at time t
+		void update(
+			const NLAssembler &assembler,
+			const bool is_volume,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const Eigen::MatrixXd &x);
+
+		/// true if the state was computed for the solution x at time t
+		bool is_valid(const double t, const Eigen::MatrixXd &x) const;
+
+		/// drops the state, is_valid returns false until the next update
+		void clear();
+
+		int dim() const { return dim_; }
+		int offset(const int el_index) const { return offsets_[el_index]; }
+		int n_points(const int el_index) const { return offsets_[el_index + 1] - offsets_[el_index]; }
+
+		const Eigen::MatrixXd &F() const { return F_; }
+		const Eigen::VectorXd &J() const { return J_; }
+		const Eigen::MatrixXd &params() const { return params_; }
+
+		/// entry (i, j) of the deformation gradient at the global quadrature point index
+		double F(const int point, const int i, const int j) const { return F_(point, j * dim_ + i); }
+
+	private:
+		int dim_ = 0;
+		bool valid_ = false;
+		double t_ = 0;
+		Eigen::VectorXd x_;
+
+		std::vector<int> offsets_;
+		Eigen::MatrixXd F_;
+		Eigen::VectorXd J_;
+		Eigen::MatrixXd params_;
+	};
+} // namespace polyfem::assembler
@@ -0,0 +1,113 @@
+#include "MatrixFreeOperator.hpp"
+
+#include <polyfem/utils/ConjugateGradient.hpp>
+#include <polyfem/utils/Logger.hpp>
+#include <polyfem/utils/MaybeParallelFor.hpp>
+#include <polyfem/utils/Timer.hpp>
+
+namespace polyfem::assembler
+{
+	using namespace basis;
+	using namespace utils;
+
+	namespace
+	{
+		struct LocalThreadStorage
+		{
+			ElementAssemblyValues vals;
+			QuadratureVector da;
+			Eigen::MatrixXd u, y;
+		};
+	} // namespace
+
+	MatrixFreeOperator::MatrixFreeOperator(
+		const LinearAssembler &assembler,
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<ElementBases> &bases,
+		const std::vector<ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t)
+		: assembler_(assembler), is_volume_(is_volume), n_basis_(n_basis),
+		  bases_(bases), gbases_(gbases), cache_(cache), t_(t)
+	{
+		assert(assembler.size() > 0);
+	}
+
+	void MatrixFreeOperator::apply(const Eigen::VectorXd &x, Eigen::VectorXd &y) const
+	{
+		POLYFEM_PROFILE_SCOPE("matrix-free apply");
+		assert(x.size() == rows());
+
+		const int dim = assembler_.size();
+		Eigen::MatrixXd res;
+		parallel_reduce_vector(
+			int(bases_.size()), rows(), LocalThreadStorage(),
+			[&](const int e, LocalThreadStorage &storage, Eigen::MatrixXd &vec) {
+				const ElementAssemblyValues &vals = cache_.get(e, is_volume_, bases_[e], gbases_[e], storage.vals);
+				storage.da = vals.det.array() * vals.quadrature.weights.array();
+				const int n_loc_bases = int(vals.basis_values.size());
+
+				// gather, the local coefficients are the weighted sums of the global ones
+				storage.u.setZero(n_loc_bases, dim);
+				for (int i = 0; i < n_loc_bases; ++i)
+					for (const auto &g : vals.basis_values[i].global)
+						for (int m = 0; m < dim; ++m)
+							storage.u(i, m) += g.val * x(g.index * dim + m);
+
+				assembler_.apply_local(vals, t_, storage.da, storage.u, storage.y);
+
+				// scatter
+				for (int i = 0; i < n_loc_bases; ++i)
+					for (const auto &g : vals.basis_values[i].global)
+						for (int m = 0; m < dim; ++m)
+							vec(g.index * dim + m) += g.val * storage.y(i, m);
+			},
+			res);
+
+		y = res;
+	}
+
+	Eigen::VectorXd MatrixFreeOperator::diagonal() const
+	{
+		const int dim = assembler_.size();
+		Eigen::MatrixXd res;
+		parallel_reduce_vector(
+			int(bases_.size()), rows(), LocalThreadStorage(),
+			[&](const int e, LocalThreadStorage &storage, Eigen::MatrixXd &vec) {
+				const ElementAssemblyValues &vals = cache_.get(e, is_volume_, bases_[e], gbases_[e], storage.vals);
+				storage.da = vals.det.array() * vals.quadrature.weights.array();
+
+				assembler_.local_diagonal(vals, t_, storage.da, storage.y);
+
+				// the coupling between two local bases sharing a global node (non-conforming) is ignored
+				for (int i = 0; i < storage.y.rows(); ++i)
+					for (const auto &g : vals.basis_values[i].global)
+						for (int m = 0; m < dim; ++m)
+							vec(g.index * dim + m) += g.val * g.val * storage.y(i, m);
+			},
+			res);
+
+		return res;
+	}
+
+	int MatrixFreeOperator::solve(
+		const Eigen::VectorXd &b,
+		const std::vector<int> &boundary_nodes,
+		Eigen::VectorXd &x,
+		const double tolerance,
+		const int max_iterations) const
+	{
+		POLYFEM_SCOPED_TIMER("matrix-free solve");
+		assert(b.size() == rows());
+
+		Eigen::VectorXd inv_diag = diagonal();
+		for (int i = 0; i < inv_diag.size(); ++i)
+			inv_diag(i) = inv_diag(i) == 0 ? 0 : 1 / inv_diag(i);
+
+		return dirichlet_conjugate_gradient(
+			[&](const Eigen::VectorXd &v, Eigen::VectorXd &Av) { apply(v, Av); },
+			[&](const Eigen::VectorXd &r, Eigen::VectorXd &z) { z = inv_diag.cwiseProduct(r); },
+			b, boundary_nodes, x, tolerance, max_iterations);
+	}
+} // namespace polyfem::assembler
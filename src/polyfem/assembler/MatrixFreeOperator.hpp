@@ -0,0 +1,62 @@
+#pragma once
+
+#include <polyfem/assembler/Assembler.hpp>
+#include <polyfem/assembler/AssemblyValsCache.hpp>
+#include <polyfem/basis/ElementBases.hpp>
+
+#include <Eigen/Dense>
+
+#include <vector>
+
+namespace polyfem::assembler
+{
+	/// Stiffness matrix of a LinearAssembler applied element by element, without assembling the global matrix.
+	/// The local products use LinearAssembler::apply_local on the (cached) element values, so only the
+	/// vectors and the diagonal are stored. Used to solve high order problems whose matrix does not fit in memory.
+	class MatrixFreeOperator
+	{
+	public:
+		/// the arguments are stored by reference and must outlive the operator
+		MatrixFreeOperator(
+			const LinearAssembler &assembler,
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t);
+
+		/// number of rows (and columns) of the operator
+		int rows() const { return n_basis_ * assembler_.size(); }
+
+		/// y = A x
+		void apply(const Eigen::VectorXd &x, Eigen::VectorXd &y) const;
+
+		/// diagonal of A, computed from the local diagonals (used as Jacobi preconditioner)
+		Eigen::VectorXd diagonal() const;
+
+		/// Solves A x = b with conjugate gradient preconditioned with Jacobi, the rows and columns of
+		/// boundary_nodes are eliminated and x is set to b on them (same convention as dirichlet_solve).
+		/// @param[in] b right-hand side, contains the Dirichlet values on boundary_nodes
+		/// @param[in] boundary_nodes Dirichlet dofs
+		/// @param[in,out] x initial guess and solution
+		/// @param[in] tolerance relative tolerance on the preconditioned residual norm
+		/// @param[in] max_iterations maximum number of iterations
+		/// @return number of iterations, negative if not converged
+		int solve(
+			const Eigen::VectorXd &b,
+			const std::vector<int> &boundary_nodes,
+			Eigen::VectorXd &x,
+			const double tolerance,
+			const int max_iterations) const;
+
+	private:
+		const LinearAssembler &assembler_;
+		const bool is_volume_;
+		const int n_basis_;
+		const std::vector<basis::ElementBases> &bases_;
+		const std::vector<basis::ElementBases> &gbases_;
+		const AssemblyValsCache &cache_;
+		const double t_;
+	};
+} // namespace polyfem::assembler
@@ -1,5 +1,7 @@
 #include "NeoHookeanElasticity.hpp"
 
+#include <polyfem/assembler/Assembler.tpp>
+
 #include <polyfem/autogen/auto_elasticity_rhs.hpp>
 
 namespace polyfem::assembler
@@ -10,6 +12,103 @@ namespace polyfem::assembler
 		{
 			return (i == j) ? true : false;
 		}
+
+		// Deformation gradient F = I + ∑ uᵢ ⊗ ∇φᵢ, its cofactor matrix (J F⁻ᵀ), and J for every lane, row major
+		template <class Batch>
+		void batch_def_grad(
+			const Batch &batch,
+			std::array<typename Batch::Lane, Batch::dim * Batch::dim> &F,
+			std::array<typename Batch::Lane, Batch::dim * Batch::dim> &cof,
+			typename Batch::Lane &J)
+		{
+			constexpr int dim = Batch::dim;
+
+			for (int a = 0; a < dim; ++a)
+			{
+				for (int c = 0; c < dim; ++c)
+				{
+					F[a * dim + c].setConstant(a == c ? 1 : 0);
+					for (int i = 0; i < Batch::n_basis; ++i)
+						F[a * dim + c] += batch.disp[i * dim + a] * batch.grad[i * dim + c];
+				}
+			}
+
+			if constexpr (dim == 2)
+			{
+				cof[0] = F[3];
+				cof[1] = -F[2];
+				cof[2] = -F[1];
+				cof[3] = F[0];
+			}
+			else
+			{
+				for (int a = 0; a < 3; ++a)
+				{
+					const int a1 = (a + 1) % 3, a2 = (a + 2) % 3;
+					for (int c = 0; c < 3; ++c)
+					{
+						const int c1 = (c + 1) % 3, c2 = (c + 2) % 3;
+						cof[a * 3 + c] = F[a1 * 3 + c1] * F[a2 * 3 + c2] - F[a1 * 3 + c2] * F[a2 * 3 + c1];
+					}
+				}
+			}
+
+			J.setZero();
+			for (int c = 0; c < dim; ++c)
+				J += F[c] * cof[c];
+		}
+
+		// ψ = ½μ (tr(FᵀF) - d - 2ln(J)) + ½λ ln²(J)
+		template <class Batch>
+		void neo_hookean_energy_batch(const Batch &batch, typename Batch::Lane &energy)
+		{
+			constexpr int dim = Batch::dim;
+			std::array<typename Batch::Lane, dim * dim> F, cof;
+			typename Batch::Lane J;
+			batch_def_grad(batch, F, cof, J);
+
+			const auto &lambda = batch.params[0];
+			const auto &mu = batch.params[1];
+
+			typename Batch::Lane trFtF;
+			trFtF.setZero();
+			for (int k = 0; k < dim * dim; ++k)
+				trFtF += F[k].square();
+
+			const typename Batch::Lane log_det_j = J.log();
+			energy = (mu / 2 * (trFtF - dim - 2 * log_det_j) + lambda / 2 * log_det_j.square()) * batch.da;
+		}
+
+		// ∂ψ/∂uᵢ = P ∇φᵢ with P = μ (F - F⁻ᵀ) + λ ln(J) F⁻ᵀ
+		template <class Batch>
+		void neo_hookean_gradient_batch(const Batch &batch, typename Batch::LaneDofs &gradient)
+		{
+			constexpr int dim = Batch::dim;
+			std::array<typename Batch::Lane, dim * dim> F, cof;
+			typename Batch::Lane J;
+			batch_def_grad(batch, F, cof, J);
+
+			const auto &lambda = batch.params[0];
+			const auto &mu = batch.params[1];
+			const typename Batch::Lane log_det_j = J.log();
+
+			std::array<typename Batch::Lane, dim * dim> P;
+			for (int k = 0; k < dim * dim; ++k)
+			{
+				const typename Batch::Lane FmT = cof[k] / J;
+				P[k] = (mu * (F[k] - FmT) + lambda * log_det_j * FmT) * batch.da;
+			}
+
+			for (int i = 0; i < Batch::n_basis; ++i)
+			{
+				for (int a = 0; a < dim; ++a)
+				{
+					gradient[i * dim + a] = P[a * dim] * batch.grad[i * dim];
+					for (int c = 1; c < dim; ++c)
+						gradient[i * dim + a] += P[a * dim + c] * batch.grad[i * dim + c];
+				}
+			}
+		}
 	} // namespace
 
 	NeoHookeanElasticity::NeoHookeanElasticity()
@@ -46,8 +145,20 @@ namespace polyfem::assembler
 	Eigen::VectorXd
 	NeoHookeanElasticity::assemble_gradient(const NonLinearAssemblerData &data) const
 	{
-		Eigen::Matrix<double, Eigen::Dynamic, 1> gradient;
+		Eigen::VectorXd gradient;
+		compute_energy_gradient(data, gradient, nullptr);
+		return gradient;
+	}
+
+	double NeoHookeanElasticity::compute_energy_and_gradient(const NonLinearAssemblerData &data, Eigen::VectorXd &gradient) const
+	{
+		double energy;
+		compute_energy_gradient(data, gradient, &energy);
+		return energy;
+	}
 
+	void NeoHookeanElasticity::compute_energy_gradient(const NonLinearAssemblerData &data, Eigen::VectorXd &gradient, double *energy) const
+	{
 		if (size() == 2)
 		{
 			switch (data.vals.basis_values.size())
@@ -55,25 +166,25 @@ namespace polyfem::assembler
 			case 3:
 			{
 				gradient.resize(6);
-				compute_energy_aux_gradient_fast<3, 2>(data, gradient);
+				compute_energy_aux_gradient_fast<3, 2>(data, gradient, energy);
 				break;
 			}
 			case 6:
 			{
 				gradient.resize(12);
-				compute_energy_aux_gradient_fast<6, 2>(data, gradient);
+				compute_energy_aux_gradient_fast<6, 2>(data, gradient, energy);
 				break;
 			}
 			case 10:
 			{
 				gradient.resize(20);
-				compute_energy_aux_gradient_fast<10, 2>(data, gradient);
+				compute_energy_aux_gradient_fast<10, 2>(data, gradient, energy);
 				break;
 			}
 			default:
 			{
 				gradient.resize(data.vals.basis_values.size() * 2);
-				compute_energy_aux_gradient_fast<Eigen::Dynamic, 2>(data, gradient);
+				compute_energy_aux_gradient_fast<Eigen::Dynamic, 2>(data, gradient, energy);
 				break;
 			}
 			}
@@ -86,31 +197,29 @@ namespace polyfem::assembler
 			case 4:
 			{
 				gradient.resize(12);
-				compute_energy_aux_gradient_fast<4, 3>(data, gradient);
+				compute_energy_aux_gradient_fast<4, 3>(data, gradient, energy);
 				break;
 			}
 			case 10:
 			{
 				gradient.resize(30);
-				compute_energy_aux_gradient_fast<10, 3>(data, gradient);
+				compute_energy_aux_gradient_fast<10, 3>(data, gradient, energy);
 				break;
 			}
 			case 20:
 			{
 				gradient.resize(60);
-				compute_energy_aux_gradient_fast<20, 3>(data, gradient);
+				compute_energy_aux_gradient_fast<20, 3>(data, gradient, energy);
 				break;
 			}
 			default:
 			{
 				gradient.resize(data.vals.basis_values.size() * 3);
-				compute_energy_aux_gradient_fast<Eigen::Dynamic, 3>(data, gradient);
+				compute_energy_aux_gradient_fast<Eigen::Dynamic, 3>(data, gradient, energy);
 				break;
 			}
 			}
 		}
-
-		return gradient;
 	}
 
 	void NeoHookeanElasticity::compute_stiffness_value(const double t,
@@ -123,6 +232,8 @@ namespace polyfem::assembler
 		assert(displacement.cols() == 1);
 
 		Eigen::MatrixXd displacement_grad(size(), size());
+		// at most 3x3, stays on the stack
+		Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3> def_grad(size(), size()), FmT(size(), size());
 
 		for (long p = 0; p < local_pts.rows(); ++p)
 		{
@@ -130,22 +241,21 @@ namespace polyfem::assembler
 			params_.lambda_mu(local_pts.row(p), vals.val.row(p), t, vals.element_id, lambda, mu);
 
 			compute_diplacement_grad(size(), vals, local_pts, p, displacement, displacement_grad);
-			const Eigen::MatrixXd def_grad = Eigen::MatrixXd::Identity(size(), size()) + displacement_grad;
-			const Eigen::MatrixXd FmT = def_grad.inverse().transpose();
-			const Eigen::VectorXd FmT_vec = utils::flatten(FmT);
+			def_grad = displacement_grad;
+			def_grad.diagonal().array() += 1;
+			FmT = def_grad.inverse().transpose();
 			const double J = def_grad.determinant();
 			const double tmp1 = mu - lambda * std::log(J);
+			// the last term is lambda * flatten(FmT) ⊗ flatten(FmT), with row major flattening
 			for (int i = 0, idx = 0; i < size(); i++)
 				for (int j = 0; j < size(); j++)
 					for (int k = 0; k < size(); k++)
 						for (int l = 0; l < size(); l++)
 						{
-							tensor(p, idx) = mu * delta(i, k) * delta(j, l) + tmp1 * FmT(i, l) * FmT(k, j);
+							tensor(p, idx) = mu * delta(i, k) * delta(j, l) + tmp1 * FmT(i, l) * FmT(k, j) + lambda * FmT(i, j) * FmT(k, l);
 							idx++;
 						}
 
-			tensor.row(p) += lambda * utils::flatten(FmT_vec * FmT_vec.transpose());
-
 			// {
 			// 	Eigen::MatrixXd hess = utils::unflatten(tensor.row(p), size()*size());
 			// 	Eigen::MatrixXd fhess;
@@ -297,9 +407,164 @@ namespace polyfem::assembler
 		}
 	}
 
+	void NeoHookeanElasticity::compute_batch_params(const ElementAssemblyValues &vals, const double t, Eigen::MatrixXd &params) const
+	{
+		Eigen::VectorXd lambdas, mus;
+		params_.lambda_mu(vals.quadrature.points, vals.val, t, vals.element_id, lambdas, mus);
+
+		params.resize(lambdas.size(), 2);
+		params.col(0) = lambdas;
+		params.col(1) = mus;
+	}
+
+	void NeoHookeanElasticity::compute_energy_batch(const TriangleBatch &batch, TriangleBatch::Lane &energy) const
+	{
+		neo_hookean_energy_batch(batch, energy);
+	}
+
+	void NeoHookeanElasticity::compute_energy_batch(const TetBatch &batch, TetBatch::Lane &energy) const
+	{
+		neo_hookean_energy_batch(batch, energy);
+	}
+
+	void NeoHookeanElasticity::compute_gradient_batch(const TriangleBatch &batch, TriangleBatch::LaneDofs &gradient) const
+	{
+		neo_hookean_gradient_batch(batch, gradient);
+	}
+
+	void NeoHookeanElasticity::compute_gradient_batch(const TetBatch &batch, TetBatch::LaneDofs &gradient) const
+	{
+		neo_hookean_gradient_batch(batch, gradient);
+	}
+
+	double NeoHookeanElasticity::assemble_energy(
+		const bool is_volume,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev) const
+	{
+		if (use_batched_kernels())
+			return NLAssembler::assemble_energy(is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev);
+
+		return assemble_energy_with(
+			is_volume, bases, gbases, cache, t, dt, displacement, displacement_prev,
+			[this](const NonLinearAssemblerData &data) { return NeoHookeanElasticity::compute_energy(data); });
+	}
+
+	void NeoHookeanElasticity::assemble_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		Eigen::MatrixXd &rhs) const
+	{
+		if (use_batched_kernels())
+			return NLAssembler::assemble_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+
+		assemble_gradient_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev,
+			[this](const NonLinearAssemblerData &data) { return NeoHookeanElasticity::assemble_gradient(data); },
+			rhs);
+	}
+
+	void NeoHookeanElasticity::assemble_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		const utils::ElementColoring &coloring,
+		Eigen::MatrixXd &rhs) const
+	{
+		if (use_batched_kernels())
+			return NLAssembler::assemble_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring, rhs);
+
+		assemble_gradient_colored_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring,
+			[this](const NonLinearAssemblerData &data) { return NeoHookeanElasticity::assemble_gradient(data); },
+			rhs);
+	}
+
+	double NeoHookeanElasticity::assemble_energy_and_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		Eigen::MatrixXd &rhs) const
+	{
+		if (use_batched_kernels())
+			return NLAssembler::assemble_energy_and_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, rhs);
+
+		return assemble_energy_and_gradient_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev,
+			[this](const NonLinearAssemblerData &data, Eigen::VectorXd &gradient) { return NeoHookeanElasticity::compute_energy_and_gradient(data, gradient); },
+			rhs);
+	}
+
+	double NeoHookeanElasticity::assemble_energy_and_gradient(
+		const bool is_volume,
+		const int n_basis,
+		const std::vector<basis::ElementBases> &bases,
+		const std::vector<basis::ElementBases> &gbases,
+		const AssemblyValsCache &cache,
+		const double t,
+		const double dt,
+		const Eigen::MatrixXd &displacement,
+		const Eigen::MatrixXd &displacement_prev,
+		const utils::ElementColoring &coloring,
+		Eigen::MatrixXd &rhs) const
+	{
+		if (use_batched_kernels())
+			return NLAssembler::assemble_energy_and_gradient(is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring, rhs);
+
+		return assemble_energy_and_gradient_colored_with(
+			is_volume, n_basis, bases, gbases, cache, t, dt, displacement, displacement_prev, coloring,
+			[this](const NonLinearAssemblerData &data, Eigen::VectorXd &gradient) { return NeoHookeanElasticity::compute_energy_and_gradient(data, gradient); },
+			rhs);
+	}
+
 	double NeoHookeanElasticity::compute_energy(const NonLinearAssemblerData &data) const
 	{
-		return compute_energy_aux<double>(data);
+		if (!data.material_state || data.material_state->params().cols() != 2)
+			return compute_energy_aux<double>(data);
+
+		// F, J, and the parameters of the same iterate are already in the shared state
+		const MaterialStateBuffer &state = *data.material_state;
+		const int offset = state.offset(data.vals.element_id);
+		const int n_pts = data.da.size();
+		assert(state.n_points(data.vals.element_id) == n_pts);
+
+		double energy = 0;
+		for (long p = 0; p < n_pts; ++p)
+		{
+			const double lambda = state.params()(offset + p, 0);
+			const double mu = state.params()(offset + p, 1);
+
+			// tr(FᵀF) is the sum of the squared entries of F
+			const double log_det_j = log(state.J()(offset + p));
+			const double val = mu / 2 * (state.F().row(offset + p).squaredNorm() - size() - 2 * log_det_j) + lambda / 2 * log_det_j * log_det_j;
+
+			energy += val * data.da(p);
+		}
+		return energy;
 	}
 
 	// Compute ∫ ½μ (tr(FᵀF) - 3 - 2ln(J)) + ½λ ln²(J) du
@@ -317,6 +582,9 @@ namespace polyfem::assembler
 		T energy = T(0.0);
 
 		const int n_pts = data.da.size();
+		Eigen::VectorXd lambdas, mus;
+		params_.lambda_mu(data.vals.quadrature.points, data.vals.val, data.t, data.vals.element_id, lambdas, mus);
+
 		for (long p = 0; p < n_pts; ++p)
 		{
 			compute_disp_grad_at_quad(data, local_disp, p, size(), def_grad);
@@ -325,8 +593,8 @@ namespace polyfem::assembler
 			for (int d = 0; d < size(); ++d)
 				def_grad(d, d) += T(1);
 
-			double lambda, mu;
-			params_.lambda_mu(data.vals.quadrature.points.row(p), data.vals.val.row(p), data.t, data.vals.element_id, lambda, mu);
+			const double lambda = lambdas(p);
+			const double mu = mus(p);
 
 			const T log_det_j = log(polyfem::utils::determinant(def_grad));
 			const T val = mu / 2 * ((def_grad.transpose() * def_grad).trace() - size() - 2 * log_det_j) + lambda / 2 * log_det_j * log_det_j;
@@ -368,15 +636,20 @@ namespace polyfem::assembler
 	}
 
 	template <int n_basis, int dim>
-	void NeoHookeanElasticity::compute_energy_aux_gradient_fast(const NonLinearAssemblerData &data, Eigen::Matrix<double, Eigen::Dynamic, 1> &G_flattened) const
+	void NeoHookeanElasticity::compute_energy_aux_gradient_fast(const NonLinearAssemblerData &data, Eigen::Matrix<double, Eigen::Dynamic, 1> &G_flattened, double *energy) const
 	{
 		assert(data.x.cols() == 1);
 
 		const int n_pts = data.da.size();
 
+		// F and the parameters of the same iterate are already in the shared state
+		const MaterialStateBuffer *state = data.material_state && data.material_state->params().cols() == 2 ? data.material_state : nullptr;
+		const int offset = state ? state->offset(data.vals.element_id) : 0;
+		assert(!state || state->n_points(data.vals.element_id) == n_pts);
+
 		Eigen::Matrix<double, n_basis, dim> local_disp(data.vals.basis_values.size(), size());
 		local_disp.setZero();
-		for (size_t i = 0; i < data.vals.basis_values.size(); ++i)
+		for (size_t i = 0; !state && i < data.vals.basis_values.size(); ++i)
 		{
 			const auto &bs = data.vals.basis_values[i];
 			for (size_t ii = 0; ii < bs.global.size(); ++ii)
@@ -392,11 +665,24 @@ namespace polyfem::assembler
 
 		Eigen::Matrix<double, n_basis, dim> G(data.vals.basis_values.size(), size());
 		G.setZero();
+		double energy_sum = 0;
 
-		for (long p = 0; p < n_pts; ++p)
+		Eigen::VectorXd lambdas, mus;
+		if (state)
 		{
-			Eigen::Matrix<double, n_basis, dim> grad(data.vals.basis_values.size(), size());
+			lambdas = state->params().col(0).segment(offset, n_pts);
+			mus = state->params().col(1).segment(offset, n_pts);
+		}
+		else
+			params_.lambda_mu(data.vals.quadrature.points, data.vals.val, data.t, data.vals.element_id, lambdas, mus);
+
+		// per point temporaries, allocated once per element when n_basis is dynamic
+		Eigen::Matrix<double, n_basis, dim> grad(data.vals.basis_values.size(), size());
+		Eigen::Matrix<double, n_basis, dim> delF_delU(data.vals.basis_values.size(), size());
+		Eigen::Matrix<double, n_basis, dim> gradient(data.vals.basis_values.size(), size());
 
+		for (long p = 0; p < n_pts; ++p)
+		{
 			for (size_t i = 0; i < data.vals.basis_values.size(); ++i)
 			{
 				grad.row(i) = data.vals.basis_values[i].grad.row(p);
@@ -405,7 +691,14 @@ namespace polyfem::assembler
 			Eigen::Matrix<double, dim, dim> jac_it = data.vals.jac_it[p];
 
 			// Id + grad d
-			def_grad = local_disp.transpose() * grad * jac_it + Eigen::Matrix<double, dim, dim>::Identity(size(), size());
+			if (state)
+			{
+				for (int j = 0; j < size(); ++j)
+					for (int i = 0; i < size(); ++i)
+						def_grad(i, j) = state->F(offset + p, i, j);
+			}
+			else
+				def_grad = local_disp.transpose() * grad * jac_it + Eigen::Matrix<double, dim, dim>::Identity(size(), size());
 
 			const double J = def_grad.determinant();
 			const double log_det_j = log(J);
@@ -438,19 +731,23 @@ namespace polyfem::assembler
 				delJ_delF.col(2) = cross<dim>(u, v);
 			}
 
-			double lambda, mu;
-			params_.lambda_mu(data.vals.quadrature.points.row(p), data.vals.val.row(p), data.t, data.vals.element_id, lambda, mu);
+			const double lambda = lambdas(p);
+			const double mu = mus(p);
 
-			Eigen::Matrix<double, n_basis, dim> delF_delU = grad * jac_it;
+			delF_delU.noalias() = grad * jac_it;
 
 			Eigen::Matrix<double, dim, dim> gradient_temp = mu * def_grad - mu * (1 / J) * delJ_delF + lambda * log_det_j * (1 / J) * delJ_delF;
-			Eigen::Matrix<double, n_basis, dim> gradient = delF_delU * gradient_temp.transpose();
+			gradient.noalias() = delF_delU * gradient_temp.transpose();
 
-			double val = mu / 2 * ((def_grad.transpose() * def_grad).trace() - size() - 2 * log_det_j) + lambda / 2 * log_det_j * log_det_j;
+			const double val = mu / 2 * ((def_grad.transpose() * def_grad).trace() - size() - 2 * log_det_j) + lambda / 2 * log_det_j * log_det_j;
+			energy_sum += val * data.da(p);
 
 			G.noalias() += gradient * data.da(p);
 		}
 
+		if (energy)
+			*energy = energy_sum;
+
 		Eigen::Matrix<double, dim, n_basis> G_T = G.transpose();
 
 		constexpr int N = (n_basis == Eigen::Dynamic) ? Eigen::Dynamic : n_basis * dim;
@@ -466,9 +763,14 @@ namespace polyfem::assembler
 		constexpr int N = (n_basis == Eigen::Dynamic) ? Eigen::Dynamic : n_basis * dim;
 		const int n_pts = data.da.size();
 
+		// F and the parameters of the same iterate are already in the shared state
+		const MaterialStateBuffer *state = data.material_state && data.material_state->params().cols() == 2 ? data.material_state : nullptr;
+		const int offset = state ? state->offset(data.vals.element_id) : 0;
+		assert(!state || state->n_points(data.vals.element_id) == n_pts);
+
 		Eigen::Matrix<double, n_basis, dim> local_disp(data.vals.basis_values.size(), size());
 		local_disp.setZero();
-		for (size_t i = 0; i < data.vals.basis_values.size(); ++i)
+		for (size_t i = 0; !state && i < data.vals.basis_values.size(); ++i)
 		{
 			const auto &bs = data.vals.basis_values[i];
 			for (size_t ii = 0; ii < bs.global.size(); ++ii)
@@ -482,10 +784,22 @@ namespace polyfem::assembler
 
 		Eigen::Matrix<double, dim, dim> def_grad(size(), size());
 
-		for (long p = 0; p < n_pts; ++p)
+		Eigen::VectorXd lambdas, mus;
+		if (state)
 		{
-			Eigen::Matrix<double, n_basis, dim> grad(data.vals.basis_values.size(), size());
+			lambdas = state->params().col(0).segment(offset, n_pts);
+			mus = state->params().col(1).segment(offset, n_pts);
+		}
+		else
+			params_.lambda_mu(data.vals.quadrature.points, data.vals.val, data.t, data.vals.element_id, lambdas, mus);
 
+		// per point temporaries, allocated once per element when n_basis is dynamic
+		Eigen::Matrix<double, n_basis, dim> grad(data.vals.basis_values.size(), size());
+		Eigen::Matrix<double, dim * dim, N> delF_delU_tensor(size() * size(), grad.size());
+		Eigen::Matrix<double, dim * dim, N> hessian_delF_delU(size() * size(), grad.size());
+
+		for (long p = 0; p < n_pts; ++p)
+		{
 			for (size_t i = 0; i < data.vals.basis_values.size(); ++i)
 			{
 				grad.row(i) = data.vals.basis_values[i].grad.row(p);
@@ -494,7 +808,14 @@ namespace polyfem::assembler
 			Eigen::Matrix<double, dim, dim> jac_it = data.vals.jac_it[p];
 
 			// Id + grad d
-			def_grad = local_disp.transpose() * grad * jac_it + Eigen::Matrix<double, dim, dim>::Identity(size(), size());
+			if (state)
+			{
+				for (int j = 0; j < size(); ++j)
+					for (int i = 0; i < size(); ++i)
+						def_grad(i, j) = state->F(offset + p, i, j);
+			}
+			else
+				def_grad = local_disp.transpose() * grad * jac_it + Eigen::Matrix<double, dim, dim>::Identity(size(), size());
 
 			const double J = def_grad.determinant();
 			double log_det_j = log(J);
@@ -538,8 +859,8 @@ namespace polyfem::assembler
 				del2J_delF2.template block<dim, dim>(6, 3) = hat<dim>(u);
 			}
 
-			double lambda, mu;
-			params_.lambda_mu(data.vals.quadrature.points.row(p), data.vals.val.row(p), data.t, data.vals.element_id, lambda, mu);
+			const double lambda = lambdas(p);
+			const double mu = mus(p);
 
 			Eigen::Matrix<double, dim * dim, dim * dim> id = Eigen::Matrix<double, dim * dim, dim * dim>::Identity(size() * size(), size() * size());
 
@@ -547,8 +868,6 @@ namespace polyfem::assembler
 
 			Eigen::Matrix<double, dim * dim, dim * dim> hessian_temp = (mu * id) + (((mu + lambda * (1 - log_det_j)) / (J * J)) * (g_j * g_j.transpose())) + (((lambda * log_det_j - mu) / (J)) * del2J_delF2);
 
-			Eigen::Matrix<double, dim * dim, N> delF_delU_tensor(jac_it.size(), grad.size());
-
 			for (size_t i = 0; i < local_disp.rows(); ++i)
 			{
 				for (size_t j = 0; j < local_disp.cols(); ++j)
@@ -562,11 +881,8 @@ namespace polyfem::assembler
 				}
 			}
 
-			Eigen::Matrix<double, N, N> hessian = delF_delU_tensor.transpose() * hessian_temp * delF_delU_tensor;
-
-			double val = mu / 2 * ((def_grad.transpose() * def_grad).trace() - size() - 2 * log_det_j) + lambda / 2 * log_det_j * log_det_j;
-
-			H += hessian * data.da(p);
+			hessian_delF_delU.noalias() = hessian_temp * delF_delU_tensor;
+			H.noalias() += data.da(p) * (delF_delU_tensor.transpose() * hessian_delF_delU);
 		}
 	}
 
@@ -17,10 +17,81 @@ namespace polyfem::assembler
 		using NLAssembler::assemble_gradient;
 		using NLAssembler::assemble_hessian;
 
+		// energy and gradient assembly calling the element kernels below without virtual dispatch
+		double assemble_energy(
+			const bool is_volume,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev) const override;
+
+		void assemble_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			Eigen::MatrixXd &rhs) const override;
+
+		void assemble_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			Eigen::MatrixXd &rhs) const override;
+
+		double assemble_energy_and_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			Eigen::MatrixXd &rhs) const override;
+
+		double assemble_energy_and_gradient(
+			const bool is_volume,
+			const int n_basis,
+			const std::vector<basis::ElementBases> &bases,
+			const std::vector<basis::ElementBases> &gbases,
+			const AssemblyValsCache &cache,
+			const double t,
+			const double dt,
+			const Eigen::MatrixXd &displacement,
+			const Eigen::MatrixXd &displacement_prev,
+			const utils::ElementColoring &coloring,
+			Eigen::MatrixXd &rhs) const override;
+
 		// energy, gradient, and hessian used in newton method
 		double compute_energy(const NonLinearAssemblerData &data) const override;
 		Eigen::VectorXd assemble_gradient(const NonLinearAssemblerData &data) const override;
 		Eigen::MatrixXd assemble_hessian(const NonLinearAssemblerData &data) const override;
+		// the energy is a by-product of the gradient kernel
+		double compute_energy_and_gradient(const NonLinearAssemblerData &data, Eigen::VectorXd &gradient) const override;
+
+		// batched kernels, lambda and mu are the two material params of the batch
+		bool has_batched_kernels() const override { return true; }
+		void compute_batch_params(const ElementAssemblyValues &vals, const double t, Eigen::MatrixXd &params) const override;
+		void compute_energy_batch(const TriangleBatch &batch, TriangleBatch::Lane &energy) const override;
+		void compute_energy_batch(const TetBatch &batch, TetBatch::Lane &energy) const override;
+		void compute_gradient_batch(const TriangleBatch &batch, TriangleBatch::LaneDofs &gradient) const override;
+		void compute_gradient_batch(const TetBatch &batch, TetBatch::LaneDofs &gradient) const override;
 
 		// rhs for fabbricated solution, compute with automatic sympy code
 		VectorNd compute_rhs(const AutodiffHessianPt &pt) const override;
@@ -79,6 +150,8 @@ namespace polyfem::assembler
 		template <int n_basis, int dim>
 		void compute_energy_hessian_aux_fast(const NonLinearAssemblerData &data, Eigen::MatrixXd &H) const;
 		template <int n_basis, int dim>
-		void compute_energy_aux_gradient_fast(const NonLinearAssemblerData &data, Eigen::VectorXd &G_flattened) const;
+		void compute_energy_aux_gradient_fast(const NonLinearAssemblerData &data, Eigen::VectorXd &G_flattened, double *energy = nullptr) const;
+		// dispatches to compute_energy_aux_gradient_fast on the number of local bases, energy can be nullptr
+		void compute_energy_gradient(const NonLinearAssemblerData &data, Eigen::VectorXd &gradient, double *energy) const;
 	};
 } // namespace polyfem::assembler
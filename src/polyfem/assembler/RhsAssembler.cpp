@@ -67,14 +67,14 @@ namespace polyfem
 				Eigen::MatrixXd rhs_fun;
 
 				const int n_elements = int(bases_.size());
-				ElementAssemblyValues vals;
+				ElementAssemblyValues tmp_vals;
 				for (int e = 0; e < n_elements; ++e)
 				{
 					// vals.compute(e, mesh_.is_volume(), bases_[e], gbases_[e]);
 
 					// compute geometric mapping
 					// evaluate and store basis functions/their gradients at quadrature points
-					ass_vals_cache_.compute(e, mesh_.is_volume(), bases_[e], gbases_[e], vals);
+					const ElementAssemblyValues &vals = ass_vals_cache_.get(e, mesh_.is_volume(), bases_[e], gbases_[e], tmp_vals);
 
 					const Quadrature &quadrature = vals.quadrature;
 
@@ -232,13 +232,19 @@ namespace polyfem
 			}
 		}
 
-		void RhsAssembler::lsq_bc(const std::function<void(const Eigen::MatrixXi &, const Eigen::MatrixXd &, const Eigen::MatrixXd &, Eigen::MatrixXd &)> &df,
-								  const std::vector<LocalBoundary> &local_boundary, const std::vector<int> &bounday_nodes, const int resolution, Eigen::MatrixXd &rhs) const
+		void RhsAssembler::build_lsq_bc_cache(const std::vector<LocalBoundary> &local_boundary, std::vector<int> &&boundary_key, const std::vector<int> &bounday_nodes, const int resolution) const
 		{
+			LSQBCCache &cache = lsq_bc_cache_;
+			cache.boundary_key = std::move(boundary_key);
+			cache.boundary_nodes = bounday_nodes;
+			cache.resolution = resolution;
+			cache.samples.clear();
+			cache.systems.clear();
+
 			const int n_el = int(bases_.size());
 
-			Eigen::MatrixXd uv, samples, gtmp, rhs_fun;
-			Eigen::VectorXi global_primitive_ids;
+			Eigen::MatrixXd samples;
+			std::vector<std::vector<AssemblyValues>> sample_vals;
 
 			const int actual_dim = problem_.is_scalar() ? 1 : mesh_.dimension();
 
@@ -256,46 +262,59 @@ namespace polyfem
 			}
 			assert(skipped_count <= 1);
 
-			for (int d = 0; d < size_; ++d)
+			std::vector<int> sample_elements;
+			for (const auto &lb : local_boundary)
 			{
-				int index = 0;
-				std::vector<int> indices;
-				indices.reserve(n_el * 10);
-				std::vector<int> tags;
-				tags.reserve(n_el * 10);
+				const int e = lb.element_id();
+				LSQBCCache::Samples s;
+				bool has_samples = utils::BoundarySampler::sample_boundary(lb, resolution, mesh_, false, s.uv, samples, s.global_primitive_ids);
 
-				long total_size = 0;
+				if (!has_samples)
+					continue;
 
-				Eigen::VectorXi global_index_to_col(n_basis_);
-				global_index_to_col.setConstant(-1);
+				assert(s.global_primitive_ids.size() == samples.rows());
+				gbases_[e].eval_geom_mapping(samples, s.mapped);
 
-				std::vector<AssemblyValues> tmp_val;
+				sample_vals.emplace_back();
+				bases_[e].evaluate_bases(samples, sample_vals.back());
 
-				for (const auto &lb : local_boundary)
-				{
-					const int e = lb.element_id();
-					bool has_samples = utils::BoundarySampler::sample_boundary(lb, resolution, mesh_, true, uv, samples, global_primitive_ids);
+				sample_elements.push_back(e);
+				cache.samples.push_back(std::move(s));
+			}
 
-					if (!has_samples)
-						continue;
+			// if all dimensions are Dirichlet the system is the same for all of them
+			const int n_systems = problem_.all_dimensions_dirichlet() ? 1 : size_;
+			cache.systems.resize(n_systems);
 
-					const basis::ElementBases &bs = bases_[e];
-					bs.evaluate_bases(samples, tmp_val);
+			for (int d = 0; d < n_systems; ++d)
+			{
+				LSQBCCache::System &system = cache.systems[d];
+
+				int index = 0;
+				system.indices.reserve(n_el * 10);
+				system.tags.reserve(n_el * 10);
+
+				Eigen::VectorXi global_index_to_col(n_basis_);
+				global_index_to_col.setConstant(-1);
+
+				for (size_t k = 0; k < cache.samples.size(); ++k)
+				{
+					const basis::ElementBases &bs = bases_[sample_elements[k]];
+					const Eigen::VectorXi &global_primitive_ids = cache.samples[k].global_primitive_ids;
 					const int n_local_bases = int(bs.bases.size());
-					assert(global_primitive_ids.size() == samples.rows());
 
-					for (int s = 0; s < samples.rows(); ++s)
+					for (int s = 0; s < global_primitive_ids.size(); ++s)
 					{
 						const int tag = mesh_.get_boundary_id(global_primitive_ids(s));
 						if (!problem_.all_dimensions_dirichlet() && !problem_.is_dimension_dirichet(tag, d))
 							continue;
 
-						total_size++;
+						system.rows.emplace_back(int(k), s);
 
 						for (int j = 0; j < n_local_bases; ++j)
 						{
 							const basis::Basis &b = bs.bases[j];
-							const double tmp = tmp_val[j].val(s);
+							const double tmp = sample_vals[k][j].val(s);
 
 							if (fabs(tmp) < 1e-10)
 								continue;
@@ -308,9 +327,9 @@ namespace polyfem
 									if (global_index_to_col(b.global()[ii].index) == -1)
 									{
 										global_index_to_col(b.global()[ii].index) = index++;
-										indices.push_back(b.global()[ii].index);
-										tags.push_back(tag);
-										assert(indices.size() == size_t(index));
+										system.indices.push_back(b.global()[ii].index);
+										system.tags.push_back(tag);
+										assert(system.indices.size() == size_t(index));
 									}
 								}
 							}
@@ -318,104 +337,103 @@ namespace polyfem
 					}
 				}
 
-				Eigen::MatrixXd global_rhs = Eigen::MatrixXd::Zero(total_size, 1);
+				const long total_size = system.rows.size();
+				if (total_size == 0)
+					continue;
 
-				const long buffer_size = total_size * long(indices.size());
 				std::vector<Eigen::Triplet<double>> entries, entries_t;
 
-				index = 0;
-
-				int global_counter = 0;
-				Eigen::MatrixXd mapped;
-
-				for (const auto &lb : local_boundary)
+				for (long r = 0; r < total_size; ++r)
 				{
-					const int e = lb.element_id();
-					bool has_samples = utils::BoundarySampler::sample_boundary(lb, resolution, mesh_, false, uv, samples, global_primitive_ids);
-
-					if (!has_samples)
-						continue;
-
-					const basis::ElementBases &bs = bases_[e];
-					const basis::ElementBases &gbs = gbases_[e];
+					const int k = system.rows[r].first;
+					const int s = system.rows[r].second;
+					const basis::ElementBases &bs = bases_[sample_elements[k]];
 					const int n_local_bases = int(bs.bases.size());
 
-					gbs.eval_geom_mapping(samples, mapped);
-
-					bs.evaluate_bases(samples, tmp_val);
-					df(global_primitive_ids, uv, mapped, rhs_fun);
-
-					for (int s = 0; s < samples.rows(); ++s)
+					for (int j = 0; j < n_local_bases; ++j)
 					{
-						const int tag = mesh_.get_boundary_id(global_primitive_ids(s));
-						if (!problem_.all_dimensions_dirichlet() && !problem_.is_dimension_dirichet(tag, d))
-							continue;
+						const basis::Basis &b = bs.bases[j];
+						const double tmp = sample_vals[k][j].val(s);
 
-						for (int j = 0; j < n_local_bases; ++j)
+						for (std::size_t ii = 0; ii < b.global().size(); ++ii)
 						{
-							const basis::Basis &b = bs.bases[j];
-							const double tmp = tmp_val[j].val(s);
-
-							for (std::size_t ii = 0; ii < b.global().size(); ++ii)
+							auto item = global_index_to_col(b.global()[ii].index);
+							if (item != -1)
 							{
-								auto item = global_index_to_col(b.global()[ii].index);
-								if (item != -1)
-								{
-									entries.push_back(Eigen::Triplet<double>(global_counter, item, tmp * b.global()[ii].val));
-									entries_t.push_back(Eigen::Triplet<double>(item, global_counter, tmp * b.global()[ii].val));
-								}
+								entries.push_back(Eigen::Triplet<double>(r, item, tmp * b.global()[ii].val));
+								entries_t.push_back(Eigen::Triplet<double>(item, r, tmp * b.global()[ii].val));
 							}
 						}
-
-						global_rhs(global_counter) = rhs_fun(s, d);
-						global_counter++;
 					}
 				}
 
-				assert(global_counter == total_size);
+				StiffnessMatrix mat(int(total_size), int(system.indices.size()));
+				mat.setFromTriplets(entries.begin(), entries.end());
 
-				if (total_size > 0)
-				{
-					const double mmin = global_rhs.minCoeff();
-					const double mmax = global_rhs.maxCoeff();
+				system.mat_t.resize(int(system.indices.size()), int(total_size));
+				system.mat_t.setFromTriplets(entries_t.begin(), entries_t.end());
 
-					if (fabs(mmin) < 1e-8 && fabs(mmax) < 1e-8)
-					{
-						for (size_t i = 0; i < indices.size(); ++i)
-						{
-							const int tag = tags[i];
-							if (problem_.all_dimensions_dirichlet() || problem_.is_dimension_dirichet(tag, d))
-								rhs(indices[i] * size_ + d) = 0;
-						}
-					}
-					else
-					{
-						StiffnessMatrix mat(int(total_size), int(indices.size()));
-						mat.setFromTriplets(entries.begin(), entries.end());
+				system.A = system.mat_t * mat;
+			}
+		}
+
+		void RhsAssembler::lsq_bc(const std::function<void(const Eigen::MatrixXi &, const Eigen::MatrixXd &, const Eigen::MatrixXd &, Eigen::MatrixXd &)> &df,
+								  const std::vector<LocalBoundary> &local_boundary, const std::vector<int> &bounday_nodes, const int resolution, Eigen::MatrixXd &rhs) const
+		{
+			// nothing to fit, do not evict the cached boundary
+			if (local_boundary.empty())
+				return;
+
+			LSQBCCache &cache = lsq_bc_cache_;
+			std::vector<int> boundary_key = LSQBCCache::key(local_boundary);
+			if (!cache.is_valid_for(boundary_key, bounday_nodes, resolution))
+				build_lsq_bc_cache(local_boundary, std::move(boundary_key), bounday_nodes, resolution);
 
-						StiffnessMatrix mat_t(int(indices.size()), int(total_size));
-						mat_t.setFromTriplets(entries_t.begin(), entries_t.end());
+			std::vector<Eigen::MatrixXd> rhs_funs(cache.samples.size());
+			for (size_t k = 0; k < cache.samples.size(); ++k)
+			{
+				const LSQBCCache::Samples &s = cache.samples[k];
+				df(s.global_primitive_ids, s.uv, s.mapped, rhs_funs[k]);
+			}
 
-						StiffnessMatrix A = mat_t * mat;
-						Eigen::VectorXd b = mat_t * global_rhs;
+			for (int d = 0; d < size_; ++d)
+			{
+				LSQBCCache::System &system = cache.systems[cache.systems.size() == 1 ? 0 : d];
 
-						Eigen::VectorXd coeffs(b.rows(), 1);
-						auto solver = linear::Solver::create(solver_params_, logger());
-						logger().info("Solve RHS using {} linear solver", solver->name());
-						solver->analyze_pattern(A, A.rows());
-						solver->factorize(A);
-						coeffs.setZero();
-						solver->solve(b, coeffs);
+				const long total_size = system.rows.size();
+				if (total_size == 0)
+					continue;
 
-						logger().trace("RHS solve error {}", (A * coeffs - b).norm());
+				Eigen::VectorXd global_rhs(total_size);
+				for (long r = 0; r < total_size; ++r)
+					global_rhs(r) = rhs_funs[system.rows[r].first](system.rows[r].second, d);
 
-						for (long i = 0; i < coeffs.rows(); ++i)
-						{
-							const int tag = tags[i];
-							if (problem_.all_dimensions_dirichlet() || problem_.is_dimension_dirichet(tag, d))
-								rhs(indices[i] * size_ + d) = coeffs(i);
-						}
+				Eigen::VectorXd coeffs = Eigen::VectorXd::Zero(system.indices.size());
+
+				const double mmin = global_rhs.minCoeff();
+				const double mmax = global_rhs.maxCoeff();
+
+				if (fabs(mmin) >= 1e-8 || fabs(mmax) >= 1e-8)
+				{
+					if (!system.solver)
+					{
+						system.solver = linear::Solver::create(solver_params_, logger());
+						logger().info("Solve RHS using {} linear solver", system.solver->name());
+						system.solver->analyze_pattern(system.A, system.A.rows());
+						system.solver->factorize(system.A);
 					}
+
+					const Eigen::VectorXd b = system.mat_t * global_rhs;
+					system.solver->solve(b, coeffs);
+
+					logger().trace("RHS solve error {}", (system.A * coeffs - b).norm());
+				}
+
+				for (long i = 0; i < coeffs.rows(); ++i)
+				{
+					const int tag = system.tags[i];
+					if (problem_.all_dimensions_dirichlet() || problem_.is_dimension_dirichet(tag, d))
+						rhs(system.indices[i] * size_ + d) = coeffs(i);
 				}
 			}
 		}
@@ -757,12 +775,11 @@ namespace polyfem
 
 					for (int e = start; e < end; ++e)
 					{
-						ElementAssemblyValues &vals = local_storage.vals;
 						// vals.compute(e, mesh_.is_volume(), bases_[e], gbases_[e]);
-						ass_vals_cache_.compute(e, mesh_.is_volume(), bases_[e], gbases_[e], vals);
+						const ElementAssemblyValues &vals = ass_vals_cache_.get(e, mesh_.is_volume(), bases_[e], gbases_[e], local_storage.vals);
 
 						const Quadrature &quadrature = vals.quadrature;
-						const Eigen::VectorXd da = vals.det.array() * quadrature.weights.array();
+						const QuadratureVector da = vals.det.array() * quadrature.weights.array();
 
 						problem_.rhs(assembler_, vals.val, t, forces);
 						assert(forces.rows() == da.size());
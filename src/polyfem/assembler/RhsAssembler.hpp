@@ -7,6 +7,10 @@
 #include <polyfem/assembler/MatParams.hpp>
 #include <polyfem/mesh/LocalBoundary.hpp>
 
+#include <polysolve/linear/Solver.hpp>
+
+#include <memory>
+
 namespace polyfem
 {
 	namespace assembler
@@ -88,10 +92,14 @@ namespace polyfem
 			inline const Assembler &assembler() const { return assembler_; }
 
 		private:
-			// leastsquares fit bc
+			// leastsquares fit bc, the sampling and the factorization are cached in lsq_bc_cache_
+			// the fitted function is evaluated and solved at every call
 			void lsq_bc(const std::function<void(const Eigen::MatrixXi &, const Eigen::MatrixXd &, const Eigen::MatrixXd &, Eigen::MatrixXd &)> &df,
 						const std::vector<mesh::LocalBoundary> &local_boundary, const std::vector<int> &bounday_nodes, const int resolution, Eigen::MatrixXd &rhs) const;
 
+			// builds the sampling and the normal equations of the leastsquares fit
+			void build_lsq_bc_cache(const std::vector<mesh::LocalBoundary> &local_boundary, std::vector<int> &&boundary_key, const std::vector<int> &bounday_nodes, const int resolution) const;
+
 			// integrate bc
 			void integrate_bc(const std::function<void(const Eigen::MatrixXi &, const Eigen::MatrixXd &, const Eigen::MatrixXd &, Eigen::MatrixXd &)> &df,
 							  const std::vector<mesh::LocalBoundary> &local_boundary, const std::vector<int> &bounday_nodes, const int resolution, Eigen::MatrixXd &rhs) const;
@@ -129,6 +137,60 @@ namespace polyfem
 			const std::vector<RowVectorNd> &dirichlet_nodes_position_;
 			const std::vector<int> &neumann_nodes_;
 			const std::vector<RowVectorNd> &neumann_nodes_position_;
+
+			/// Cached data of the leastsquares Dirichlet fit, it depends only on the boundary and on the bases.
+			/// The fitted function may change between calls (time, update_dirichlet_boundary), so the right-hand
+			/// side is evaluated and solved every time, only the sampling and the factorization are reused.
+			struct LSQBCCache
+			{
+				/// Boundary samples of one local boundary
+				struct Samples
+				{
+					Eigen::VectorXi global_primitive_ids;
+					Eigen::MatrixXd uv;
+					Eigen::MatrixXd mapped;
+				};
+
+				/// Normal equations for one (or all, if all dimensions are Dirichlet) dimension
+				struct System
+				{
+					std::vector<int> indices;                ///< global basis index of every column
+					std::vector<int> tags;                   ///< boundary tag of every column
+					std::vector<std::pair<int, int>> rows;   ///< (samples block, sample) of every row
+					StiffnessMatrix mat_t;                   ///< transposed sampled bases
+					StiffnessMatrix A;                       ///< mat_t * mat
+					std::unique_ptr<polysolve::linear::Solver> solver; ///< factorization of A, created on first non-zero rhs
+				};
+
+				/// element, type, and local primitives of every local boundary, the cache is keyed on the content
+				/// since the callers pass temporaries
+				std::vector<int> boundary_key;
+				std::vector<int> boundary_nodes;
+				int resolution = -1;
+
+				std::vector<Samples> samples;
+				std::vector<System> systems;
+
+				static std::vector<int> key(const std::vector<mesh::LocalBoundary> &lb)
+				{
+					std::vector<int> res;
+					for (const mesh::LocalBoundary &b : lb)
+					{
+						res.push_back(b.element_id());
+						res.push_back(int(b.type()));
+						res.push_back(b.size());
+						for (int i = 0; i < b.size(); ++i)
+							res.push_back(b[i]);
+					}
+					return res;
+				}
+
+				bool is_valid_for(const std::vector<int> &lb_key, const std::vector<int> &nodes, const int res) const
+				{
+					return resolution == res && boundary_key == lb_key && boundary_nodes == nodes;
+				}
+			};
+			mutable LSQBCCache lsq_bc_cache_;
 		};
 	} // namespace assembler
 } // namespace polyfem
@@ -38,6 +38,17 @@ namespace polyfem
 			// or directly in the object domain (harmonic bases)
 			bool has_parameterization = true;
 
+			/// Elements with the same non-negative key have the same basis functions on the reference element
+			/// (Lagrange bases of the same element type and order), so their reference evaluations can be shared.
+			/// -1 if the bases are specific to the element (splines, polygons, rational bases).
+			int reference_key = -1;
+
+			/// reference key of the Lagrange bases of the given element type and order
+			static int lagrange_reference_key(const bool is_simplex, const int order, const bool serendipity)
+			{
+				return 4 * order + (serendipity ? 2 : 0) + (is_simplex ? 1 : 0);
+			}
+
 			/// @brief Map the sample positions in the parametric domain to the object domain (if the element has no parameterization, e.g. harmonic bases, then the parametric domain = object domain,
 			/// and the mapping is identity)
 			///
@@ -796,6 +796,8 @@ int LagrangeBasis2d::build_bases(
 				b.bases[j].set_basis([dtmp, j](const Eigen::MatrixXd &uv, Eigen::MatrixXd &val) { autogen::q_basis_value_2d(dtmp, j, uv, val); });
 				b.bases[j].set_grad([dtmp, j](const Eigen::MatrixXd &uv, Eigen::MatrixXd &val) { autogen::q_grad_basis_value_2d(dtmp, j, uv, val); });
 			}
+
+			b.reference_key = ElementBases::lagrange_reference_key(false, discr_order, serendipity);
 		}
 		else if (mesh.is_simplex(e))
 		{
@@ -825,6 +827,8 @@ int LagrangeBasis2d::build_bases(
 			});
 
 			const bool rational = is_geom_bases && mesh.is_rational() && !mesh.cell_weights(e).empty();
+			if (!rational)
+				b.reference_key = ElementBases::lagrange_reference_key(true, discr_order, false);
 
 			for (int j = 0; j < n_el_bases; ++j)
 			{
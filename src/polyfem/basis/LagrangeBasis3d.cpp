@@ -1,6 +1,7 @@
 
 ////////////////////////////////////////////////////////////////////////////////
 #include "LagrangeBasis3d.hpp"
+#include "TensorProductBases.hpp"
 
 #include <polyfem/mesh/MeshNodes.hpp>
 #include <polyfem/quadrature/TetQuadrature.hpp>
@@ -1442,6 +1443,10 @@ int LagrangeBasis3d::build_bases(
 	std::vector<int> interface_elements;
 	interface_elements.reserve(mesh.n_faces());
 
+	// sum-factorized evaluation of the Q_n bases, shared by all hexes of the same order.
+	// The autogen Q1 bases are already factored products and are faster for linear hexes.
+	std::map<int, std::shared_ptr<const TensorProductBases3d>> tensor_bases;
+
 	for (int e = 0; e < mesh.n_cells(); ++e)
 	{
 		ElementBases &b = bases[e];
@@ -1504,6 +1509,19 @@ int LagrangeBasis3d::build_bases(
 				b.bases[j].set_basis([dtmp, j](const Eigen::MatrixXd &uv, Eigen::MatrixXd &val) { autogen::q_basis_value_3d(dtmp, j, uv, val); });
 				b.bases[j].set_grad([dtmp, j](const Eigen::MatrixXd &uv, Eigen::MatrixXd &val) { autogen::q_grad_basis_value_3d(dtmp, j, uv, val); });
 			}
+
+			b.reference_key = ElementBases::lagrange_reference_key(false, discr_order, serendipity);
+
+			if (!serendipity && discr_order >= 2)
+			{
+				std::shared_ptr<const TensorProductBases3d> &tensor = tensor_bases[discr_order];
+				if (!tensor)
+					tensor = std::make_shared<const TensorProductBases3d>(discr_order);
+				assert(tensor->n_bases() == n_el_bases);
+
+				b.set_bases_func([tensor](const Eigen::MatrixXd &uv, std::vector<AssemblyValues> &val) { tensor->evaluate_bases(uv, val); });
+				b.set_grads_func([tensor](const Eigen::MatrixXd &uv, std::vector<AssemblyValues> &val) { tensor->evaluate_grads(uv, val); });
+			}
 		}
 		else if (mesh.is_simplex(e))
 		{
@@ -1535,6 +1553,7 @@ int LagrangeBasis3d::build_bases(
 
 			const bool rational = is_geom_bases && mesh.is_rational() && !mesh.cell_weights(e).empty();
 			assert(!rational);
+			b.reference_key = ElementBases::lagrange_reference_key(true, discr_order, false);
 
 			for (int j = 0; j < n_el_bases; ++j)
 			{
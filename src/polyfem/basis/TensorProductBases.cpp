@@ -0,0 +1,141 @@
+#include "TensorProductBases.hpp"
+
+#include <polyfem/autogen/auto_q_bases.hpp>
+
+#include <cassert>
+#include <cmath>
+
+namespace polyfem
+{
+	using namespace assembler;
+
+	namespace basis
+	{
+		TensorProductBases3d::TensorProductBases3d(const int order)
+			: order_(order)
+		{
+			assert(order >= 1);
+
+			const int n_1d = order + 1;
+			nodes_1d_.resize(n_1d);
+			for (int i = 0; i < n_1d; ++i)
+				nodes_1d_(i) = double(i) / order;
+
+			inv_denominators_.resize(n_1d);
+			for (int i = 0; i < n_1d; ++i)
+			{
+				double denominator = 1;
+				for (int m = 0; m < n_1d; ++m)
+				{
+					if (m != i)
+						denominator *= nodes_1d_(i) - nodes_1d_(m);
+				}
+				inv_denominators_(i) = 1. / denominator;
+			}
+
+			// the autogen bases are ordered by vertices, edges, faces and interior,
+			// recover the tensor index of every basis from its node
+			Eigen::MatrixXd nodes;
+			autogen::q_nodes_3d(order, nodes);
+			indices_.resize(nodes.rows(), 3);
+			for (int i = 0; i < nodes.rows(); ++i)
+			{
+				for (int d = 0; d < 3; ++d)
+				{
+					indices_(i, d) = int(std::round(nodes(i, d) * order));
+					assert(std::abs(nodes_1d_(indices_(i, d)) - nodes(i, d)) < 1e-10);
+				}
+			}
+		}
+
+		void TensorProductBases3d::lagrange_1d(const Eigen::VectorXd &x, Eigen::MatrixXd &val, Eigen::MatrixXd *der) const
+		{
+			const int n_1d = order_ + 1;
+			const int n_pts = int(x.size());
+
+			val.resize(n_pts, n_1d);
+			if (der)
+				der->resize(n_pts, n_1d);
+
+			for (int i = 0; i < n_1d; ++i)
+			{
+				for (int p = 0; p < n_pts; ++p)
+				{
+					// running product rule, (v * (x - x_m))' = v' * (x - x_m) + v
+					double v = inv_denominators_(i);
+					double d = 0;
+					for (int m = 0; m < n_1d; ++m)
+					{
+						if (m == i)
+							continue;
+						const double diff = x(p) - nodes_1d_(m);
+						d = d * diff + v;
+						v *= diff;
+					}
+
+					val(p, i) = v;
+					if (der)
+						(*der)(p, i) = d;
+				}
+			}
+		}
+
+		void TensorProductBases3d::evaluate_bases(const Eigen::MatrixXd &uv, std::vector<AssemblyValues> &basis_values) const
+		{
+			assert(uv.cols() == 3);
+			const int n_1d = order_ + 1;
+
+			Eigen::MatrixXd lx, ly, lz;
+			lagrange_1d(uv.col(0), lx, nullptr);
+			lagrange_1d(uv.col(1), ly, nullptr);
+			lagrange_1d(uv.col(2), lz, nullptr);
+
+			// contract x and y once, then z for every basis
+			Eigen::MatrixXd lxy(uv.rows(), n_1d * n_1d);
+			for (int ix = 0; ix < n_1d; ++ix)
+				for (int iy = 0; iy < n_1d; ++iy)
+					lxy.col(ix * n_1d + iy) = lx.col(ix).cwiseProduct(ly.col(iy));
+
+			basis_values.resize(n_bases());
+			for (int i = 0; i < n_bases(); ++i)
+				basis_values[i].val = lxy.col(indices_(i, 0) * n_1d + indices_(i, 1)).cwiseProduct(lz.col(indices_(i, 2)));
+		}
+
+		void TensorProductBases3d::evaluate_grads(const Eigen::MatrixXd &uv, std::vector<AssemblyValues> &basis_values) const
+		{
+			assert(uv.cols() == 3);
+			const int n_1d = order_ + 1;
+			const int n_pts = int(uv.rows());
+
+			Eigen::MatrixXd lx, ly, lz, dx, dy, dz;
+			lagrange_1d(uv.col(0), lx, &dx);
+			lagrange_1d(uv.col(1), ly, &dy);
+			lagrange_1d(uv.col(2), lz, &dz);
+
+			Eigen::MatrixXd lxy(n_pts, n_1d * n_1d), dxy(n_pts, n_1d * n_1d), xdy(n_pts, n_1d * n_1d);
+			for (int ix = 0; ix < n_1d; ++ix)
+			{
+				for (int iy = 0; iy < n_1d; ++iy)
+				{
+					const int k = ix * n_1d + iy;
+					lxy.col(k) = lx.col(ix).cwiseProduct(ly.col(iy));
+					dxy.col(k) = dx.col(ix).cwiseProduct(ly.col(iy));
+					xdy.col(k) = lx.col(ix).cwiseProduct(dy.col(iy));
+				}
+			}
+
+			basis_values.resize(n_bases());
+			for (int i = 0; i < n_bases(); ++i)
+			{
+				const int k = indices_(i, 0) * n_1d + indices_(i, 1);
+				const int iz = indices_(i, 2);
+
+				Eigen::MatrixXd &grad = basis_values[i].grad;
+				grad.resize(n_pts, 3);
+				grad.col(0) = dxy.col(k).cwiseProduct(lz.col(iz));
+				grad.col(1) = xdy.col(k).cwiseProduct(lz.col(iz));
+				grad.col(2) = lxy.col(k).cwiseProduct(dz.col(iz));
+			}
+		}
+	} // namespace basis
+} // namespace polyfem
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <polyfem/assembler/AssemblyValues.hpp>
+
+#include <Eigen/Dense>
+
+#include <vector>
+
+namespace polyfem
+{
+	namespace basis
+	{
+		/// @brief Sum-factorized evaluation of the Q_n Lagrange bases on the reference hexahedron.
+		///
+		/// Every Q_n basis is the product of three 1D Lagrange polynomials on the equispaced nodes {0, 1/n, ..., 1}.
+		/// The 1D polynomials are tabulated once per coordinate of the evaluation points and the 3D values are
+		/// obtained by contracting the tables one dimension at a time (x, then y, then z), instead of evaluating
+		/// every expanded polynomial of autogen::q_basis_value_3d independently.
+		/// The local ordering of the bases is the same as in autogen::q_nodes_3d.
+		class TensorProductBases3d
+		{
+		public:
+			/// @param[in] order order n >= 1 of the Q_n bases (serendipity bases are not tensor products)
+			explicit TensorProductBases3d(const int order);
+
+			int order() const { return order_; }
+			int n_bases() const { return int(indices_.rows()); }
+
+			/// evaluates the bases at the points uv (#uv x 3) and saves them in basis_values[i].val
+			void evaluate_bases(const Eigen::MatrixXd &uv, std::vector<assembler::AssemblyValues> &basis_values) const;
+			/// evaluates the gradients of the bases at the points uv and saves them in basis_values[i].grad
+			void evaluate_grads(const Eigen::MatrixXd &uv, std::vector<assembler::AssemblyValues> &basis_values) const;
+
+			/// @brief 1D Lagrange polynomials and their derivatives at the points x
+			///
+			/// @param[in] x points in [0, 1]
+			/// @param[out] val #x x (n+1) values, val(p, i) = L_i(x_p)
+			/// @param[out] der #x x (n+1) derivatives, may be nullptr
+			void lagrange_1d(const Eigen::VectorXd &x, Eigen::MatrixXd &val, Eigen::MatrixXd *der) const;
+
+		private:
+			int order_;
+			Eigen::VectorXd nodes_1d_;
+			Eigen::VectorXd inv_denominators_;
+			/// tensor index (ix, iy, iz) of every local basis
+			Eigen::Matrix<int, Eigen::Dynamic, 3> indices_;
+		};
+	} // namespace basis
+} // namespace polyfem
@@ -0,0 +1,93 @@
+#include "AsyncWriter.hpp"
+
+#include <polyfem/utils/Logger.hpp>
+
+#include <algorithm>
+#include <exception>
+
+namespace polyfem::io
+{
+	AsyncWriter::AsyncWriter(const int n_threads, const int max_queued)
+		: max_queued_(std::max(max_queued, 1))
+	{
+		for (int i = 0; i < n_threads; ++i)
+			threads_.emplace_back(&AsyncWriter::run, this);
+	}
+
+	AsyncWriter::~AsyncWriter()
+	{
+		flush();
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		task_added_.notify_all();
+
+		for (std::thread &t : threads_)
+			t.join();
+	}
+
+	void AsyncWriter::submit(std::function<void()> task)
+	{
+		if (threads_.empty())
+		{
+			task();
+			return;
+		}
+
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			task_done_.wait(lock, [this] { return queue_.size() < max_queued_; });
+			queue_.push_back(std::move(task));
+		}
+		task_added_.notify_one();
+	}
+
+	void AsyncWriter::flush()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		task_done_.wait(lock, [this] { return queue_.empty() && running_ == 0; });
+	}
+
+	void AsyncWriter::run()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				task_added_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+				if (queue_.empty())
+					return;
+
+				task = std::move(queue_.front());
+				queue_.pop_front();
+				++running_;
+			}
+			// a slot of the queue is free
+			task_done_.notify_all();
+
+			try
+			{
+				task();
+			}
+			catch (const std::exception &e)
+			{
+				logger().error("Failed to write the output: {}", e.what());
+			}
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				--running_;
+			}
+			task_done_.notify_all();
+		}
+	}
+
+	std::mutex &AsyncWriter::hdf5_mutex()
+	{
+		static std::mutex mutex;
+		return mutex;
+	}
+} // namespace polyfem::io
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace polyfem::io
+{
+	/// Runs the output tasks (serialization and disk I/O) on background threads so that the solver does not wait
+	/// for the file system. The queue is bounded: submit blocks while max_queued tasks are waiting, so a slow disk
+	/// slows down the simulation instead of accumulating copies of the solution in memory.
+	/// The tasks must own their data (e.g., capture the writers and matrices by value), the caller can modify
+	/// everything as soon as submit returns.
+	class AsyncWriter
+	{
+	public:
+		/// @param[in] n_threads number of writer threads, 0 runs every task in submit
+		/// @param[in] max_queued maximum number of tasks waiting to be written
+		AsyncWriter(const int n_threads, const int max_queued);
+		/// waits for all the tasks
+		~AsyncWriter();
+
+		AsyncWriter(const AsyncWriter &) = delete;
+		AsyncWriter &operator=(const AsyncWriter &) = delete;
+
+		/// queues the task, blocks while the queue is full
+		void submit(std::function<void()> task);
+
+		/// waits until all the submitted tasks are done
+		void flush();
+
+		inline int n_threads() const { return int(threads_.size()); }
+
+		/// HDF5 is not thread safe, every HDF5 access that can run while writer threads are active must hold it
+		static std::mutex &hdf5_mutex();
+
+	private:
+		void run();
+
+		std::vector<std::thread> threads_;
+		std::deque<std::function<void()>> queue_;
+		const size_t max_queued_;
+		/// tasks currently being written
+		int running_ = 0;
+		bool stop_ = false;
+
+		std::mutex mutex_;
+		std::condition_variable task_added_;
+		std::condition_variable task_done_;
+	};
+} // namespace polyfem::io
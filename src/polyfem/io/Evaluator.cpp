@@ -980,6 +980,90 @@ namespace polyfem::io
 		}
 	}
 
+	void Evaluator::interpolation_matrix(
+		const mesh::Mesh &mesh,
+		const int n_bases,
+		const std::vector<basis::ElementBases> &bases,
+		const Eigen::VectorXi &disc_orders,
+		const std::map<int, Eigen::MatrixXd> &polys,
+		const std::map<int, std::pair<Eigen::MatrixXd, Eigen::MatrixXi>> &polys_3d,
+		const utils::RefElementSampler &sampler,
+		const int n_points,
+		const bool use_sampler,
+		const bool boundary_only,
+		StiffnessMatrix &mat)
+	{
+		std::vector<AssemblyValues> tmp;
+		std::vector<Eigen::Triplet<double>> entries;
+
+		int index = 0;
+
+		Eigen::MatrixXi vis_faces_poly, vis_edges_poly;
+
+		// same points and order as interpolate_function
+		for (int i = 0; i < int(bases.size()); ++i)
+		{
+			const ElementBases &bs = bases[i];
+			Eigen::MatrixXd local_pts;
+
+			if (boundary_only && mesh.is_volume() && !mesh.is_boundary_element(i))
+				continue;
+
+			if (use_sampler)
+			{
+				if (mesh.is_simplex(i))
+					local_pts = sampler.simplex_points();
+				else if (mesh.is_cube(i))
+					local_pts = sampler.cube_points();
+				else
+				{
+					if (mesh.is_volume())
+						sampler.sample_polyhedron(polys_3d.at(i).first, polys_3d.at(i).second, local_pts, vis_faces_poly, vis_edges_poly);
+					else
+						sampler.sample_polygon(polys.at(i), local_pts, vis_faces_poly, vis_edges_poly);
+				}
+			}
+			else
+			{
+				if (mesh.is_volume())
+				{
+					if (mesh.is_simplex(i))
+						autogen::p_nodes_3d(disc_orders(i), local_pts);
+					else if (mesh.is_cube(i))
+						autogen::q_nodes_3d(disc_orders(i), local_pts);
+					else
+						continue;
+				}
+				else
+				{
+					if (mesh.is_simplex(i))
+						autogen::p_nodes_2d(disc_orders(i), local_pts);
+					else if (mesh.is_cube(i))
+						autogen::q_nodes_2d(disc_orders(i), local_pts);
+					else
+						continue;
+				}
+			}
+
+			bs.evaluate_bases(local_pts, tmp);
+			for (size_t j = 0; j < bs.bases.size(); ++j)
+			{
+				for (const auto &g : bs.bases[j].global())
+				{
+					for (int p = 0; p < local_pts.rows(); ++p)
+						entries.emplace_back(index + p, g.index, g.val * tmp[j].val(p));
+				}
+			}
+
+			index += local_pts.rows();
+		}
+
+		assert(index <= n_points);
+		mat.resize(n_points, n_bases);
+		mat.setFromTriplets(entries.begin(), entries.end());
+		mat.makeCompressed();
+	}
+
 	void Evaluator::interpolate_at_local_vals(
 		const mesh::Mesh &mesh,
 		const bool is_problem_scalar,
@@ -108,6 +108,32 @@ namespace polyfem::io
 			const bool use_sampler,
 			const bool boundary_only);
 
+		/// builds the linear map of interpolate_function, it does not depend on the function so it can be reused
+		/// for every field on the same bases: interpolate_function(fun) = mat * fun, with fun reshaped to one row per node
+		/// @param[in] mesh mesh
+		/// @param[in] n_bases number of nodes, number of columns of mat
+		/// @param[in] bases bases
+		/// @param[in] disc_orders discretization orders
+		/// @param[in] polys polygons
+		/// @param[in] polys_3d polyhedra
+		/// @param[in] sampler sampler for the local element
+		/// @param[in] n_points is the size of the output, number of rows of mat
+		/// @param[in] use_sampler uses the sampler or not
+		/// @param[in] boundary_only interpolates only at boundary elements
+		/// @param[out] mat interpolation matrix
+		static void interpolation_matrix(
+			const mesh::Mesh &mesh,
+			const int n_bases,
+			const std::vector<basis::ElementBases> &bases,
+			const Eigen::VectorXi &disc_orders,
+			const std::map<int, Eigen::MatrixXd> &polys,
+			const std::map<int, std::pair<Eigen::MatrixXd, Eigen::MatrixXi>> &polys_3d,
+			const utils::RefElementSampler &sampler,
+			const int n_points,
+			const bool use_sampler,
+			const bool boundary_only,
+			StiffnessMatrix &mat);
+
 		/// interpolate solution and gradient at element (calls interpolate_at_local_vals with sol)
 		/// @param[in] mesh mesh
 		/// @param[in] is_problem_scalar if problem is scalar
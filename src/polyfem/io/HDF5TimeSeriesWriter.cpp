@@ -0,0 +1,169 @@
+#include "HDF5TimeSeriesWriter.hpp"
+
+#include <polyfem/utils/Logger.hpp>
+
+#include <h5pp/h5pp.h>
+
+#include <filesystem>
+
+namespace polyfem::io
+{
+	namespace
+	{
+		typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXd;
+		typedef Eigen::Matrix<int, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrixXi;
+
+		const char *const footer = "</Grid>\n</Domain>\n</Xdmf>\n";
+
+		// ParaView only reads 3D points and vectors, 2D data is padded with zeros (as in the VTU files)
+		RowMatrixXd padded_to_3d(const Eigen::MatrixXd &mat)
+		{
+			if (mat.cols() != 2)
+				return mat;
+
+			RowMatrixXd res = RowMatrixXd::Zero(mat.rows(), 3);
+			res.leftCols(2) = mat;
+			return res;
+		}
+
+		std::string topology_type(const int nodes_per_cell)
+		{
+			switch (nodes_per_cell)
+			{
+			case 1:
+				return "Polyvertex";
+			case 2:
+				return "Polyline";
+			case 3:
+				return "Triangle";
+			case 4:
+				return "Tetrahedron";
+			default:
+				log_and_throw_error("Unsupported cells with {} vertices in the HDF5 time series", nodes_per_cell);
+			}
+			return "";
+		}
+
+		std::string attribute_type(const int cols)
+		{
+			switch (cols)
+			{
+			case 1:
+				return "Scalar";
+			case 3:
+				return "Vector";
+			case 6:
+				return "Tensor6";
+			case 9:
+				return "Tensor";
+			default:
+				return "Matrix";
+			}
+		}
+
+		std::string data_item(const std::string &file, const std::string &dataset, const int rows, const int cols, const bool is_int)
+		{
+			return fmt::format(
+				"<DataItem Dimensions=\"{} {}\" NumberType=\"{}\" Precision=\"{}\" Format=\"HDF\">{}:{}</DataItem>\n",
+				rows, cols, is_int ? "Int" : "Float", is_int ? 4 : 8, file, dataset);
+		}
+	} // namespace
+
+	HDF5TimeSeriesWriter::HDF5TimeSeriesWriter(const std::string &hdf5_path, const std::string &xdmf_path, const int compression_level)
+		: hdf5_path_(hdf5_path), xdmf_path_(xdmf_path), compression_level_(compression_level)
+	{
+		const std::filesystem::path xdmf_dir = std::filesystem::path(xdmf_path).parent_path();
+		hdf5_name_ = std::filesystem::path(hdf5_path).lexically_relative(xdmf_dir.empty() ? "." : xdmf_dir).string();
+		if (hdf5_name_.empty())
+			hdf5_name_ = std::filesystem::path(hdf5_path).filename().string();
+
+		{
+			h5pp::File file(hdf5_path_, h5pp::FileAccess::REPLACE);
+		}
+
+		xdmf_.open(xdmf_path_, std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!xdmf_.is_open())
+			log_and_throw_error("Unable to open {} for writing", xdmf_path_);
+
+		xdmf_ << "<?xml version=\"1.0\"?>\n";
+		xdmf_ << "<Xdmf Version=\"3.0\">\n";
+		xdmf_ << "<Domain>\n";
+		xdmf_ << "<Grid Name=\"TimeSeries\" GridType=\"Collection\" CollectionType=\"Temporal\">\n";
+		end_of_steps_ = xdmf_.tellp();
+		xdmf_ << footer;
+		xdmf_.flush();
+	}
+
+	void HDF5TimeSeriesWriter::write_mesh(const std::string &name, const Eigen::MatrixXd &points, const Eigen::MatrixXi &cells)
+	{
+		MeshInfo info;
+		info.group = fmt::format("/meshes/{}_{}", name, n_meshes_written_++);
+		info.n_points = points.rows();
+		info.n_cells = cells.rows();
+		info.nodes_per_cell = cells.cols();
+		topology_type(info.nodes_per_cell); // throws if not supported
+
+		h5pp::File file(hdf5_path_, h5pp::FileAccess::READWRITE);
+		file.setCompressionLevel(compression_level_);
+		file.writeDataset(padded_to_3d(points), info.group + "/geometry", H5D_CHUNKED);
+		file.writeDataset(RowMatrixXi(cells), info.group + "/topology", H5D_CHUNKED);
+
+		meshes_[name] = info;
+	}
+
+	void HDF5TimeSeriesWriter::write_step(const int step, const double time, const std::map<std::string, std::vector<NamedMatrix>> &fields)
+	{
+		std::string grids;
+
+		{
+			h5pp::File file(hdf5_path_, h5pp::FileAccess::READWRITE);
+			file.setCompressionLevel(compression_level_);
+
+			for (const auto &[mesh_name, mesh_fields] : fields)
+			{
+				const auto it = meshes_.find(mesh_name);
+				if (it == meshes_.end())
+					log_and_throw_error("Mesh {} of the HDF5 time series was not written", mesh_name);
+				const MeshInfo &info = it->second;
+
+				grids += fmt::format("<Grid Name=\"{}\" GridType=\"Uniform\">\n", mesh_name);
+				grids += fmt::format(
+					"<Topology TopologyType=\"{}\" NumberOfElements=\"{}\" NodesPerElement=\"{}\">\n",
+					topology_type(info.nodes_per_cell), info.n_cells, info.nodes_per_cell);
+				grids += data_item(hdf5_name_, info.group + "/topology", info.n_cells, info.nodes_per_cell, true);
+				grids += "</Topology>\n";
+				grids += "<Geometry GeometryType=\"XYZ\">\n";
+				grids += data_item(hdf5_name_, info.group + "/geometry", info.n_points, 3, false);
+				grids += "</Geometry>\n";
+
+				for (const auto &[field_name, values] : mesh_fields)
+				{
+					if (values.rows() != info.n_points)
+						log_and_throw_error("Field {} has {} values but mesh {} has {} points", field_name, values.rows(), mesh_name, info.n_points);
+
+					const RowMatrixXd data = padded_to_3d(values);
+					const std::string dataset = fmt::format("/steps/{}/{}/{}", step, mesh_name, field_name);
+					file.writeDataset(data, dataset, H5D_CHUNKED);
+
+					grids += fmt::format("<Attribute Name=\"{}\" AttributeType=\"{}\" Center=\"Node\">\n", field_name, attribute_type(data.cols()));
+					grids += data_item(hdf5_name_, dataset, data.rows(), data.cols(), false);
+					grids += "</Attribute>\n";
+				}
+
+				grids += "</Grid>\n";
+			}
+		}
+
+		// the datasets are written before the index refers to them
+		xdmf_.seekp(end_of_steps_);
+		xdmf_ << fmt::format("<Grid Name=\"step_{}\" GridType=\"Collection\" CollectionType=\"Spatial\">\n", step);
+		xdmf_ << fmt::format("<Time Value=\"{}\"/>\n", time);
+		xdmf_ << grids;
+		xdmf_ << "</Grid>\n";
+		end_of_steps_ = xdmf_.tellp();
+		xdmf_ << footer;
+		xdmf_.flush();
+
+		++n_steps_;
+	}
+} // namespace polyfem::io
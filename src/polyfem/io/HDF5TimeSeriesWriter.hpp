@@ -0,0 +1,73 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace polyfem::io
+{
+	/// Writes a time sequence in a single HDF5 file with an XDMF index that ParaView can open.
+	/// The geometry and the topology of the meshes are stored once (/meshes/<mesh>/[geometry|topology]),
+	/// every step appends chunked, compressed datasets for its nodal fields (/steps/<step>/<mesh>/<field>).
+	/// The XDMF index is appended like the PVD (see PVDAppender) and is valid after every step.
+	class HDF5TimeSeriesWriter
+	{
+	public:
+		typedef std::pair<std::string, Eigen::MatrixXd> NamedMatrix;
+
+		/// creates (or truncates) the HDF5 file and its XDMF index
+		/// @param[in] hdf5_path HDF5 file
+		/// @param[in] xdmf_path XDMF index, the HDF5 file is referenced relative to it
+		/// @param[in] compression_level deflate level of the datasets, 0 to 9
+		HDF5TimeSeriesWriter(const std::string &hdf5_path, const std::string &xdmf_path, const int compression_level);
+
+		HDF5TimeSeriesWriter(const HDF5TimeSeriesWriter &) = delete;
+		HDF5TimeSeriesWriter &operator=(const HDF5TimeSeriesWriter &) = delete;
+
+		inline const std::string &hdf5_path() const { return hdf5_path_; }
+		inline const std::string &xdmf_path() const { return xdmf_path_; }
+
+		/// stores a mesh, writing a mesh with an existing name replaces it for the following steps (e.g., after remeshing)
+		/// @param[in] name mesh name
+		/// @param[in] points vertices, 2 or 3 columns
+		/// @param[in] cells simplices (edges, triangles, or tets)
+		void write_mesh(const std::string &name, const Eigen::MatrixXd &points, const Eigen::MatrixXi &cells);
+
+		/// appends a time step
+		/// @param[in] step step index, used to name the datasets
+		/// @param[in] time time of the step
+		/// @param[in] fields nodal fields of every mesh, the meshes must have been written
+		void write_step(const int step, const double time, const std::map<std::string, std::vector<NamedMatrix>> &fields);
+
+		/// number of steps written
+		inline int n_steps() const { return n_steps_; }
+
+	private:
+		struct MeshInfo
+		{
+			std::string group; ///< dataset group of the geometry and topology
+			int n_points;
+			int n_cells;
+			int nodes_per_cell;
+		};
+
+		std::string hdf5_path_;
+		std::string xdmf_path_;
+		/// HDF5 file name as written in the XDMF
+		std::string hdf5_name_;
+		int compression_level_;
+
+		std::map<std::string, MeshInfo> meshes_;
+		/// number of times write_mesh was called, makes the groups of replaced meshes unique
+		int n_meshes_written_ = 0;
+		int n_steps_ = 0;
+
+		std::ofstream xdmf_;
+		/// position of the closing tags of the XDMF
+		std::streampos end_of_steps_;
+	};
+} // namespace polyfem::io
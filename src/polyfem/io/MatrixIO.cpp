@@ -1,5 +1,6 @@
 #include "MatrixIO.hpp"
 
+#include <polyfem/io/AsyncWriter.hpp>
 #include <polyfem/utils/Logger.hpp>
 
 #include <igl/list_to_matrix.h>
@@ -9,6 +10,7 @@
 
 #include <fstream>
 #include <iomanip> // setprecision
+#include <mutex>
 #include <vector>
 #include <filesystem>
 
@@ -63,6 +65,7 @@ namespace polyfem::io
 	template <typename Mat>
 	bool write_matrix(const std::string &path, const std::string &key, const Mat &mat, const bool replace)
 	{
+		std::lock_guard<std::mutex> lock(AsyncWriter::hdf5_mutex());
 		h5pp::File hdf5_file(path, replace ? h5pp::FileAccess::REPLACE : h5pp::FileAccess::READWRITE);
 		hdf5_file.writeDataset(mat, key);
 
@@ -72,6 +75,7 @@ namespace polyfem::io
 	template <typename Mat>
 	bool read_matrix(const std::string &path, const std::string &key, Mat &mat)
 	{
+		std::lock_guard<std::mutex> lock(AsyncWriter::hdf5_mutex());
 		h5pp::File hdf5_file(path, h5pp::FileAccess::READONLY);
 		mat = hdf5_file.readDataset<Mat>(key);
 		return true;
@@ -1080,6 +1080,8 @@ namespace polyfem::io
 		reorder_output = args["output"]["data"]["advanced"]["reorder_nodes"];
 
 		use_hdf5 = args["output"]["paraview"]["options"]["use_hdf5"];
+		time_series = use_hdf5 && args["output"]["paraview"]["options"]["time_series"];
+		compression_level = args["output"]["paraview"]["options"]["compression_level"];
 
 		this->solve_export_to_file = solve_export_to_file;
 	}
@@ -1153,18 +1155,19 @@ namespace polyfem::io
 		if (!opts.solve_export_to_file)
 			return;
 
-		paraviewo::VTMWriter vtm(t);
+		// shared, the writer is not copyable
+		const auto vtm = std::make_shared<paraviewo::VTMWriter>(t);
 		if (opts.volume)
-			vtm.add_dataset("Volume", "data", path_stem + opts.file_extension());
+			vtm->add_dataset("Volume", "data", path_stem + opts.file_extension());
 		if (opts.surface)
-			vtm.add_dataset("Surface", "data", path_stem + "_surf" + opts.file_extension());
+			vtm->add_dataset("Surface", "data", path_stem + "_surf" + opts.file_extension());
 		if (is_contact_enabled && (opts.contact_forces || opts.friction_forces))
-			vtm.add_dataset("Contact", "data", path_stem + "_surf_contact" + opts.file_extension());
+			vtm->add_dataset("Contact", "data", path_stem + "_surf_contact" + opts.file_extension());
 		if (opts.wire)
-			vtm.add_dataset("Wireframe", "data", path_stem + "_wire" + opts.file_extension());
+			vtm->add_dataset("Wireframe", "data", path_stem + "_wire" + opts.file_extension());
 		if (opts.points)
-			vtm.add_dataset("Points", "data", path_stem + "_points" + opts.file_extension());
-		vtm.save(base_path + ".vtm");
+			vtm->add_dataset("Points", "data", path_stem + "_points" + opts.file_extension());
+		write_file([vtm, path = base_path + ".vtm"]() { vtm->save(path); }, false);
 	}
 
 	void OutGeometryData::save_volume(
@@ -1190,20 +1193,15 @@ namespace polyfem::io
 		const mesh::Obstacle &obstacle = state.obstacle;
 		const assembler::Problem &problem = *state.problem;
 
-		Eigen::MatrixXd points;
-		Eigen::MatrixXi tets;
-		Eigen::MatrixXi el_id;
-		Eigen::MatrixXd discr;
-		std::vector<std::vector<int>> elements;
-
-		if (opts.use_sampler)
-			build_vis_mesh(mesh, disc_orders, gbases,
-						   state.polys, state.polys_3d, opts.boundary_only,
-						   points, tets, el_id, discr);
-		else
-			build_high_order_vis_mesh(mesh, disc_orders, bases,
-									  points, elements, el_id, discr);
+		// the obstacle is appended below, the cached mesh is copied
+		const VisMeshCache &vis = vis_mesh(state, opts);
+		Eigen::MatrixXd points = vis.points;
+		Eigen::MatrixXi tets = vis.tets;
+		const Eigen::MatrixXi &el_id = vis.el_id;
+		Eigen::MatrixXd discr = vis.discr;
+		std::vector<std::vector<int>> elements = vis.elements;
 
+		const int actual_dim = problem.is_scalar() ? 1 : mesh.dimension();
 		Eigen::MatrixXd fun, exact_fun, err, node_fun;
 
 		if (opts.sol_on_grid)
@@ -1267,18 +1265,11 @@ namespace polyfem::io
 			}
 		}
 
-		Evaluator::interpolate_function(
-			mesh, problem.is_scalar(), bases, state.disc_orders,
-			state.polys, state.polys_3d, ref_element_sampler,
-			points.rows(), sol, fun, opts.use_sampler, opts.boundary_only);
+		interpolate_on_vis_mesh(state, opts, actual_dim, sol, fun);
 
 		{
 			Eigen::MatrixXd tmp = Eigen::VectorXd::LinSpaced(sol.size(), 0, sol.size() - 1);
-
-			Evaluator::interpolate_function(
-				mesh, problem.is_scalar(), bases, state.disc_orders,
-				state.polys, state.polys_3d, ref_element_sampler,
-				points.rows(), tmp, node_fun, opts.use_sampler, opts.boundary_only);
+			interpolate_on_vis_mesh(state, opts, actual_dim, tmp, node_fun);
 		}
 
 		if (obstacle.n_vertices() > 0)
@@ -1610,10 +1601,7 @@ namespace polyfem::io
 			Eigen::MatrixXd traction_forces, traction_forces_fun;
 			compute_traction_forces(state, sol, t, traction_forces, false);
 
-			Evaluator::interpolate_function(
-				mesh, problem.is_scalar(), bases, state.disc_orders,
-				state.polys, state.polys_3d, ref_element_sampler,
-				points.rows(), traction_forces, traction_forces_fun, opts.use_sampler, opts.boundary_only);
+			interpolate_on_vis_mesh(state, opts, actual_dim, traction_forces, traction_forces_fun);
 
 			if (obstacle.n_vertices() > 0)
 			{
@@ -1631,10 +1619,7 @@ namespace polyfem::io
 				Eigen::MatrixXd potential_grad, potential_grad_fun;
 				state.assembler->assemble_gradient(mesh.is_volume(), state.n_bases, bases, gbases, state.ass_vals_cache, t, dt, sol, sol, potential_grad);
 
-				Evaluator::interpolate_function(
-					mesh, problem.is_scalar(), bases, state.disc_orders,
-					state.polys, state.polys_3d, ref_element_sampler,
-					points.rows(), potential_grad, potential_grad_fun, opts.use_sampler, opts.boundary_only);
+				interpolate_on_vis_mesh(state, opts, actual_dim, potential_grad, potential_grad_fun);
 
 				if (obstacle.n_vertices() > 0)
 				{
@@ -1694,10 +1679,15 @@ namespace polyfem::io
 				}
 			}
 
-			if (elements.empty())
-				writer.write_mesh(path, points, tets);
-			else
-				writer.write_mesh(path, points, elements, true, disc_orders.maxCoeff() == 1);
+			const bool is_linear = disc_orders.maxCoeff() == 1;
+			write_file(
+				[tmpw, path, points = std::move(points), tets = std::move(tets), elements = std::move(elements), is_linear]() {
+					if (elements.empty())
+						tmpw->write_mesh(path, points, tets);
+					else
+						tmpw->write_mesh(path, points, elements, true, is_linear);
+				},
+				opts.use_hdf5);
 		}
 		else
 		{
@@ -1716,10 +1706,9 @@ namespace polyfem::io
 		paraviewo::ParaviewWriter &writer) const
 	{
 		Eigen::MatrixXd inerpolated_field;
-		Evaluator::interpolate_function(
-			*state.mesh, state.problem->is_scalar(), state.bases, state.disc_orders,
-			state.polys, state.polys_3d, ref_element_sampler,
-			points.rows(), field, inerpolated_field, opts.use_sampler, opts.boundary_only);
+		interpolate_on_vis_mesh(
+			state, opts, state.problem->is_scalar() ? 1 : state.mesh->dimension(), field, inerpolated_field);
+		assert(inerpolated_field.rows() == points.rows());
 
 		if (state.obstacle.n_vertices() > 0)
 		{
@@ -1926,7 +1915,10 @@ namespace polyfem::io
 			solution_frames.back().solution = fun;
 
 		if (opts.solve_export_to_file)
-			writer.write_mesh(export_surface, boundary_vis_vertices, boundary_vis_elements);
+			write_file([tmpw, export_surface, boundary_vis_vertices, boundary_vis_elements]() {
+				tmpw->write_mesh(export_surface, boundary_vis_vertices, boundary_vis_elements);
+			},
+					   opts.use_hdf5);
 		else
 		{
 			solution_frames.back().name = export_surface;
@@ -1946,16 +1938,11 @@ namespace polyfem::io
 		const bool is_contact_enabled,
 		std::vector<SolutionFrame> &solution_frames) const
 	{
-		const mesh::Mesh &mesh = *state.mesh;
-		const ipc::CollisionMesh &collision_mesh = state.collision_mesh;
-		const double dhat = state.args["contact"]["dhat"];
-		const double friction_coefficient = state.args["contact"]["friction_coefficient"];
-		const double epsv = state.args["contact"]["epsv"];
-		const std::shared_ptr<solver::ContactForm> &contact_form = state.solve_data.contact_form;
-		const std::shared_ptr<solver::FrictionForm> &friction_form = state.solve_data.friction_form;
-
 		if (opts.solve_export_to_file)
 		{
+			const ipc::CollisionMesh &collision_mesh = state.collision_mesh;
+			const int problem_dim = state.mesh->dimension();
+
 			std::shared_ptr<paraviewo::ParaviewWriter> tmpw;
 			if (opts.use_hdf5)
 				tmpw = std::make_shared<paraviewo::HDF5VTUWriter>();
@@ -1963,66 +1950,91 @@ namespace polyfem::io
 				tmpw = std::make_shared<paraviewo::VTUWriter>();
 			paraviewo::ParaviewWriter &writer = *tmpw;
 
-			const int problem_dim = mesh.dimension();
-			const Eigen::MatrixXd full_displacements = utils::unflatten(sol, problem_dim);
-			const Eigen::MatrixXd surface_displacements = collision_mesh.map_displacements(full_displacements);
+			std::vector<assembler::Assembler::NamedMatrix> fields;
+			compute_contact_surface_fields(state, sol, opts, fields);
+			for (const auto &[name, v] : fields)
+				writer.add_field(name, v);
 
-			const Eigen::MatrixXd displaced_surface = collision_mesh.displace_vertices(full_displacements);
+			write_file(
+				[tmpw,
+				 path = export_surface.substr(0, export_surface.length() - 4) + "_contact.vtu",
+				 rest_positions = Eigen::MatrixXd(collision_mesh.rest_positions()),
+				 cells = Eigen::MatrixXi(problem_dim == 3 ? collision_mesh.faces() : collision_mesh.edges())]() {
+					tmpw->write_mesh(path, rest_positions, cells);
+				},
+				opts.use_hdf5);
+		}
+	}
 
-			ipc::CollisionConstraints constraint_set;
-			constraint_set.set_use_convergent_formulation(state.args["contact"]["use_convergent_formulation"]);
-			constraint_set.build(
-				collision_mesh, displaced_surface, dhat,
-				/*dmin=*/0, state.args["solver"]["contact"]["CCD"]["broad_phase"]);
+	void OutGeometryData::compute_contact_surface_fields(
+		const State &state,
+		const Eigen::MatrixXd &sol,
+		const ExportOptions &opts,
+		std::vector<assembler::Assembler::NamedMatrix> &fields) const
+	{
+		const mesh::Mesh &mesh = *state.mesh;
+		const ipc::CollisionMesh &collision_mesh = state.collision_mesh;
+		const double dhat = state.args["contact"]["dhat"];
+		const double friction_coefficient = state.args["contact"]["friction_coefficient"];
+		const double epsv = state.args["contact"]["epsv"];
+		const std::shared_ptr<solver::ContactForm> &contact_form = state.solve_data.contact_form;
 
-			const double barrier_stiffness = contact_form != nullptr ? contact_form->weight() : 1;
+		fields.clear();
 
-			if (opts.contact_forces)
-			{
-				Eigen::MatrixXd forces = -barrier_stiffness * constraint_set.compute_potential_gradient(collision_mesh, displaced_surface, dhat);
+		const int problem_dim = mesh.dimension();
+		const Eigen::MatrixXd full_displacements = utils::unflatten(sol, problem_dim);
+		const Eigen::MatrixXd surface_displacements = collision_mesh.map_displacements(full_displacements);
 
-				Eigen::MatrixXd forces_reshaped = utils::unflatten(forces, problem_dim);
+		const Eigen::MatrixXd displaced_surface = collision_mesh.displace_vertices(full_displacements);
 
-				assert(forces_reshaped.rows() == surface_displacements.rows());
-				assert(forces_reshaped.cols() == surface_displacements.cols());
-				writer.add_field("contact_forces", forces_reshaped);
-			}
+		ipc::CollisionConstraints constraint_set;
+		constraint_set.set_use_convergent_formulation(state.args["contact"]["use_convergent_formulation"]);
+		constraint_set.build(
+			collision_mesh, displaced_surface, dhat,
+			/*dmin=*/0, state.args["solver"]["contact"]["CCD"]["broad_phase"]);
 
-			if (opts.friction_forces)
-			{
-				ipc::FrictionConstraints friction_constraint_set;
-				friction_constraint_set.build(
-					collision_mesh, displaced_surface, constraint_set,
-					dhat, barrier_stiffness, friction_coefficient);
+		const double barrier_stiffness = contact_form != nullptr ? contact_form->weight() : 1;
 
-				Eigen::MatrixXd velocities;
-				if (state.solve_data.time_integrator != nullptr)
-					velocities = state.solve_data.time_integrator->v_prev();
-				else
-					velocities = sol;
-				velocities = collision_mesh.map_displacements(utils::unflatten(velocities, collision_mesh.dim()));
+		if (opts.contact_forces)
+		{
+			Eigen::MatrixXd forces = -barrier_stiffness * constraint_set.compute_potential_gradient(collision_mesh, displaced_surface, dhat);
 
-				Eigen::MatrixXd forces = -friction_constraint_set.compute_potential_gradient(
-					collision_mesh, velocities, epsv);
+			Eigen::MatrixXd forces_reshaped = utils::unflatten(forces, problem_dim);
 
-				Eigen::MatrixXd forces_reshaped = utils::unflatten(forces, problem_dim);
+			assert(forces_reshaped.rows() == surface_displacements.rows());
+			assert(forces_reshaped.cols() == surface_displacements.cols());
+			fields.emplace_back("contact_forces", forces_reshaped);
+		}
 
-				assert(forces_reshaped.rows() == surface_displacements.rows());
-				assert(forces_reshaped.cols() == surface_displacements.cols());
-				writer.add_field("friction_forces", forces_reshaped);
-			}
+		if (opts.friction_forces)
+		{
+			ipc::FrictionConstraints friction_constraint_set;
+			friction_constraint_set.build(
+				collision_mesh, displaced_surface, constraint_set,
+				dhat, barrier_stiffness, friction_coefficient);
 
-			assert(collision_mesh.rest_positions().rows() == surface_displacements.rows());
-			assert(collision_mesh.rest_positions().cols() == surface_displacements.cols());
+			Eigen::MatrixXd velocities;
+			if (state.solve_data.time_integrator != nullptr)
+				velocities = state.solve_data.time_integrator->v_prev();
+			else
+				velocities = sol;
+			velocities = collision_mesh.map_displacements(utils::unflatten(velocities, collision_mesh.dim()));
 
-			// Write the solution last so it is the default for warp-by-vector
-			writer.add_field("solution", surface_displacements);
+			Eigen::MatrixXd forces = -friction_constraint_set.compute_potential_gradient(
+				collision_mesh, velocities, epsv);
+
+			Eigen::MatrixXd forces_reshaped = utils::unflatten(forces, problem_dim);
 
-			writer.write_mesh(
-				export_surface.substr(0, export_surface.length() - 4) + "_contact.vtu",
-				collision_mesh.rest_positions(),
-				problem_dim == 3 ? collision_mesh.faces() : collision_mesh.edges());
+			assert(forces_reshaped.rows() == surface_displacements.rows());
+			assert(forces_reshaped.cols() == surface_displacements.cols());
+			fields.emplace_back("friction_forces", forces_reshaped);
 		}
+
+		assert(collision_mesh.rest_positions().rows() == surface_displacements.rows());
+		assert(collision_mesh.rest_positions().cols() == surface_displacements.cols());
+
+		// Write the solution last so it is the default for warp-by-vector
+		fields.emplace_back("solution", surface_displacements);
 	}
 
 	void OutGeometryData::save_wire(
@@ -2210,7 +2222,7 @@ namespace polyfem::io
 		// Write the solution last so it is the default for warp-by-vector
 		writer.add_field("solution", fun);
 
-		writer.write_mesh(name, points, edges);
+		write_file([tmpw, name, points, edges]() { tmpw->write_mesh(name, points, edges); }, opts.use_hdf5);
 	}
 
 	void OutGeometryData::save_points(
@@ -2265,7 +2277,7 @@ namespace polyfem::io
 			writer.add_field("sidesets", b_sidesets);
 			// Write the solution last so it is the default for warp-by-vector
 			writer.add_field("solution", fun);
-			writer.write_mesh(path, points, cells, false, false);
+			write_file([tmpw, path, points, cells]() { tmpw->write_mesh(path, points, cells, false, false); }, opts.use_hdf5);
 		}
 	}
 
@@ -2277,9 +2289,230 @@ namespace polyfem::io
 		paraviewo::PVDWriter::save_pvd(name, vtu_names, time_steps, t0, dt, skip_frame);
 	}
 
+	void OutGeometryData::append_pvd(
+		const std::string &name,
+		const std::function<std::string(int)> &vtu_names,
+		int t, double t0, double dt, int skip_frame)
+	{
+		if (name.empty())
+			return;
+
+		// a step that is not after the last one starts a new simulation (e.g., solve_problem called again)
+		if (!pvd_appender.is_open() || pvd_appender.path() != name || t == 0 || t <= pvd_last_step)
+		{
+			pvd_appender.open(name);
+			for (int i = 0; i < t; i += skip_frame)
+				pvd_appender.append(t0 + dt * i, vtu_names(i));
+		}
+
+		pvd_appender.append(t0 + dt * t, vtu_names(t));
+		pvd_last_step = t;
+	}
+
+	void OutGeometryData::close_time_sequence()
+	{
+		pvd_appender.close();
+		pvd_last_step = -1;
+
+		// the writer is shared with the pending steps, the file is closed after the last one
+		time_series = nullptr;
+		time_series_last_step = -1;
+	}
+
+	void OutGeometryData::save_time_series(
+		const std::string &path,
+		const State &state,
+		const Eigen::MatrixXd &sol,
+		const double time,
+		const int t,
+		const ExportOptions &opts_in,
+		const bool is_contact_enabled)
+	{
+		if (!state.mesh)
+		{
+			logger().error("Load the mesh first!");
+			return;
+		}
+		if (sol.size() <= 0)
+		{
+			logger().error("Solve the problem first!");
+			return;
+		}
+
+		// the XDMF cells are simplices, the high-order visualization mesh is not supported
+		ExportOptions opts = opts_in;
+		opts.use_sampler = true;
+
+		const mesh::Mesh &mesh = *state.mesh;
+		const assembler::Problem &problem = *state.problem;
+		const ipc::CollisionMesh &collision_mesh = state.collision_mesh;
+		const VisMeshCache &cache = vis_mesh(state, opts);
+		const bool export_contact = is_contact_enabled && (opts.contact_forces || opts.friction_forces);
+
+		// a step that is not after the last one starts a new simulation (e.g., solve_problem called again)
+		if (time_series == nullptr || time_series->hdf5_path() != path || t == 0 || t <= time_series_last_step)
+		{
+			// the pending steps may still write to the same file
+			if (time_series != nullptr)
+				flush_output();
+
+			const std::string xdmf_path = std::filesystem::path(path).replace_extension(".xdmf").string();
+			std::lock_guard<std::mutex> lock(AsyncWriter::hdf5_mutex());
+			time_series = std::make_shared<HDF5TimeSeriesWriter>(path, xdmf_path, opts.compression_level);
+			time_series_vis_mesh_version = -1;
+		}
+
+		// the geometry is only written again when the visualization mesh changes (e.g., remeshing)
+		if (time_series_vis_mesh_version != vis_mesh_version)
+		{
+			write_file([series = time_series, points = cache.points, tets = cache.tets]() {
+				series->write_mesh("volume", points, tets);
+			},
+					   true);
+
+			if (export_contact)
+			{
+				write_file(
+					[series = time_series,
+					 rest_positions = Eigen::MatrixXd(collision_mesh.rest_positions()),
+					 cells = Eigen::MatrixXi(mesh.dimension() == 3 ? collision_mesh.faces() : collision_mesh.edges())]() {
+						series->write_mesh("contact", rest_positions, cells);
+					},
+					true);
+			}
+
+			time_series_vis_mesh_version = vis_mesh_version;
+		}
+
+		std::map<std::string, std::vector<HDF5TimeSeriesWriter::NamedMatrix>> fields;
+		std::vector<HDF5TimeSeriesWriter::NamedMatrix> &volume_fields = fields["volume"];
+
+		const int actual_dim = problem.is_scalar() ? 1 : mesh.dimension();
+		Eigen::MatrixXd fun;
+		interpolate_on_vis_mesh(state, opts, actual_dim, sol, fun);
+
+		if (opts.scalar_values && actual_dim != 1)
+		{
+			std::vector<assembler::Assembler::NamedMatrix> vals;
+			Evaluator::compute_scalar_value(
+				mesh, problem.is_scalar(), state.bases, state.geom_bases(),
+				state.disc_orders, state.polys, state.polys_3d,
+				*state.assembler,
+				ref_element_sampler, cache.points.rows(), sol, time, vals, opts.use_sampler, opts.boundary_only);
+			for (auto &v : vals)
+				volume_fields.push_back(std::move(v));
+		}
+
+		volume_fields.emplace_back("solution", fun);
+
+		if (export_contact)
+			compute_contact_surface_fields(state, sol, opts, fields["contact"]);
+
+		write_file([series = time_series, t, time, fields = std::move(fields)]() {
+			series->write_step(t, time, fields);
+		},
+				   true);
+		time_series_last_step = t;
+	}
+
+	void OutGeometryData::write_file(std::function<void()> write, const bool hdf5) const
+	{
+		if (hdf5)
+		{
+			write = [write = std::move(write)]() {
+				std::lock_guard<std::mutex> lock(AsyncWriter::hdf5_mutex());
+				write();
+			};
+		}
+
+		if (async_writer)
+			async_writer->submit(std::move(write));
+		else
+			write();
+	}
+
+	void OutGeometryData::flush_output() const
+	{
+		if (async_writer)
+		{
+			POLYFEM_SCOPED_TIMER("Waiting for the output");
+			async_writer->flush();
+		}
+	}
+
 	void OutGeometryData::init_sampler(const polyfem::mesh::Mesh &mesh, const double vismesh_rel_area)
 	{
 		ref_element_sampler.init(mesh.is_volume(), mesh.n_elements(), vismesh_rel_area);
+		clear_vis_mesh_cache();
+	}
+
+	void OutGeometryData::clear_vis_mesh_cache()
+	{
+		vis_mesh_cache = VisMeshCache();
+	}
+
+	const OutGeometryData::VisMeshCache &OutGeometryData::vis_mesh(const State &state, const ExportOptions &opts) const
+	{
+		VisMeshCache &cache = vis_mesh_cache;
+		const mesh::Mesh &mesh = *state.mesh;
+
+		// the explicit invalidation is clear_vis_mesh_cache, the sizes only catch the obvious misses
+		if (cache.valid
+			&& cache.use_sampler == opts.use_sampler
+			&& cache.boundary_only == opts.boundary_only
+			&& cache.n_bases == state.n_bases
+			&& cache.n_elements == mesh.n_elements())
+			return cache;
+
+		POLYFEM_SCOPED_TIMER("build visualization mesh");
+
+		cache = VisMeshCache();
+		++vis_mesh_version;
+		if (opts.use_sampler)
+			build_vis_mesh(mesh, state.disc_orders, state.geom_bases(),
+						   state.polys, state.polys_3d, opts.boundary_only,
+						   cache.points, cache.tets, cache.el_id, cache.discr);
+		else
+			build_high_order_vis_mesh(mesh, state.disc_orders, state.bases,
+									  cache.points, cache.elements, cache.el_id, cache.discr);
+
+		Evaluator::interpolation_matrix(
+			mesh, state.n_bases, state.bases, state.disc_orders,
+			state.polys, state.polys_3d, ref_element_sampler,
+			cache.points.rows(), opts.use_sampler, opts.boundary_only, cache.interpolation);
+
+		cache.use_sampler = opts.use_sampler;
+		cache.boundary_only = opts.boundary_only;
+		cache.n_bases = state.n_bases;
+		cache.n_elements = mesh.n_elements();
+		cache.valid = true;
+
+		return cache;
+	}
+
+	void OutGeometryData::interpolate_on_vis_mesh(
+		const State &state,
+		const ExportOptions &opts,
+		const int actual_dim,
+		const Eigen::MatrixXd &fun,
+		Eigen::MatrixXd &result) const
+	{
+		const VisMeshCache &cache = vis_mesh(state, opts);
+
+		if (fun.size() < cache.interpolation.cols() * actual_dim)
+		{
+			// not a nodal function of the bases (e.g., not solved yet)
+			Evaluator::interpolate_function(
+				*state.mesh, actual_dim, state.bases, state.disc_orders,
+				state.polys, state.polys_3d, ref_element_sampler,
+				cache.points.rows(), fun, result, opts.use_sampler, opts.boundary_only);
+			return;
+		}
+
+		// the values of node i are fun(i * actual_dim + d), the extra values (e.g., obstacle) are ignored
+		typedef Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> RowMatrix;
+		const Eigen::Map<const RowMatrix> nodal(fun.data(), cache.interpolation.cols(), actual_dim);
+		result = cache.interpolation * nodal;
 	}
 
 	void OutGeometryData::build_grid(const polyfem::mesh::Mesh &mesh, const double spacing)
@@ -2883,24 +3116,39 @@ namespace polyfem::io
 		: file(path), solve_data(solve_data)
 	{
 		file << "i,elastic_energy,body_energy,inertia,contact_form,AL_lagr_energy,AL_pen_energy,total_energy" << std::endl;
+		enable_value_memos(true);
 	}
 
 	EnergyCSVWriter::~EnergyCSVWriter()
 	{
+		enable_value_memos(false);
 		file.close();
 	}
 
+	void EnergyCSVWriter::enable_value_memos(const bool val) const
+	{
+		for (const auto &[name, form] : solve_data.named_forms())
+			if (form)
+				form->enable_value_memo(val);
+		if (solve_data.nl_problem)
+			solve_data.nl_problem->enable_value_memos(val);
+	}
+
 	void EnergyCSVWriter::write(const int i, const Eigen::MatrixXd &sol)
 	{
+		// the values computed by the last iterations of the solver are reused, no extra energy evaluation or broad phase
+		// the forms are rebuilt after remeshing, their memo is enabled again for the next steps
+		enable_value_memos(true);
+		const Eigen::VectorXd x = sol;
 		file << fmt::format(
 			"{},{},{},{},{},{},{},{}\n", i,
-			solve_data.elastic_form->value(sol),
-			solve_data.body_form->value(sol),
-			solve_data.inertia_form ? solve_data.inertia_form->value(sol) : 0,
-			solve_data.contact_form ? solve_data.contact_form->value(sol) : 0,
-			solve_data.al_lagr_form->value(sol),
-			solve_data.al_pen_form->value(sol),
-			solve_data.nl_problem->value(sol));
+			solve_data.elastic_form->memoized_value(x),
+			solve_data.body_form->memoized_value(x),
+			solve_data.inertia_form ? solve_data.inertia_form->memoized_value(x) : 0,
+			solve_data.contact_form ? solve_data.contact_form->memoized_value(x) : 0,
+			solve_data.al_lagr_form->memoized_value(x),
+			solve_data.al_pen_form->memoized_value(x),
+			solve_data.nl_problem->memoized_value(x));
 		file.flush();
 	}
 
@@ -2,6 +2,7 @@
 
 #include <polyfem/Common.hpp>
 
+#include <polyfem/assembler/Assembler.hpp>
 #include <polyfem/assembler/Problem.hpp>
 
 #include <polyfem/basis/ElementBases.hpp>
@@ -10,6 +11,10 @@
 
 #include <polyfem/solver/SolveData.hpp>
 
+#include <polyfem/io/AsyncWriter.hpp>
+#include <polyfem/io/HDF5TimeSeriesWriter.hpp>
+#include <polyfem/io/PVDAppender.hpp>
+
 #include <paraviewo/ParaviewWriter.hpp>
 #include <paraviewo/VTUWriter.hpp>
 #include <paraviewo/HDF5VTUWriter.hpp>
@@ -73,6 +78,10 @@ namespace polyfem::io
 			bool solve_export_to_file;
 
 			bool use_hdf5;
+			/// single HDF5 file for the whole time sequence (see save_time_series), requires use_hdf5
+			bool time_series;
+			/// deflate level of the time series datasets
+			int compression_level;
 
 			/// @brief initialize the flags based on the input args
 			/// @param[in] args input arguments used to set most of the flags
@@ -118,6 +127,10 @@ namespace polyfem::io
 		/// @param[in] spacing grid spacing, <=0 mean no grid
 		void build_grid(const polyfem::mesh::Mesh &mesh, const double spacing);
 
+		/// @brief drops the cached visualization mesh and interpolation matrix,
+		/// must be called when the mesh or the bases change (e.g., after remeshing)
+		void clear_vis_mesh_cache();
+
 		/// @brief exports everytihng, txt, vtu, etc
 		/// @param[in] state state to get the data
 		/// @param[in] sol solution
@@ -265,7 +278,78 @@ namespace polyfem::io
 		void save_pvd(const std::string &name, const std::function<std::string(int)> &vtu_names,
 					  int time_steps, double t0, double dt, int skip_frame = 1) const;
 
+		/// adds the step t to the PVD of a time dependent simulation, only the new entry is written
+		/// the file is (re)created when the name changes or a new simulation starts (t == 0 or t not after
+		/// the last appended step), with the steps before t if t > 0 (e.g., restart)
+		/// @param[in] name filename
+		/// @param[in] vtu_names names of the vtu files
+		/// @param[in] t time step
+		/// @param[in] t0 initial time
+		/// @param[in] dt delta t
+		/// @param[in] skip_frame every which frame to skip
+		void append_pvd(const std::string &name, const std::function<std::string(int)> &vtu_names,
+						int t, double t0, double dt, int skip_frame = 1);
+
+		/// appends the step t to a single HDF5 file with an XDMF index (same name, .xdmf extension)
+		/// instead of writing a file per step. The sampled visualization mesh (and the collision mesh if
+		/// contact forces are exported) is stored once, every step adds the solution, the scalar values
+		/// (e.g., von Mises stresses), and the contact and friction forces.
+		/// @param[in] path HDF5 file, a new series is started when it changes or a new simulation starts
+		///                 (t == 0 or t not after the last written step)
+		/// @param[in] state state to get the data
+		/// @param[in] sol solution
+		/// @param[in] time time
+		/// @param[in] t time step
+		/// @param[in] opts export options
+		/// @param[in] is_contact_enabled if contact is enabled
+		void save_time_series(
+			const std::string &path,
+			const State &state,
+			const Eigen::MatrixXd &sol,
+			const double time,
+			const int t,
+			const ExportOptions &opts,
+			const bool is_contact_enabled);
+
+		/// writes the files of save_vtu on the threads of writer instead of the calling thread,
+		/// nullptr writes synchronously
+		void set_async_writer(const std::shared_ptr<AsyncWriter> &writer) { async_writer = writer; }
+		/// waits until all the files are written
+		void flush_output() const;
+		/// closes the files of the time sequence (append_pvd and save_time_series), the next step starts new ones
+		void close_time_sequence();
+
 	private:
+		/// writes the files in the background if an async writer is set, write must own its data
+		/// @param[in] write writes the file
+		/// @param[in] hdf5 if write uses HDF5
+		void write_file(std::function<void()> write, const bool hdf5) const;
+
+		/// background writer, nullptr if the files are written synchronously
+		std::shared_ptr<AsyncWriter> async_writer;
+		/// incremental pvd of the time sequence
+		PVDAppender pvd_appender;
+		/// last step added to pvd_appender
+		int pvd_last_step = -1;
+		/// single file time sequence, nullptr until save_time_series is called
+		std::shared_ptr<HDF5TimeSeriesWriter> time_series;
+		/// vis_mesh_version of the geometry stored in time_series
+		int time_series_vis_mesh_version = -1;
+		/// last step written in time_series
+		int time_series_last_step = -1;
+
+		/// computes the fields of the contact surface (contact and friction forces, displacement)
+		/// on the vertices of the collision mesh
+		/// @param[in] state state to get the data
+		/// @param[in] sol solution
+		/// @param[in] opts export options
+		/// @param[out] fields named fields, the solution is last
+		void compute_contact_surface_fields(
+			const State &state,
+			const Eigen::MatrixXd &sol,
+			const ExportOptions &opts,
+			std::vector<assembler::Assembler::NamedMatrix> &fields) const;
+
 		/// used to sample the solution
 		utils::RefElementSampler ref_element_sampler;
 
@@ -276,6 +360,49 @@ namespace polyfem::io
 		/// grid mesh boundaries
 		Eigen::MatrixXd grid_points_bc;
 
+		/// visualization mesh of save_volume and the interpolation from the nodes to its points,
+		/// they only depend on the mesh and the bases so they are built once and reused for every time step
+		struct VisMeshCache
+		{
+			bool valid = false;
+			bool use_sampler;
+			bool boundary_only;
+			int n_bases;
+			int n_elements;
+
+			Eigen::MatrixXd points;
+			Eigen::MatrixXi tets;
+			std::vector<std::vector<int>> elements;
+			Eigen::MatrixXi el_id;
+			Eigen::MatrixXd discr;
+
+			/// points x nodes, see Evaluator::interpolation_matrix
+			StiffnessMatrix interpolation;
+		};
+		mutable VisMeshCache vis_mesh_cache;
+		/// incremented every time the visualization mesh is rebuilt
+		mutable int vis_mesh_version = 0;
+
+		/// @brief visualization mesh for the state and options, built at the first call
+		/// @param[in] state state to get the data
+		/// @param[in] opts export options
+		/// @return cached visualization mesh
+		const VisMeshCache &vis_mesh(const State &state, const ExportOptions &opts) const;
+
+		/// @brief interpolates the nodal function fun at the points of the visualization mesh,
+		/// same as Evaluator::interpolate_function but with the cached interpolation matrix
+		/// @param[in] state state to get the data
+		/// @param[in] opts export options
+		/// @param[in] actual_dim size of the problem (e.g., 1 for Laplace, dim for elasticity)
+		/// @param[in] fun function to interpolate, actual_dim values per node
+		/// @param[out] result interpolated function, one row per point
+		void interpolate_on_vis_mesh(
+			const State &state,
+			const ExportOptions &opts,
+			const int actual_dim,
+			const Eigen::MatrixXd &fun,
+			Eigen::MatrixXd &result) const;
+
 		/// @brief builds the boundary mesh for visualization
 		/// @param[in] mesh mesh
 		/// @param[in] bases bases
@@ -515,6 +642,9 @@ namespace polyfem::io
 		void write(const int i, const Eigen::MatrixXd &sol);
 
 	protected:
+		/// the forms keep their last value while the writer exists, see solver::Form::memoized_value
+		void enable_value_memos(const bool val) const;
+
 		const solver::SolveData &solve_data;
 		std::ofstream file;
 	};
@@ -0,0 +1,49 @@
+#include "PVDAppender.hpp"
+
+#include <polyfem/utils/Logger.hpp>
+
+#include <cassert>
+
+namespace polyfem::io
+{
+	namespace
+	{
+		const char *const footer = "</Collection>\n</VTKFile>\n";
+	}
+
+	void PVDAppender::open(const std::string &path)
+	{
+		close();
+
+		file_.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!file_.is_open())
+			log_and_throw_error("Unable to open {} for writing", path);
+		path_ = path;
+
+		file_ << "<?xml version=\"1.0\"?>\n";
+		file_ << "<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\"LittleEndian\" compressor=\"vtkZLibDataCompressor\">\n";
+		file_ << "<Collection>\n";
+		end_of_entries_ = file_.tellp();
+		file_ << footer;
+		file_.flush();
+	}
+
+	void PVDAppender::close()
+	{
+		if (file_.is_open())
+			file_.close();
+		path_.clear();
+	}
+
+	void PVDAppender::append(const double time, const std::string &file)
+	{
+		assert(is_open());
+
+		// the new entry is longer than the footer, so the old footer is entirely overwritten
+		file_.seekp(end_of_entries_);
+		file_ << fmt::format("<DataSet timestep=\"{}\" group=\"\" part=\"0\" file=\"{}\"/>\n", time, file);
+		end_of_entries_ = file_.tellp();
+		file_ << footer;
+		file_.flush();
+	}
+} // namespace polyfem::io
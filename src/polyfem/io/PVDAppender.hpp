@@ -0,0 +1,33 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+
+namespace polyfem::io
+{
+	/// Writes a PVD time series one step at a time. The closing tags are kept at the end of the file and
+	/// overwritten by every new entry, so each step only writes one line instead of rewriting the whole file
+	/// (paraviewo::PVDWriter::save_pvd). The file is valid after every append.
+	class PVDAppender
+	{
+	public:
+		/// creates (or truncates) the file with an empty collection
+		void open(const std::string &path);
+		/// closes the file, it is left valid
+		void close();
+
+		inline bool is_open() const { return file_.is_open(); }
+		inline const std::string &path() const { return path_; }
+
+		/// adds a dataset at the end of the collection
+		/// @param[in] time time of the step
+		/// @param[in] file dataset file name, relative to the pvd
+		void append(const double time, const std::string &file);
+
+	private:
+		std::ofstream file_;
+		std::string path_;
+		/// position of the closing tags
+		std::streampos end_of_entries_;
+	};
+} // namespace polyfem::io
@@ -0,0 +1,290 @@
+#include "Snapshot.hpp"
+
+#include <polyfem/utils/Logger.hpp>
+
+#include <cstring>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define POLYFEM_SNAPSHOT_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace polyfem::io
+{
+	namespace
+	{
+		constexpr char MAGIC[8] = {'P', 'F', 'S', 'N', 'A', 'P', '\0', '\0'};
+		constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+		constexpr uint64_t ALIGNMENT = 64;
+		constexpr size_t NAME_SIZE = 88;
+
+		enum ArrayType : uint32_t
+		{
+			FLOAT64 = 0,
+			INT32 = 1,
+			INT64 = 2,
+		};
+
+		template <typename Scalar>
+		constexpr uint32_t array_type()
+		{
+			static_assert(std::is_same_v<Scalar, double> || std::is_same_v<Scalar, int32_t> || std::is_same_v<Scalar, int64_t>);
+			if constexpr (std::is_same_v<Scalar, double>)
+				return FLOAT64;
+			else if constexpr (std::is_same_v<Scalar, int32_t>)
+				return INT32;
+			else
+				return INT64;
+		}
+
+		constexpr size_t type_size(const uint32_t type) { return type == INT32 ? 4 : 8; }
+
+		// 64 bytes
+		struct Header
+		{
+			char magic[8];
+			uint32_t byte_order;
+			uint32_t version;
+			uint64_t n_entries;
+			char padding[40];
+		};
+		static_assert(sizeof(Header) == 64);
+
+		// 128 bytes
+		struct TocEntry
+		{
+			char name[NAME_SIZE];
+			uint32_t type;
+			uint32_t padding;
+			int64_t rows;
+			int64_t cols;
+			uint64_t offset; ///< from the start of the file
+			uint64_t bytes;
+		};
+		static_assert(sizeof(TocEntry) == 128);
+
+		uint64_t aligned(const uint64_t offset) { return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT; }
+	} // namespace
+
+	template <typename Scalar>
+	void SnapshotWriter::add_array(const std::string &name, const Scalar *data, const int64_t rows, const int64_t cols)
+	{
+		if (name.size() >= NAME_SIZE)
+			log_and_throw_error("Snapshot array name {} is too long", name);
+
+		Entry entry;
+		entry.name = name;
+		entry.type = array_type<Scalar>();
+		entry.rows = rows;
+		entry.cols = cols;
+		entry.data.resize(sizeof(Scalar) * rows * cols);
+		if (!entry.data.empty())
+			std::memcpy(entry.data.data(), data, entry.data.size());
+		entries_.push_back(std::move(entry));
+	}
+
+	void SnapshotWriter::add(const std::string &name, const Eigen::MatrixXd &mat)
+	{
+		add_array(name, mat.data(), mat.rows(), mat.cols());
+	}
+
+	void SnapshotWriter::add(const std::string &name, const Eigen::MatrixXi &mat)
+	{
+		static_assert(sizeof(int) == sizeof(int32_t));
+		add_array(name, reinterpret_cast<const int32_t *>(mat.data()), mat.rows(), mat.cols());
+	}
+
+	void SnapshotWriter::add(const std::string &name, const StiffnessMatrix &mat)
+	{
+		StiffnessMatrix compressed;
+		const StiffnessMatrix *m = &mat;
+		if (!mat.isCompressed())
+		{
+			compressed = mat;
+			compressed.makeCompressed();
+			m = &compressed;
+		}
+
+		typedef std::conditional_t<sizeof(StiffnessMatrix::StorageIndex) == 4, int32_t, int64_t> Index;
+		add_array(name + "/outer", reinterpret_cast<const Index *>(m->outerIndexPtr()), m->outerSize() + 1, 1);
+		add_array(name + "/inner", reinterpret_cast<const Index *>(m->innerIndexPtr()), m->nonZeros(), 1);
+		add_array(name + "/values", m->valuePtr(), m->nonZeros(), 1);
+
+		const Eigen::MatrixXd size = (Eigen::MatrixXd(1, 2) << m->rows(), m->cols()).finished();
+		add(name + "/size", size);
+	}
+
+	void SnapshotWriter::write(const std::string &path) const
+	{
+		std::ofstream out(path, std::ios::out | std::ios::trunc | std::ios::binary);
+		if (!out.is_open())
+			log_and_throw_error("Unable to open {} for writing", path);
+
+		Header header = {};
+		std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+		header.byte_order = BYTE_ORDER_MARK;
+		header.version = SnapshotReader::VERSION;
+		header.n_entries = entries_.size();
+
+		std::vector<TocEntry> toc(entries_.size());
+		uint64_t offset = aligned(sizeof(Header) + toc.size() * sizeof(TocEntry));
+		for (size_t i = 0; i < entries_.size(); ++i)
+		{
+			TocEntry &e = toc[i];
+			std::memset(&e, 0, sizeof(TocEntry));
+			std::strncpy(e.name, entries_[i].name.c_str(), NAME_SIZE - 1);
+			e.type = entries_[i].type;
+			e.rows = entries_[i].rows;
+			e.cols = entries_[i].cols;
+			e.offset = offset;
+			e.bytes = entries_[i].data.size();
+			offset = aligned(offset + e.bytes);
+		}
+
+		out.write(reinterpret_cast<const char *>(&header), sizeof(Header));
+		out.write(reinterpret_cast<const char *>(toc.data()), toc.size() * sizeof(TocEntry));
+
+		const char zeros[ALIGNMENT] = {};
+		uint64_t pos = sizeof(Header) + toc.size() * sizeof(TocEntry);
+		for (size_t i = 0; i < entries_.size(); ++i)
+		{
+			out.write(zeros, toc[i].offset - pos);
+			out.write(entries_[i].data.data(), entries_[i].data.size());
+			pos = toc[i].offset + toc[i].bytes;
+		}
+
+		if (!out.good())
+			log_and_throw_error("Failed to write snapshot {}", path);
+	}
+
+	SnapshotReader::SnapshotReader(const std::string &path)
+		: path_(path)
+	{
+#ifdef POLYFEM_SNAPSHOT_MMAP
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0)
+			log_and_throw_error("Unable to open snapshot {}", path);
+
+		struct stat st;
+		if (::fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void *ptr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (ptr != MAP_FAILED)
+			{
+				data_ = static_cast<const char *>(ptr);
+				size_ = st.st_size;
+				mapped_ = true;
+			}
+		}
+		::close(fd);
+#endif
+
+		if (!mapped_)
+		{
+			std::ifstream in(path, std::ios::binary | std::ios::ate);
+			if (!in.is_open())
+				log_and_throw_error("Unable to open snapshot {}", path);
+			buffer_.resize(size_t(in.tellg()));
+			in.seekg(0);
+			in.read(buffer_.data(), buffer_.size());
+			data_ = buffer_.data();
+			size_ = buffer_.size();
+		}
+
+		Header header;
+		if (size_ < sizeof(Header))
+			log_and_throw_error("{} is not a snapshot", path);
+		std::memcpy(&header, data_, sizeof(Header));
+
+		if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+			log_and_throw_error("{} is not a snapshot", path);
+		if (header.byte_order != BYTE_ORDER_MARK)
+			log_and_throw_error("Snapshot {} was written with another byte order", path);
+		if (header.version != VERSION)
+			log_and_throw_error("Snapshot {} has version {}, expected {}", path, header.version, VERSION);
+		if (size_ < sizeof(Header) + header.n_entries * sizeof(TocEntry))
+			log_and_throw_error("Snapshot {} is truncated", path);
+
+		entries_.resize(header.n_entries);
+		for (size_t i = 0; i < entries_.size(); ++i)
+		{
+			TocEntry e;
+			std::memcpy(&e, data_ + sizeof(Header) + i * sizeof(TocEntry), sizeof(TocEntry));
+			e.name[NAME_SIZE - 1] = '\0';
+
+			if (e.type > INT64 || e.rows < 0 || e.cols < 0
+				|| e.bytes != type_size(e.type) * e.rows * e.cols
+				|| e.offset + e.bytes > size_)
+				log_and_throw_error("Snapshot {} is corrupted (array {})", path, e.name);
+
+			entries_[i] = {e.name, e.type, e.rows, e.cols, e.offset};
+		}
+	}
+
+	SnapshotReader::~SnapshotReader()
+	{
+#ifdef POLYFEM_SNAPSHOT_MMAP
+		if (mapped_)
+			::munmap(const_cast<char *>(data_), size_);
+#endif
+	}
+
+	bool SnapshotReader::has(const std::string &name) const
+	{
+		for (const Entry &e : entries_)
+			if (e.name == name)
+				return true;
+		return false;
+	}
+
+	const SnapshotReader::Entry &SnapshotReader::find(const std::string &name, const uint32_t type) const
+	{
+		for (const Entry &e : entries_)
+		{
+			if (e.name != name)
+				continue;
+			if (e.type != type)
+				log_and_throw_error("Array {} of snapshot {} has type {}, expected {}", name, path_, e.type, type);
+			return e;
+		}
+		log_and_throw_error("Snapshot {} has no array {}", path_, name);
+		return entries_.front(); // unreachable
+	}
+
+	Eigen::Map<const Eigen::MatrixXd> SnapshotReader::matrix(const std::string &name) const
+	{
+		const Entry &e = find(name, FLOAT64);
+		return Eigen::Map<const Eigen::MatrixXd>(reinterpret_cast<const double *>(data_ + e.offset), e.rows, e.cols);
+	}
+
+	Eigen::Map<const Eigen::MatrixXi> SnapshotReader::int_matrix(const std::string &name) const
+	{
+		const Entry &e = find(name, INT32);
+		return Eigen::Map<const Eigen::MatrixXi>(reinterpret_cast<const int *>(data_ + e.offset), e.rows, e.cols);
+	}
+
+	Eigen::Map<const StiffnessMatrix> SnapshotReader::sparse(const std::string &name) const
+	{
+		typedef StiffnessMatrix::StorageIndex Index;
+		const uint32_t index_type = sizeof(Index) == 4 ? INT32 : INT64;
+
+		const Entry &outer = find(name + "/outer", index_type);
+		const Entry &inner = find(name + "/inner", index_type);
+		const Entry &values = find(name + "/values", FLOAT64);
+		const Eigen::Map<const Eigen::MatrixXd> size = matrix(name + "/size");
+
+		const Index rows = Index(size(0)), cols = Index(size(1));
+		if (outer.rows != cols + 1 || inner.rows != values.rows)
+			log_and_throw_error("Sparse matrix {} of snapshot {} is corrupted", name, path_);
+
+		return Eigen::Map<const StiffnessMatrix>(
+			rows, cols, Index(values.rows),
+			reinterpret_cast<const Index *>(data_ + outer.offset),
+			reinterpret_cast<const Index *>(data_ + inner.offset),
+			reinterpret_cast<const double *>(data_ + values.offset));
+	}
+} // namespace polyfem::io
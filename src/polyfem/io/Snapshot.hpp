@@ -0,0 +1,93 @@
+#pragma once
+
+#include <polyfem/utils/Types.hpp>
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace polyfem::io
+{
+	/// Versioned binary file of named dense and sparse arrays, used for the restart snapshots.
+	/// The arrays are stored after a table of contents, each one 64 bytes aligned and in the memory
+	/// layout of Eigen (column major), so SnapshotReader maps the file and returns views on it without
+	/// parsing or copying. The file is little endian, the readers check the byte order and the version.
+	class SnapshotWriter
+	{
+	public:
+		void add(const std::string &name, const Eigen::MatrixXd &mat);
+		void add(const std::string &name, const Eigen::MatrixXi &mat);
+		/// stored as name/outer, name/inner, and name/values, the matrix is compressed if needed
+		void add(const std::string &name, const StiffnessMatrix &mat);
+
+		/// writes all the arrays, replaces the file
+		void write(const std::string &path) const;
+
+	private:
+		struct Entry
+		{
+			std::string name;
+			uint32_t type;
+			int64_t rows;
+			int64_t cols;
+			std::vector<char> data;
+		};
+
+		template <typename Scalar>
+		void add_array(const std::string &name, const Scalar *data, const int64_t rows, const int64_t cols);
+
+		std::vector<Entry> entries_;
+	};
+
+	/// Read-only view of a snapshot written by SnapshotWriter.
+	/// The file is memory mapped (read into memory where mmap is not available), the returned maps are
+	/// valid as long as the reader exists.
+	class SnapshotReader
+	{
+	public:
+		/// format version written by SnapshotWriter, files with another version are rejected
+		static constexpr uint32_t VERSION = 1;
+
+		/// opens and maps the file, throws if it is not a valid snapshot
+		explicit SnapshotReader(const std::string &path);
+		~SnapshotReader();
+
+		SnapshotReader(const SnapshotReader &) = delete;
+		SnapshotReader &operator=(const SnapshotReader &) = delete;
+
+		bool has(const std::string &name) const;
+
+		/// dense double array, throws if it does not exist or has another type
+		Eigen::Map<const Eigen::MatrixXd> matrix(const std::string &name) const;
+		/// dense int array, throws if it does not exist or has another type
+		Eigen::Map<const Eigen::MatrixXi> int_matrix(const std::string &name) const;
+		/// sparse matrix, throws if it does not exist or was written with another index type
+		Eigen::Map<const StiffnessMatrix> sparse(const std::string &name) const;
+
+		inline const std::string &path() const { return path_; }
+
+	private:
+		struct Entry
+		{
+			std::string name;
+			uint32_t type;
+			int64_t rows;
+			int64_t cols;
+			uint64_t offset;
+		};
+
+		const Entry &find(const std::string &name, const uint32_t type) const;
+
+		std::string path_;
+		const char *data_ = nullptr;
+		size_t size_ = 0;
+		/// file content when it is not mapped
+		std::vector<char> buffer_;
+		bool mapped_ = false;
+
+		std::vector<Entry> entries_;
+	};
+} // namespace polyfem::io
@@ -1,6 +1,7 @@
 #include "ALSolver.hpp"
 
 #include <polyfem/utils/Logger.hpp>
+#include <polyfem/utils/Timer.hpp>
 
 namespace polyfem::solver
 {
@@ -24,6 +25,7 @@ namespace polyfem::solver
 
 	void ALSolver::solve_al(std::shared_ptr<NLSolver> nl_solver,NLProblem &nl_problem, Eigen::MatrixXd &sol)
 	{
+		POLYFEM_PROFILE_SCOPE("BC solve");
 		assert(sol.size() == nl_problem.full_size());
 
 		Eigen::VectorXd tmp_sol = nl_problem.full_to_reduced(sol);
@@ -85,6 +87,7 @@ namespace polyfem::solver
 
 	void ALSolver::solve_reduced(std::shared_ptr<NLSolver> nl_solver,NLProblem &nl_problem, Eigen::MatrixXd &sol)
 	{
+		POLYFEM_PROFILE_SCOPE("reduced solve");
 		assert(sol.size() == nl_problem.full_size());
 
 		Eigen::VectorXd tmp_sol = nl_problem.full_to_reduced(sol);
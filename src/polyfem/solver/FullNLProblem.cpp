@@ -1,5 +1,7 @@
 #include "FullNLProblem.hpp"
 
+#include <polyfem/utils/Timer.hpp>
+
 namespace polyfem::solver
 {
 	FullNLProblem::FullNLProblem(const std::vector<std::shared_ptr<Form>> &forms)
@@ -11,6 +13,7 @@ namespace polyfem::solver
 	{
 		for (auto &f : forms_)
 			f->init(x);
+		clear_value_memos();
 	}
 
 	void FullNLProblem::set_project_to_psd(bool project_to_psd)
@@ -23,12 +26,14 @@ namespace polyfem::solver
 	{
 		for (auto &f : forms_)
 			f->init_lagging(x);
+		clear_value_memos();
 	}
 
 	void FullNLProblem::update_lagging(const TVector &x, const int iter_num)
 	{
 		for (auto &f : forms_)
 			f->update_lagging(x, iter_num);
+		clear_value_memos();
 	}
 
 	int FullNLProblem::max_lagging_iterations() const
@@ -49,6 +54,7 @@ namespace polyfem::solver
 
 	void FullNLProblem::line_search_begin(const TVector &x0, const TVector &x1)
 	{
+		POLYFEM_PROFILE_SCOPE("line search begin");
 		for (auto &f : forms_)
 			f->line_search_begin(x0, x1);
 	}
@@ -61,6 +67,7 @@ namespace polyfem::solver
 
 	double FullNLProblem::max_step_size(const TVector &x0, const TVector &x1) const
 	{
+		POLYFEM_PROFILE_SCOPE("max step size");
 		double step = 1;
 		for (auto &f : forms_)
 			if (f->enabled())
@@ -78,6 +85,7 @@ namespace polyfem::solver
 
 	bool FullNLProblem::is_step_collision_free(const TVector &x0, const TVector &x1) const
 	{
+		POLYFEM_PROFILE_SCOPE("step collision check");
 		for (auto &f : forms_)
 			if (f->enabled() && !f->is_step_collision_free(x0, x1))
 				return false;
@@ -88,8 +96,23 @@ namespace polyfem::solver
 	{
 		double val = 0;
 		for (auto &f : forms_)
+		{
+			if (!f->enabled())
+				continue;
+			POLYFEM_PROFILE_SCOPE([&] { return f->name() + " value"; });
+			val += f->value(x);
+		}
+		return val;
+	}
+
+	double FullNLProblem::memoized_value(const TVector &x) const
+	{
+		double val = 0;
+		for (const auto &f : forms_)
+		{
 			if (f->enabled())
-				val += f->value(x);
+				val += f->memoized_value(x);
+		}
 		return val;
 	}
 
@@ -100,12 +123,30 @@ namespace polyfem::solver
 		{
 			if (!f->enabled())
 				continue;
+			POLYFEM_PROFILE_SCOPE([&] { return f->name() + " gradient"; });
 			TVector tmp;
 			f->first_derivative(x, tmp);
 			grad += tmp;
 		}
 	}
 
+	double FullNLProblem::value_and_gradient(const TVector &x, TVector &grad)
+	{
+		double val = 0;
+		grad = TVector::Zero(x.size());
+		for (auto &f : forms_)
+		{
+			if (!f->enabled())
+				continue;
+			POLYFEM_PROFILE_SCOPE([&] { return f->name() + " value and gradient"; });
+			TVector tmp;
+			val += f->value_and_first_derivative(x, tmp);
+			grad += tmp;
+		}
+
+		return val;
+	}
+
 	void FullNLProblem::hessian(const TVector &x, THessian &hessian)
 	{
 		hessian.resize(x.size(), x.size());
@@ -113,6 +154,7 @@ namespace polyfem::solver
 		{
 			if (!f->enabled())
 				continue;
+			POLYFEM_PROFILE_SCOPE([&] { return f->name() + " hessian"; });
 			THessian tmp;
 			f->second_derivative(x, tmp);
 			hessian += tmp;
@@ -15,9 +15,17 @@ namespace polyfem::solver
 		virtual void init(const TVector &x0) override;
 
 		virtual double value(const TVector &x) override;
+		/// Value at the full solution x from the values memoized by the forms (see Form::memoized_value),
+		/// for the outputs that report the energy after the solve
+		double memoized_value(const TVector &x) const;
 		virtual void gradient(const TVector &x, TVector &gradv) override;
 		virtual void hessian(const TVector &x, THessian &hessian) override;
 
+		/// Value and gradient of the sum of the forms, each form shares the work between the two
+		/// (see Form::value_and_first_derivative). For the callers that need both at the same x,
+		/// value and gradient stay independent.
+		virtual double value_and_gradient(const TVector &x, TVector &gradv);
+
 		virtual bool is_step_valid(const TVector &x0, const TVector &x1) const override;
 		virtual bool is_step_collision_free(const TVector &x0, const TVector &x1) const;
 		virtual double max_step_size(const TVector &x0, const TVector &x1) const override;
@@ -37,9 +45,23 @@ namespace polyfem::solver
 
 		std::vector<std::shared_ptr<Form>> &forms() { return forms_; }
 
+		/// Enables the value memo of every form (see Form::enable_value_memo), for the outputs using memoized_value
+		void enable_value_memos(const bool val)
+		{
+			for (auto &f : forms_)
+				f->enable_value_memo(val);
+		}
+
 		virtual bool stop(const TVector &x) override { return false; }
 
 	protected:
 		std::vector<std::shared_ptr<Form>> forms_;
+
+		/// Drops the values memoized by the forms (see Form::memoized_value), needed when the forms change without a change of x
+		void clear_value_memos()
+		{
+			for (auto &f : forms_)
+				f->clear_value_memo();
+		}
 	};
 } // namespace polyfem::solver
@@ -1,6 +1,7 @@
 #include "NLProblem.hpp"
 
 #include <polyfem/io/OBJWriter.hpp>
+#include <polyfem/utils/Timer.hpp>
 
 /*
 m \frac{\partial^2 u}{\partial t^2} = \psi = \text{div}(\sigma[u])\newline
@@ -32,6 +33,7 @@ namespace polyfem::solver
 		  t_(0)
 	{
 		use_reduced_size();
+		init_full_to_reduced_indices();
 	}
 
 	NLProblem::NLProblem(
@@ -54,29 +56,67 @@ namespace polyfem::solver
 		assert(std::is_sorted(boundary_nodes.begin(), boundary_nodes.end()));
 		assert(boundary_nodes.size() == 0 || (boundary_nodes.front() >= 0 && boundary_nodes.back() < full_size_));
 		use_reduced_size();
+		init_full_to_reduced_indices();
+	}
+
+	void NLProblem::init_full_to_reduced_indices()
+	{
+		assert(std::is_sorted(boundary_nodes_.begin(), boundary_nodes_.end()));
+
+		full_to_reduced_indices_.resize(full_size_);
+		reduced_to_full_indices_.resize(reduced_size_);
+		int index = 0;
+		size_t k = 0;
+		for (int i = 0; i < full_size_; ++i)
+		{
+			if (k < boundary_nodes_.size() && boundary_nodes_[k] == i)
+			{
+				++k;
+				full_to_reduced_indices_[i] = -1;
+			}
+			else
+			{
+				reduced_to_full_indices_[index] = i;
+				full_to_reduced_indices_[i] = index++;
+			}
+		}
+		assert(index == reduced_size_);
+	}
+
+	void NLProblem::init(const TVector &x0)
+	{
+		// the boundary conditions might have changed since the last solve
+		update_boundary_values_cache();
+		FullNLProblem::init(x0);
 	}
 
 	void NLProblem::init_lagging(const TVector &x)
 	{
-		FullNLProblem::init_lagging(reduced_to_full(x));
+		reduced_to_full(x, full_x0_);
+		FullNLProblem::init_lagging(full_x0_);
 	}
 
 	void NLProblem::update_lagging(const TVector &x, const int iter_num)
 	{
-		FullNLProblem::update_lagging(reduced_to_full(x), iter_num);
+		reduced_to_full(x, full_x0_);
+		FullNLProblem::update_lagging(full_x0_, iter_num);
 	}
 
 	void NLProblem::update_quantities(const double t, const TVector &x)
 	{
 		t_ = t;
-		const TVector full = reduced_to_full(x);
+		update_boundary_values_cache();
+		reduced_to_full(x, full_x0_);
 		for (auto &f : forms_)
-			f->update_quantities(t, full);
+			f->update_quantities(t, full_x0_);
+		clear_value_memos();
 	}
 
 	void NLProblem::line_search_begin(const TVector &x0, const TVector &x1)
 	{
-		FullNLProblem::line_search_begin(reduced_to_full(x0), reduced_to_full(x1));
+		reduced_to_full(x0, full_x0_);
+		reduced_to_full(x1, full_x1_);
+		FullNLProblem::line_search_begin(full_x0_, full_x1_);
 	}
 
 	double NLProblem::max_step_size(const TVector &x0, const TVector &x1) const
@@ -97,28 +137,110 @@ namespace polyfem::solver
 	double NLProblem::value(const TVector &x)
 	{
 		// TODO: removed fearure const bool only_elastic
-		return FullNLProblem::value(reduced_to_full(x));
+		reduced_to_full(x, full_x0_);
+		return FullNLProblem::value(full_x0_);
 	}
 
 	void NLProblem::gradient(const TVector &x, TVector &grad)
 	{
-		TVector full_grad;
-		FullNLProblem::gradient(reduced_to_full(x), full_grad);
-		grad = full_to_reduced(full_grad);
+		reduced_to_full(x, full_x0_);
+		FullNLProblem::gradient(full_x0_, full_grad_);
+		full_to_reduced(full_grad_, grad);
+	}
+
+	double NLProblem::value_and_gradient(const TVector &x, TVector &grad)
+	{
+		reduced_to_full(x, full_x0_);
+		const double val = FullNLProblem::value_and_gradient(full_x0_, full_grad_);
+		full_to_reduced(full_grad_, grad);
+		return val;
 	}
 
 	void NLProblem::hessian(const TVector &x, THessian &hessian)
 	{
-		THessian full_hessian;
-		FullNLProblem::hessian(reduced_to_full(x), full_hessian);
-		assert(full_hessian.rows() == full_size());
-		assert(full_hessian.cols() == full_size());
-		utils::full_to_reduced_matrix(full_size(), current_size(), boundary_nodes_, full_hessian, hessian);
+		POLYFEM_SCOPED_TIMER("reduced hessian");
+
+		reduced_to_full(x, full_x0_);
+		const TVector &full = full_x0_;
+		const int size = current_size();
+
+		// every form Hessian is reduced as soon as it is assembled and only the reduced matrices are summed,
+		// no full size sum or full to reduced copy is needed
+		hessian.resize(size, size);
+		bool first = true;
+		for (const auto &f : forms_)
+		{
+			if (!f->enabled())
+				continue;
+
+			POLYFEM_PROFILE_SCOPE([&] { return f->name() + " hessian"; });
+			THessian form_hessian;
+			f->second_derivative(full, form_hessian);
+			assert(form_hessian.rows() == full_size());
+			assert(form_hessian.cols() == full_size());
+
+			if (first)
+			{
+				full_to_reduced_hessian(form_hessian, hessian);
+				first = false;
+			}
+			else
+			{
+				THessian reduced_form_hessian;
+				full_to_reduced_hessian(form_hessian, reduced_form_hessian);
+				// free the full matrix before the sum
+				form_hessian.resize(0, 0);
+				form_hessian.data().squeeze();
+				hessian += reduced_form_hessian;
+			}
+		}
+	}
+
+	void NLProblem::full_to_reduced_hessian(const THessian &full, THessian &reduced) const
+	{
+		const int size = current_size();
+		if (size == full_size())
+		{
+			reduced = full;
+			return;
+		}
+
+		// the reduced indices are increasing, so the rows of every column stay sorted
+		// and the entries can be appended in order after counting them
+		Eigen::VectorXi col_sizes = Eigen::VectorXi::Zero(size);
+		for (Eigen::Index k = 0; k < full.outerSize(); ++k)
+		{
+			const int col = full_to_reduced_indices_[k];
+			if (col < 0)
+				continue;
+			for (THessian::InnerIterator it(full, k); it; ++it)
+			{
+				if (full_to_reduced_indices_[it.row()] >= 0)
+					++col_sizes[col];
+			}
+		}
+
+		reduced.resize(size, size);
+		reduced.reserve(col_sizes);
+		for (Eigen::Index k = 0; k < full.outerSize(); ++k)
+		{
+			const int col = full_to_reduced_indices_[k];
+			if (col < 0)
+				continue;
+			for (THessian::InnerIterator it(full, k); it; ++it)
+			{
+				const int row = full_to_reduced_indices_[it.row()];
+				if (row >= 0)
+					reduced.insert(row, col) = it.value();
+			}
+		}
+		reduced.makeCompressed();
 	}
 
 	void NLProblem::solution_changed(const TVector &newX)
 	{
-		FullNLProblem::solution_changed(reduced_to_full(newX));
+		reduced_to_full(newX, full_x0_);
+		FullNLProblem::solution_changed(full_x0_);
 	}
 
 	void NLProblem::post_step(const polysolve::nonlinear::PostStepData &data)
@@ -138,98 +260,86 @@ namespace polyfem::solver
 
 	void NLProblem::set_apply_DBC(const TVector &x, const bool val)
 	{
-		TVector full = reduced_to_full(x);
+		reduced_to_full(x, full_x0_);
 		for (auto &form : forms_)
-			form->set_apply_DBC(full, val);
+			form->set_apply_DBC(full_x0_, val);
+		clear_value_memos();
 	}
 
 	NLProblem::TVector NLProblem::full_to_reduced(const TVector &full) const
 	{
 		TVector reduced;
-		full_to_reduced_aux(boundary_nodes_, full_size(), current_size(), full, reduced);
+		full_to_reduced(full, reduced);
 		return reduced;
 	}
 
 	NLProblem::TVector NLProblem::reduced_to_full(const TVector &reduced) const
 	{
 		TVector full;
-		reduced_to_full_aux(boundary_nodes_, full_size(), current_size(), reduced, boundary_values(), full);
+		reduced_to_full(reduced, full);
 		return full;
 	}
 
-	Eigen::MatrixXd NLProblem::boundary_values() const
-	{
-		Eigen::MatrixXd result = Eigen::MatrixXd::Zero(full_size(), 1);
-		// rhs_assembler->set_bc(*local_boundary_, boundary_nodes_, n_boundary_samples_, local_neumann_boundary_, result, t_);
-		rhs_assembler_->set_bc(*local_boundary_, boundary_nodes_, n_boundary_samples_, std::vector<mesh::LocalBoundary>(), result, Eigen::MatrixXd(), t_);
-		return result;
-	}
-
-	template <class FullMat, class ReducedMat>
-	void NLProblem::full_to_reduced_aux(const std::vector<int> &boundary_nodes, const int full_size, const int reduced_size, const FullMat &full, ReducedMat &reduced)
+	void NLProblem::full_to_reduced(const TVector &full, TVector &reduced) const
 	{
-		using namespace polyfem;
-
 		// Reduced is already at the full size
-		if (full_size == reduced_size || full.size() == reduced_size)
+		if (full_size() == current_size() || full.size() == current_size())
 		{
 			reduced = full;
 			return;
 		}
 
-		assert(full.size() == full_size);
-		assert(full.cols() == 1);
-		reduced.resize(reduced_size, 1);
-
-		assert(std::is_sorted(boundary_nodes.begin(), boundary_nodes.end()));
-
-		long j = 0;
-		size_t k = 0;
-		for (int i = 0; i < full.size(); ++i)
-		{
-			if (k < boundary_nodes.size() && boundary_nodes[k] == i)
-			{
-				++k;
-				continue;
-			}
+		assert(full.size() == full_size());
+		reduced.resize(current_size());
+		assert(reduced.size() == reduced_to_full_indices_.size());
 
-			reduced(j++) = full(i);
-		}
-		assert(j == reduced.size());
+		for (int i = 0; i < reduced.size(); ++i)
+			reduced(i) = full(reduced_to_full_indices_[i]);
 	}
 
-	template <class ReducedMat, class FullMat>
-	void NLProblem::reduced_to_full_aux(const std::vector<int> &boundary_nodes, const int full_size, const int reduced_size, const ReducedMat &reduced, const Eigen::MatrixXd &rhs, FullMat &full)
+	void NLProblem::reduced_to_full(const TVector &reduced, TVector &full) const
 	{
-		using namespace polyfem;
-
 		// Full is already at the reduced size
-		if (full_size == reduced_size || full_size == reduced.size())
+		if (full_size() == current_size() || full_size() == reduced.size())
 		{
 			full = reduced;
 			return;
 		}
 
-		assert(reduced.size() == reduced_size);
-		assert(reduced.cols() == 1);
-		full.resize(full_size, 1);
+		assert(reduced.size() == current_size());
+		assert(reduced.size() == reduced_to_full_indices_.size());
+		full.resize(full_size());
 
-		assert(std::is_sorted(boundary_nodes.begin(), boundary_nodes.end()));
+		const Eigen::MatrixXd &rhs = cached_boundary_values();
+		for (const int i : boundary_nodes_)
+			full(i) = rhs(i);
+		for (int i = 0; i < reduced.size(); ++i)
+			full(reduced_to_full_indices_[i]) = reduced(i);
+	}
 
-		long j = 0;
-		size_t k = 0;
-		for (int i = 0; i < full.size(); ++i)
-		{
-			if (k < boundary_nodes.size() && boundary_nodes[k] == i)
-			{
-				++k;
-				full(i) = rhs(i);
-				continue;
-			}
+	void NLProblem::update_boundary_values_cache()
+	{
+		boundary_values_cached_ = false;
+		if (!boundary_nodes_.empty())
+			cached_boundary_values();
+	}
 
-			full(i) = reduced(j++);
+	const Eigen::MatrixXd &NLProblem::cached_boundary_values() const
+	{
+		if (!boundary_values_cached_)
+		{
+			boundary_values_cache_ = boundary_values();
+			boundary_values_cached_ = true;
 		}
+		assert(boundary_values_cache_.size() == full_size());
+		return boundary_values_cache_;
+	}
 
-		assert(j == reduced.size());
+	Eigen::MatrixXd NLProblem::boundary_values() const
+	{
+		Eigen::MatrixXd result = Eigen::MatrixXd::Zero(full_size(), 1);
+		// rhs_assembler->set_bc(*local_boundary_, boundary_nodes_, n_boundary_samples_, local_neumann_boundary_, result, t_);
+		rhs_assembler_->set_bc(*local_boundary_, boundary_nodes_, n_boundary_samples_, std::vector<mesh::LocalBoundary>(), result, Eigen::MatrixXd(), t_);
+		return result;
 	}
 } // namespace polyfem::solver
@@ -28,9 +28,12 @@ namespace polyfem::solver
 				  const double t,
 				  const std::vector<std::shared_ptr<Form>> &forms);
 
+		void init(const TVector &x0) override;
+
 		virtual double value(const TVector &x) override;
 		virtual void gradient(const TVector &x, TVector &gradv) override;
 		virtual void hessian(const TVector &x, THessian &hessian) override;
+		virtual double value_and_gradient(const TVector &x, TVector &gradv) override;
 
 		bool is_step_valid(const TVector &x0, const TVector &x1) const override;
 		bool is_step_collision_free(const TVector &x0, const TVector &x1) const override;
@@ -57,6 +60,15 @@ namespace polyfem::solver
 		virtual TVector full_to_reduced(const TVector &full) const;
 		virtual TVector reduced_to_full(const TVector &reduced) const;
 
+		/// Same as above, writing into the given vector (no allocation if it already has the right size)
+		void full_to_reduced(const TVector &full, TVector &reduced) const;
+		void reduced_to_full(const TVector &reduced, TVector &full) const;
+
+		/// Full index of every reduced variable (gather map of full_to_reduced)
+		const Eigen::VectorXi &reduced_to_full_indices() const { return reduced_to_full_indices_; }
+		/// Reduced index of every full variable, -1 for boundary nodes (scatter map of reduced_to_full)
+		const Eigen::VectorXi &full_to_reduced_indices() const { return full_to_reduced_indices_; }
+
 		void set_apply_DBC(const TVector &x, const bool val);
 
 	protected:
@@ -84,10 +96,26 @@ namespace polyfem::solver
 		const int n_boundary_samples_;
 		double t_;
 
-		template <class FullMat, class ReducedMat>
-		static void full_to_reduced_aux(const std::vector<int> &boundary_nodes, const int full_size, const int reduced_size, const FullMat &full, ReducedMat &reduced);
+		/// Index in the reduced problem of every full variable, -1 for boundary nodes
+		Eigen::VectorXi full_to_reduced_indices_;
+		/// Index in the full problem of every reduced variable
+		Eigen::VectorXi reduced_to_full_indices_;
+
+		/// boundary_values() at t_, it integrates the boundary conditions so it is computed once per time step
+		const Eigen::MatrixXd &cached_boundary_values() const;
+		/// Recomputes the cached boundary values in init and update_quantities, so that the const
+		/// evaluations (i.e., max_step_size, is_step_valid) only read the cache and can run concurrently
+		void update_boundary_values_cache();
+		mutable Eigen::MatrixXd boundary_values_cache_;
+		mutable bool boundary_values_cached_ = false;
+
+		/// Full size scratch vectors reused by the non-const reduced evaluations,
+		/// the const ones use their own vectors so that they can be called concurrently
+		TVector full_x0_, full_x1_, full_grad_;
+
+		void init_full_to_reduced_indices();
 
-		template <class ReducedMat, class FullMat>
-		static void reduced_to_full_aux(const std::vector<int> &boundary_nodes, const int full_size, const int reduced_size, const ReducedMat &reduced, const Eigen::MatrixXd &rhs, FullMat &full);
+		/// Copies the entries of the full size Hessian that are not on boundary nodes, in one pass without triplets.
+		void full_to_reduced_hessian(const THessian &full, THessian &reduced) const;
 	};
 } // namespace polyfem::solver
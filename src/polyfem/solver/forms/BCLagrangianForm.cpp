@@ -114,6 +114,7 @@ namespace polyfem::solver
 
 	void BCLagrangianForm::update_target(const double t)
 	{
+		clear_value_memo();
 		assert(rhs_assembler_ != nullptr);
 		assert(local_boundary_ != nullptr);
 		assert(local_neumann_boundary_ != nullptr);
@@ -125,6 +126,7 @@ namespace polyfem::solver
 
 	void BCLagrangianForm::update_lagrangian(const Eigen::VectorXd &x, const double k_al)
 	{
+		clear_value_memo();
 		lagr_mults_ -= k_al * masked_lumped_mass_sqrt_ * (x - target_x_);
 	}
 } // namespace polyfem::solver
@@ -103,6 +103,7 @@ namespace polyfem::solver
 
 	void BCPenaltyForm::update_target(const double t)
 	{
+		clear_value_memo();
 		assert(rhs_assembler_ != nullptr);
 		assert(local_boundary_ != nullptr);
 		assert(local_neumann_boundary_ != nullptr);
@@ -47,7 +47,7 @@ namespace polyfem::solver
 
 	void ContactForm::init(const Eigen::VectorXd &x)
 	{
-		update_constraint_set(compute_displaced_surface(x));
+		update_constraint_set(displaced_surface(x));
 	}
 
 	void ContactForm::force_shape_derivative(const ipc::CollisionConstraints &contact_set, const Eigen::MatrixXd &solution, const Eigen::VectorXd &adjoint_sol, Eigen::VectorXd &term)
@@ -62,7 +62,7 @@ namespace polyfem::solver
 
 	void ContactForm::update_quantities(const double t, const Eigen::VectorXd &x)
 	{
-		update_constraint_set(compute_displaced_surface(x));
+		update_constraint_set(displaced_surface(x));
 	}
 
 	Eigen::MatrixXd ContactForm::compute_displaced_surface(const Eigen::VectorXd &x) const
@@ -121,30 +121,58 @@ namespace polyfem::solver
 		logger().debug("adaptive barrier form stiffness {}", barrier_stiffness());
 	}
 
+	const Eigen::MatrixXd &ContactForm::displaced_surface(const Eigen::VectorXd &x) const
+	{
+		if (displaced_surface_x_.size() != x.size() || displaced_surface_x_ != x)
+		{
+			displaced_surface_ = compute_displaced_surface(x);
+			displaced_surface_x_ = x;
+		}
+		return displaced_surface_;
+	}
+
 	void ContactForm::update_constraint_set(const Eigen::MatrixXd &displaced_surface)
 	{
 		// Store the previous value used to compute the constraint set to avoid duplicate computation.
-		static Eigen::MatrixXd cached_displaced_surface;
-		if (cached_displaced_surface.size() == displaced_surface.size() && cached_displaced_surface == displaced_surface)
+		if (constraint_set_surface_.size() == displaced_surface.size() && constraint_set_surface_ == displaced_surface)
 			return;
 
 		if (use_cached_candidates_)
+		{
 			constraint_set_.build(
 				candidates_, collision_mesh_, displaced_surface, dhat_);
+		}
 		else
+		{
+			// Distances change by at most twice the vertex displacement, so candidates built with an
+			// inflation of dhat / 2 + slack still contain every pair closer than dhat.
+			const double slack = candidates_slack_ * dhat_;
+			const bool can_reuse = reused_candidates_surface_.rows() == displaced_surface.rows()
+								   && reused_candidates_surface_.cols() == displaced_surface.cols()
+								   && (displaced_surface - reused_candidates_surface_).rowwise().norm().maxCoeff() <= slack;
+
+			if (!can_reuse)
+			{
+				POLYFEM_SCOPED_TIMER("contact broad phase");
+				reused_candidates_.build(
+					collision_mesh_, displaced_surface, /*inflation_radius=*/dhat_ / 2 + slack, broad_phase_method_);
+				reused_candidates_surface_ = displaced_surface;
+			}
+
 			constraint_set_.build(
-				collision_mesh_, displaced_surface, dhat_, dmin_, broad_phase_method_);
-		cached_displaced_surface = displaced_surface;
+				reused_candidates_, collision_mesh_, displaced_surface, dhat_);
+		}
+		constraint_set_surface_ = displaced_surface;
 	}
 
 	double ContactForm::value_unweighted(const Eigen::VectorXd &x) const
 	{
-		return constraint_set_.compute_potential(collision_mesh_, compute_displaced_surface(x), dhat_);
+		return constraint_set_.compute_potential(collision_mesh_, displaced_surface(x), dhat_);
 	}
 
 	Eigen::VectorXd ContactForm::value_per_element_unweighted(const Eigen::VectorXd &x) const
 	{
-		const Eigen::MatrixXd V = compute_displaced_surface(x);
+		const Eigen::MatrixXd &V = displaced_surface(x);
 		assert(V.rows() == collision_mesh_.num_vertices());
 
 		const size_t num_vertices = collision_mesh_.num_vertices();
@@ -194,24 +222,34 @@ namespace polyfem::solver
 
 	void ContactForm::first_derivative_unweighted(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const
 	{
-		gradv = constraint_set_.compute_potential_gradient(collision_mesh_, compute_displaced_surface(x), dhat_);
+		gradv = constraint_set_.compute_potential_gradient(collision_mesh_, displaced_surface(x), dhat_);
 		gradv = collision_mesh_.to_full_dof(gradv);
 	}
 
+	double ContactForm::value_and_first_derivative(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const
+	{
+		const Eigen::MatrixXd &V = displaced_surface(x);
+		const double val = constraint_set_.compute_potential(collision_mesh_, V, dhat_);
+		gradv = weight() * collision_mesh_.to_full_dof(constraint_set_.compute_potential_gradient(collision_mesh_, V, dhat_));
+		memoize_value(x, val);
+		return weight() * val;
+	}
+
 	void ContactForm::second_derivative_unweighted(const Eigen::VectorXd &x, StiffnessMatrix &hessian) const
 	{
 		POLYFEM_SCOPED_TIMER("barrier hessian");
-		hessian = constraint_set_.compute_potential_hessian(collision_mesh_, compute_displaced_surface(x), dhat_, project_to_psd_);
+		hessian = constraint_set_.compute_potential_hessian(collision_mesh_, displaced_surface(x), dhat_, project_to_psd_);
 		hessian = collision_mesh_.to_full_dof(hessian);
 	}
 
 	void ContactForm::solution_changed(const Eigen::VectorXd &new_x)
 	{
-		update_constraint_set(compute_displaced_surface(new_x));
+		update_constraint_set(displaced_surface(new_x));
 	}
 
 	double ContactForm::max_step_size(const Eigen::VectorXd &x0, const Eigen::VectorXd &x1) const
 	{
+		POLYFEM_PROFILE_SCOPE("CCD");
 		// Extract surface only
 		const Eigen::MatrixXd V0 = compute_displaced_surface(x0);
 		const Eigen::MatrixXd V1 = compute_displaced_surface(x1);
@@ -280,7 +318,7 @@ namespace polyfem::solver
 		if (data.iter_num == 0)
 			return;
 
-		const Eigen::MatrixXd displaced_surface = compute_displaced_surface(data.x);
+		const Eigen::MatrixXd &displaced_surface = this->displaced_surface(data.x);
 
 		const double curr_distance = constraint_set_.compute_minimum_distance(collision_mesh_, displaced_surface);
 
@@ -313,6 +351,7 @@ namespace polyfem::solver
 
 	bool ContactForm::is_step_collision_free(const Eigen::VectorXd &x0, const Eigen::VectorXd &x1) const
 	{
+		POLYFEM_PROFILE_SCOPE("CCD");
 		const auto displaced0 = compute_displaced_surface(x0);
 		const auto displaced1 = compute_displaced_surface(x1);
 
@@ -82,6 +82,12 @@ namespace polyfem::solver
 		virtual void second_derivative_unweighted(const Eigen::VectorXd &x, StiffnessMatrix &hessian) const override;
 
 	public:
+		/// @brief Compute the barrier potential and its first derivative wrt x on the same displaced surface
+		/// @param[in] x Current solution
+		/// @param[out] gradv Output gradient of the value wrt x
+		/// @return Computed value
+		double value_and_first_derivative(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const override;
+
 		/// @brief Update time-dependent fields
 		/// @param t Current time
 		/// @param x Current solution at time t
@@ -139,12 +145,20 @@ namespace polyfem::solver
 
 		double dhat() const { return dhat_; }
 		ipc::CollisionConstraints get_constraint_set() const { return constraint_set_; }
+		/// @brief Displaced surface at which the reused broad phase candidates were built
+		const Eigen::MatrixXd &candidates_surface() const { return reused_candidates_surface_; }
+		/// @brief Maximum vertex displacement from candidates_surface() for which the candidates are reused
+		double candidates_slack() const { return candidates_slack_ * dhat_; }
 
 	protected:
 		/// @brief Update the cached candidate set for the current solution
 		/// @param displaced_surface Vertex positions displaced by the current solution
 		void update_constraint_set(const Eigen::MatrixXd &displaced_surface);
 
+		/// @brief Displaced positions of the surface nodes, memoized for the last x
+		/// @note The reference is invalidated by the next call with a different x
+		const Eigen::MatrixXd &displaced_surface(const Eigen::VectorXd &x) const;
+
 		/// @brief Collision mesh
 		const ipc::CollisionMesh &collision_mesh_;
 
@@ -186,5 +200,19 @@ namespace polyfem::solver
 		ipc::CollisionConstraints constraint_set_;
 		/// @brief Cached candidate set for the current solution
 		ipc::Candidates candidates_;
+
+		/// @brief Solution and displaced surface of the last displaced_surface call
+		mutable Eigen::VectorXd displaced_surface_x_;
+		mutable Eigen::MatrixXd displaced_surface_;
+		/// @brief Displaced surface used to build constraint_set_
+		Eigen::MatrixXd constraint_set_surface_;
+
+		/// @brief Candidates of the last full broad phase (outside of the line search), inflated by
+		/// candidates_slack_. They contain all the active constraints as long as no vertex moved more
+		/// than candidates_slack_ from reused_candidates_surface_, so the broad phase can be skipped.
+		ipc::Candidates reused_candidates_;
+		Eigen::MatrixXd reused_candidates_surface_;
+		/// @brief Maximum vertex displacement for reusing the candidates, relative to dhat
+		static constexpr double candidates_slack_ = 0.5;
 	};
 } // namespace polyfem::solver
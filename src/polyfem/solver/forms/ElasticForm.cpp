@@ -3,6 +3,7 @@
 #include <polyfem/io/Evaluator.hpp>
 #include <polyfem/basis/ElementBases.hpp>
 #include <polyfem/assembler/MatParams.hpp>
+#include <polyfem/assembler/MaterialStateBuffer.hpp>
 #include <polyfem/utils/Timer.hpp>
 #include <polyfem/utils/MaybeParallelFor.hpp>
 #include <polyfem/assembler/ViscousDamping.hpp>
@@ -49,8 +50,7 @@ namespace polyfem::solver
 	{
 		if (assembler_.is_linear())
 			compute_cached_stiffness();
-		// mat_cache_ = std::make_unique<utils::DenseMatrixCache>();
-		mat_cache_ = std::make_unique<utils::SparseMatrixCache>();
+		scatter_map_ = std::make_unique<assembler::ElementScatterMap>();
 	}
 
 	double ElasticForm::value_unweighted(const Eigen::VectorXd &x) const
@@ -71,11 +71,32 @@ namespace polyfem::solver
 	void ElasticForm::first_derivative_unweighted(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const
 	{
 		Eigen::MatrixXd grad;
-		assembler_.assemble_gradient(is_volume_, n_bases_, bases_, geom_bases_,
-									 ass_vals_cache_, t_, dt_, x, x_prev_, grad);
+		if (element_coloring_ != nullptr)
+			assembler_.assemble_gradient(is_volume_, n_bases_, bases_, geom_bases_,
+										 ass_vals_cache_, t_, dt_, x, x_prev_, *element_coloring_, grad);
+		else
+			assembler_.assemble_gradient(is_volume_, n_bases_, bases_, geom_bases_,
+										 ass_vals_cache_, t_, dt_, x, x_prev_, grad);
 		gradv = grad;
 	}
 
+	double ElasticForm::value_and_first_derivative(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const
+	{
+		Eigen::MatrixXd grad;
+		double val;
+		if (element_coloring_ != nullptr)
+			val = assembler_.assemble_energy_and_gradient(
+				is_volume_, n_bases_, bases_, geom_bases_,
+				ass_vals_cache_, t_, dt_, x, x_prev_, *element_coloring_, grad);
+		else
+			val = assembler_.assemble_energy_and_gradient(
+				is_volume_, n_bases_, bases_, geom_bases_,
+				ass_vals_cache_, t_, dt_, x, x_prev_, grad);
+		gradv = weight() * grad;
+		memoize_value(x, val);
+		return weight() * val;
+	}
+
 	void ElasticForm::second_derivative_unweighted(const Eigen::VectorXd &x, StiffnessMatrix &hessian) const
 	{
 		POLYFEM_SCOPED_TIMER("elastic hessian");
@@ -89,10 +110,10 @@ namespace polyfem::solver
 		}
 		else
 		{
-			// NOTE: mat_cache_ is marked as mutable so we can modify it here
+			// NOTE: scatter_map_ is marked as mutable so we can modify it here
 			assembler_.assemble_hessian(
 				is_volume_, n_bases_, project_to_psd_, bases_,
-				geom_bases_, ass_vals_cache_, t_, dt_, x, x_prev_, *mat_cache_, hessian);
+				geom_bases_, ass_vals_cache_, t_, dt_, x, x_prev_, *scatter_map_, hessian);
 		}
 	}
 
@@ -113,6 +134,17 @@ namespace polyfem::solver
 		return true;
 	}
 
+	void ElasticForm::solution_changed(const Eigen::VectorXd &new_x)
+	{
+		if (assembler_.is_linear())
+			return;
+
+		// evaluate the deformation once, the energy, gradient, and hessian of new_x reuse it
+		const auto *nl_assembler = dynamic_cast<const assembler::NLAssembler *>(&assembler_);
+		if (nl_assembler && nl_assembler->material_state())
+			nl_assembler->material_state()->update(*nl_assembler, is_volume_, bases_, geom_bases_, ass_vals_cache_, t_, new_x);
+	}
+
 	void ElasticForm::compute_cached_stiffness()
 	{
 		if (assembler_.is_linear() && cached_stiffness_.size() == 0)
@@ -139,8 +171,7 @@ namespace polyfem::solver
 
 				for (int e = start; e < end; ++e)
 				{
-					assembler::ElementAssemblyValues &vals = local_storage.vals;
-					ass_vals_cache_.compute(e, is_volume_, bases_[e], geom_bases_[e], vals);
+					const assembler::ElementAssemblyValues &vals = ass_vals_cache_.get(e, is_volume_, bases_[e], geom_bases_[e], local_storage.vals);
 
 					const quadrature::Quadrature &quadrature = vals.quadrature;
 					local_storage.da = vals.det.array() * quadrature.weights.array();
@@ -181,8 +212,7 @@ namespace polyfem::solver
 
 				for (int e = start; e < end; ++e)
 				{
-					assembler::ElementAssemblyValues &vals = local_storage.vals;
-					ass_vals_cache_.compute(e, is_volume_, bases_[e], geom_bases_[e], vals);
+					const assembler::ElementAssemblyValues &vals = ass_vals_cache_.get(e, is_volume_, bases_[e], geom_bases_[e], local_storage.vals);
 
 					const quadrature::Quadrature &quadrature = vals.quadrature;
 					local_storage.da = vals.det.array() * quadrature.weights.array();
@@ -229,8 +259,7 @@ namespace polyfem::solver
 
 				for (int e = start; e < end; ++e)
 				{
-					assembler::ElementAssemblyValues &vals = local_storage.vals;
-					ass_vals_cache_.compute(e, is_volume_, bases_[e], geom_bases_[e], vals);
+					const assembler::ElementAssemblyValues &vals = ass_vals_cache_.get(e, is_volume_, bases_[e], geom_bases_[e], local_storage.vals);
 					assembler::ElementAssemblyValues gvals;
 					gvals.compute(e, is_volume_, vals.quadrature.points, geom_bases_[e], geom_bases_[e]);
 
@@ -294,8 +323,7 @@ namespace polyfem::solver
 
 				for (int e = start; e < end; ++e)
 				{
-					assembler::ElementAssemblyValues &vals = local_storage.vals;
-					ass_vals_cache_.compute(e, is_volume_, bases_[e], geom_bases_[e], vals);
+					const assembler::ElementAssemblyValues &vals = ass_vals_cache_.get(e, is_volume_, bases_[e], geom_bases_[e], local_storage.vals);
 					assembler::ElementAssemblyValues gvals;
 					gvals.compute(e, is_volume_, vals.quadrature.points, geom_bases_[e], geom_bases_[e]);
 
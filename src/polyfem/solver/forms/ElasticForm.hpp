@@ -48,12 +48,22 @@ namespace polyfem::solver
 		void second_derivative_unweighted(const Eigen::VectorXd &x, StiffnessMatrix &hessian) const override;
 
 	public:
+		/// @brief Compute the value and its first derivative wrt x in a single element loop
+		/// @param[in] x Current solution
+		/// @param[out] gradv Output gradient of the value wrt x
+		/// @return Computed value
+		double value_and_first_derivative(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const override;
+
 		/// @brief Determine if a step from solution x0 to solution x1 is allowed
 		/// @param x0 Current solution
 		/// @param x1 Proposed next solution
 		/// @return True if the step is allowed
 		bool is_step_valid(const Eigen::VectorXd &x0, const Eigen::VectorXd &x1) const override;
 
+		/// @brief Update cached fields upon a change in the solution
+		/// @param new_x New solution
+		void solution_changed(const Eigen::VectorXd &new_x) override;
+
 		/// @brief Update time-dependent fields
 		/// @param t Current time
 		/// @param x Current solution at time t
@@ -63,6 +73,14 @@ namespace polyfem::solver
 			x_prev_ = x;
 		}
 
+		/// @brief Use an element coloring to assemble the gradient and the Hessian without per-thread copies
+		/// @param coloring Coloring of the elements computed from the same bases, nullptr to disable it
+		void set_element_coloring(const utils::ElementColoring *coloring)
+		{
+			element_coloring_ = coloring != nullptr && !coloring->empty() ? coloring : nullptr;
+			scatter_map_->set_element_coloring(element_coloring_);
+		}
+
 		/// @brief Compute the derivative of the force wrt lame/damping parameters, then multiply the resulting matrix with adjoint_sol.
 		/// @param t Current time
 		/// @param[in] x Current solution
@@ -90,7 +108,8 @@ namespace polyfem::solver
 		const bool is_volume_;
 
 		StiffnessMatrix cached_stiffness_;                      ///< Cached stiffness matrix for linear elasticity
-		mutable std::unique_ptr<utils::MatrixCache> mat_cache_; ///< Matrix cache (mutable because it is modified in second_derivative_unweighted)
+		const utils::ElementColoring *element_coloring_ = nullptr;           ///< Optional element coloring (not owned)
+		mutable std::unique_ptr<assembler::ElementScatterMap> scatter_map_; ///< Element to Hessian scatter map (mutable because it is modified in second_derivative_unweighted)
 
 		/// @brief Compute the stiffness matrix (cached)
 		void compute_cached_stiffness();
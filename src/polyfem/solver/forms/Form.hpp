@@ -23,9 +23,38 @@ namespace polyfem::solver
 		/// @return Computed value
 		inline virtual double value(const Eigen::VectorXd &x) const
 		{
-			return weight() * value_unweighted(x);
+			const double val = value_unweighted(x);
+			memoize_value(x, val);
+			return weight() * val;
 		}
 
+		/// @brief Compute the value of the form multiplied with the weigth, reusing the last value computed at x
+		/// @note Used by the outputs (e.g., EnergyCSVWriter) so that they do not evaluate the energy again after the solve.
+		/// The value is only reused if the memo is enabled (see enable_value_memo), otherwise it is computed.
+		/// @param x Current solution
+		/// @return Computed value
+		double memoized_value(const Eigen::VectorXd &x) const
+		{
+			if (!value_memo_valid_ || value_memo_x_.size() != x.size() || value_memo_x_ != x)
+				return value(x);
+			return weight() * value_memo_;
+		}
+
+		/// @brief Keep the last value and its solution for memoized_value, disabled by default since every value call copies x
+		/// @param val If true, the values computed from now on are memoized
+		void enable_value_memo(const bool val)
+		{
+			value_memo_enabled_ = val;
+			if (!val)
+			{
+				clear_value_memo();
+				value_memo_x_.resize(0);
+			}
+		}
+
+		/// @brief Forget the memoized value, must be called when the value changes for the same x (e.g., new time step or lagged fields)
+		void clear_value_memo() const { value_memo_valid_ = false; }
+
 		/// @brief Compute the value of the form multiplied with the weigth
 		/// @param x Current solution
 		/// @return Computed value
@@ -43,6 +72,17 @@ namespace polyfem::solver
 			gradv *= weight();
 		}
 
+		/// @brief Compute the value and its first derivative wrt x multiplied with the weigth
+		/// @note Forms override this to share the work (e.g., the element traversal) between the two
+		/// @param[in] x Current solution
+		/// @param[out] gradv Output gradient of the value wrt x
+		/// @return Computed value
+		virtual double value_and_first_derivative(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const
+		{
+			first_derivative(x, gradv);
+			return value(x);
+		}
+
 		/// @brief Compute the second derivative of the value wrt x multiplied with the weigth
 		/// @note This is not marked const because ElasticForm needs to cache the matrix assembly.
 		/// @param[in] x Current solution
@@ -151,6 +191,13 @@ namespace polyfem::solver
 
 		std::string output_dir_;
 
+	private:
+		bool value_memo_enabled_ = false;     ///< If true, the values are memoized for memoized_value
+		mutable bool value_memo_valid_ = false; ///< If true, value_memo_ is the unweighted value at value_memo_x_
+		mutable double value_memo_ = 0;
+		mutable Eigen::VectorXd value_memo_x_;
+
+	protected:
 		std::string resolve_output_path(const std::string &path) const
 		{
 			if (output_dir_.empty() || path.empty() || std::filesystem::path(path).is_absolute())
@@ -163,6 +210,18 @@ namespace polyfem::solver
 		/// @return Computed value
 		virtual double value_unweighted(const Eigen::VectorXd &x) const = 0;
 
+		/// @brief Store the value at x for memoized_value, called by every function computing the value
+		/// @param x Current solution
+		/// @param value_unweighted Value of the form at x, without the weight
+		void memoize_value(const Eigen::VectorXd &x, const double value_unweighted) const
+		{
+			if (!value_memo_enabled_)
+				return;
+			value_memo_ = value_unweighted;
+			value_memo_x_ = x;
+			value_memo_valid_ = true;
+		}
+
 		/// @brief Compute the value of the form multiplied per element
 		/// @param x Current solution
 		/// @return Computed value per element
@@ -114,6 +114,15 @@ namespace polyfem::solver
 		gradv = collision_mesh_.to_full_dof(grad_friction);
 	}
 
+	double FrictionForm::value_and_first_derivative(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const
+	{
+		const Eigen::MatrixXd velocities = compute_surface_velocities(x);
+		const double val = friction_constraint_set_.compute_potential(collision_mesh_, velocities, epsv_) / dv_dx();
+		gradv = weight() * collision_mesh_.to_full_dof(friction_constraint_set_.compute_potential_gradient(collision_mesh_, velocities, epsv_));
+		memoize_value(x, val);
+		return weight() * val;
+	}
+
 	void FrictionForm::second_derivative_unweighted(const Eigen::VectorXd &x, StiffnessMatrix &hessian) const
 	{
 		POLYFEM_SCOPED_TIMER("friction hessian");
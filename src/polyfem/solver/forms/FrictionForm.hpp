@@ -57,6 +57,12 @@ namespace polyfem::solver
 		void second_derivative_unweighted(const Eigen::VectorXd &x, StiffnessMatrix &hessian) const override;
 
 	public:
+		/// @brief Compute the friction potential and its first derivative wrt x from the same surface velocities
+		/// @param[in] x Current solution
+		/// @param[out] gradv Output gradient of the value wrt x
+		/// @return Computed value
+		double value_and_first_derivative(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const override;
+
 		/// @brief Initialize lagged fields
 		/// @param x Current solution
 		void init_lagging(const Eigen::VectorXd &x) override { update_lagging(x, 0); }
@@ -249,6 +249,12 @@ namespace polyfem
 		const std::string formulation = this->formulation();
 		assembler = assembler::AssemblerUtils::make_assembler(formulation);
 		assert(assembler->name() == formulation);
+		if (auto nl_assembler = std::dynamic_pointer_cast<assembler::NLAssembler>(assembler))
+		{
+			nl_assembler->set_use_batched_kernels(args["solver"]["advanced"]["batched_kernels"]);
+			if (args["solver"]["advanced"]["material_state_buffer"])
+				nl_assembler->set_material_state(std::make_shared<assembler::MaterialStateBuffer>());
+		}
 		mass_matrix_assembler = std::make_shared<assembler::Mass>();
 		const auto other_name = assembler::AssemblerUtils::other_assembler_name(formulation);
 
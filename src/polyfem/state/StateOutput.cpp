@@ -1,9 +1,13 @@
 #include <polyfem/State.hpp>
 
+#include <polyfem/io/Snapshot.hpp>
+#include <polyfem/time_integrator/ImplicitTimeIntegrator.hpp>
 #include <polyfem/utils/JSONUtils.hpp>
 #include <polyfem/utils/Timer.hpp>
 
+#include <algorithm>
 #include <filesystem>
+#include <functional>
 
 namespace polyfem
 {
@@ -50,17 +54,28 @@ namespace polyfem
 			logger().trace("Saving VTU...");
 			POLYFEM_SCOPED_TIMER("Saving VTU");
 			const std::string step_name = args["output"]["advanced"]["timestep_prefix"];
+			const io::OutGeometryData::ExportOptions opts(args, mesh->is_linear(), problem->is_scalar(), solve_export_to_file);
+
+			if (opts.time_series && solve_export_to_file)
+			{
+				std::string series_name = args["output"]["paraview"]["file_name"];
+				if (series_name.empty())
+					series_name = step_name + "series";
+				out_geom.save_time_series(
+					resolve_output_path(std::filesystem::path(series_name).replace_extension(".hdf5").string()),
+					*this, sol, time, t, opts, is_contact_enabled());
+				return;
+			}
 
 			if (!solve_export_to_file)
 				solution_frames.emplace_back();
 
 			out_geom.save_vtu(
 				resolve_output_path(fmt::format(step_name + "{:d}.vtu", t)),
-				*this, sol, pressure, time, dt,
-				io::OutGeometryData::ExportOptions(args, mesh->is_linear(), problem->is_scalar(), solve_export_to_file),
+				*this, sol, pressure, time, dt, opts,
 				is_contact_enabled(), solution_frames);
 
-			out_geom.save_pvd(
+			out_geom.append_pvd(
 				resolve_output_path(args["output"]["paraview"]["file_name"]),
 				[step_name](int i) { return fmt::format(step_name + "{:d}.vtm", i); },
 				t, t0, dt, args["output"]["paraview"]["skip_frame"].get<int>());
@@ -173,6 +188,8 @@ namespace polyfem
 			stress_path,
 			mises_path,
 			is_contact_enabled(), solution_frames);
+
+		out_geom.flush_output();
 	}
 
 	void State::save_restart_json(const double t0, const double dt, const int t) const
@@ -260,7 +277,107 @@ namespace polyfem
 			},
 		}};
 
+		const std::string snapshot_path = args["output"]["data"]["snapshot"];
+		if (!snapshot_path.empty())
+			restart_json["input"]["data"]["snapshot"] = resolve_output_path(fmt::format(snapshot_path, t));
+
 		std::ofstream file(resolve_output_path(fmt::format(restart_json_path, t)));
 		file << restart_json;
 	}
+
+	namespace
+	{
+		/// hash of the material parameters (including the density) the snapshot mass matrix was assembled with, as two ints
+		Eigen::MatrixXi materials_hash(const json &materials)
+		{
+			const uint64_t hash = std::hash<std::string>()(materials.dump());
+			Eigen::MatrixXi res(1, 2);
+			res << int(uint32_t(hash)), int(uint32_t(hash >> 32));
+			return res;
+		}
+	} // namespace
+
+	void State::save_snapshot(const std::string &path, const time_integrator::ImplicitTimeIntegrator &time_integrator) const
+	{
+		assert(!path.empty());
+		POLYFEM_SCOPED_TIMER("Saving snapshot");
+
+		io::SnapshotWriter writer;
+
+		Eigen::MatrixXi sizes(1, 4);
+		sizes << n_bases, mesh->dimension(), mesh->n_vertices(), mesh->n_elements();
+		writer.add("sizes", sizes);
+
+		Eigen::MatrixXd vertices(mesh->n_vertices(), mesh->dimension());
+		for (int i = 0; i < mesh->n_vertices(); ++i)
+			vertices.row(i) = mesh->point(i);
+		writer.add("vertices", vertices);
+		writer.add("in_node_to_node", Eigen::MatrixXi(in_node_to_node));
+
+		if (mass.size() > 0)
+		{
+			writer.add("mass", mass);
+			writer.add("avg_mass", Eigen::MatrixXd(Eigen::MatrixXd::Constant(1, 1, avg_mass)));
+			writer.add("lump_mass_matrix", Eigen::MatrixXi(Eigen::MatrixXi::Constant(1, 1, args["solver"]["advanced"]["lump_mass_matrix"].get<bool>())));
+			writer.add("materials_hash", materials_hash(args["materials"]));
+		}
+
+		// same layout as ImplicitTimeIntegrator::save_state, one column per previous step
+		const int ndof = time_integrator.x_prev().size();
+		const int prev_steps = time_integrator.steps();
+		Eigen::MatrixXd u(ndof, prev_steps), v(ndof, prev_steps), a(ndof, prev_steps);
+		for (int i = 0; i < prev_steps; ++i)
+		{
+			u.col(i) = time_integrator.x_prevs()[i];
+			v.col(i) = time_integrator.v_prevs()[i];
+			a.col(i) = time_integrator.a_prevs()[i];
+		}
+		writer.add("u", u);
+		writer.add("v", v);
+		writer.add("a", a);
+
+		writer.write(path);
+	}
+
+	std::shared_ptr<io::SnapshotReader> State::load_snapshot() const
+	{
+		const std::string path = resolve_input_path(args["input"]["data"]["snapshot"]);
+		if (path.empty())
+			return nullptr;
+
+		auto snapshot = std::make_shared<io::SnapshotReader>(path);
+
+		const Eigen::Map<const Eigen::MatrixXi> sizes = snapshot->int_matrix("sizes");
+		if (sizes.size() != 4 || sizes(0) != n_bases || sizes(1) != mesh->dimension()
+			|| sizes(2) != mesh->n_vertices() || sizes(3) != mesh->n_elements())
+			log_and_throw_error("Snapshot {} was saved for another discretization", path);
+
+		const Eigen::Map<const Eigen::MatrixXd> vertices = snapshot->matrix("vertices");
+		for (int i = 0; i < mesh->n_vertices(); ++i)
+		{
+			if ((vertices.row(i) - mesh->point(i)).lpNorm<Eigen::Infinity>() > 1e-12)
+				log_and_throw_error("Snapshot {} was saved for another mesh", path);
+		}
+
+		const Eigen::Map<const Eigen::MatrixXi> snapshot_node_to_node = snapshot->int_matrix("in_node_to_node");
+		if (snapshot_node_to_node.size() != in_node_to_node.size()
+			|| !std::equal(in_node_to_node.data(), in_node_to_node.data() + in_node_to_node.size(), snapshot_node_to_node.data()))
+			log_and_throw_error("Snapshot {} was saved with another node ordering", path);
+
+		return snapshot;
+	}
+
+	bool State::can_load_snapshot_mass() const
+	{
+		if (input_snapshot == nullptr || !input_snapshot->has("mass") || !input_snapshot->has("materials_hash"))
+			return false;
+
+		const bool lump_mass_matrix = args["solver"]["advanced"]["lump_mass_matrix"];
+		const Eigen::Map<const Eigen::MatrixXi> hash = input_snapshot->int_matrix("materials_hash");
+		const Eigen::MatrixXi expected_hash = materials_hash(args["materials"]);
+
+		return input_snapshot->int_matrix("lump_mass_matrix")(0) == int(lump_mass_matrix)
+			   && hash.size() == expected_hash.size() && hash == expected_hash
+			   && input_snapshot->sparse("mass").rows() == n_bases * assembler->size();
+	}
 } // namespace polyfem
@@ -1,6 +1,7 @@
 #include <polyfem/State.hpp>
 
 #include <polyfem/io/MatrixIO.hpp>
+#include <polyfem/io/Snapshot.hpp>
 #include <polyfem/utils/Timer.hpp>
 
 namespace polyfem
@@ -61,16 +62,32 @@ namespace polyfem
 
 			return true;
 		}
+
+		/// the snapshot is checked against the current node ordering (State::load_snapshot), no reordering is needed
+		bool read_initial_x_from_snapshot(
+			const std::shared_ptr<io::SnapshotReader> &snapshot,
+			const std::string &x_name,
+			Eigen::MatrixXd &x)
+		{
+			if (snapshot == nullptr || !snapshot->has(x_name))
+				return false;
+
+			x = snapshot->matrix(x_name);
+			logger().debug("Loaded initial {} from snapshot {}", x_name, snapshot->path());
+			return true;
+		}
 	} // namespace
 
 	void State::initial_solution(Eigen::MatrixXd &solution) const
 	{
 		assert(solve_data.rhs_assembler != nullptr);
 
-		const bool was_solution_loaded = read_initial_x_from_file(
-			resolve_input_path(args["input"]["data"]["state"]), "u",
-			args["input"]["data"]["reorder"], in_node_to_node,
-			mesh->dimension(), solution);
+		const bool was_solution_loaded =
+			read_initial_x_from_snapshot(input_snapshot, "u", solution)
+			|| read_initial_x_from_file(
+				resolve_input_path(args["input"]["data"]["state"]), "u",
+				args["input"]["data"]["reorder"], in_node_to_node,
+				mesh->dimension(), solution);
 
 		if (!was_solution_loaded)
 		{
@@ -88,10 +105,12 @@ namespace polyfem
 	{
 		assert(solve_data.rhs_assembler != nullptr);
 
-		const bool was_velocity_loaded = read_initial_x_from_file(
-			resolve_input_path(args["input"]["data"]["state"]), "v",
-			args["input"]["data"]["reorder"], in_node_to_node,
-			mesh->dimension(), velocity);
+		const bool was_velocity_loaded =
+			read_initial_x_from_snapshot(input_snapshot, "v", velocity)
+			|| read_initial_x_from_file(
+				resolve_input_path(args["input"]["data"]["state"]), "v",
+				args["input"]["data"]["reorder"], in_node_to_node,
+				mesh->dimension(), velocity);
 
 		if (!was_velocity_loaded)
 			solve_data.rhs_assembler->initial_velocity(velocity);
@@ -101,10 +120,12 @@ namespace polyfem
 	{
 		assert(solve_data.rhs_assembler != nullptr);
 
-		const bool was_acceleration_loaded = read_initial_x_from_file(
-			resolve_input_path(args["input"]["data"]["state"]), "a",
-			args["input"]["data"]["reorder"], in_node_to_node,
-			mesh->dimension(), acceleration);
+		const bool was_acceleration_loaded =
+			read_initial_x_from_snapshot(input_snapshot, "a", acceleration)
+			|| read_initial_x_from_file(
+				resolve_input_path(args["input"]["data"]["state"]), "a",
+				args["input"]["data"]["reorder"], in_node_to_node,
+				mesh->dimension(), acceleration);
 
 		if (!was_acceleration_loaded)
 			solve_data.rhs_assembler->initial_acceleration(acceleration);
@@ -2,6 +2,7 @@
 
 #include <polyfem/assembler/Mass.hpp>
 #include <polyfem/assembler/AssemblerUtils.hpp>
+#include <polyfem/assembler/MatrixFreeOperator.hpp>
 
 #include <polyfem/time_integrator/ImplicitTimeIntegrator.hpp>
 #include <polyfem/time_integrator/BDF.hpp>
@@ -11,6 +12,7 @@
 #include <polyfem/solver/forms/InertiaForm.hpp>
 #include <polysolve/linear/FEMSolver.hpp>
 
+#include <polyfem/utils/BlockSparseMatrix.hpp>
 #include <polyfem/utils/Timer.hpp>
 
 #include <unsupported/Eigen/SparseExtra>
@@ -23,6 +25,34 @@ namespace polyfem
 	using namespace solver;
 	using namespace io;
 
+	namespace
+	{
+		/// conjugate gradient needs a symmetric positive definite operator
+		bool is_spd_assembler(const std::string &name)
+		{
+			return name == "Laplacian" || name == "LinearElasticity";
+		}
+
+		/// residual of the system solved by dirichlet_solve (identity on the boundary_nodes rows)
+		template <typename Apply>
+		double dirichlet_residual(Apply &&apply, const Eigen::VectorXd &x, const Eigen::VectorXd &b, const std::vector<int> &boundary_nodes)
+		{
+			Eigen::VectorXd y;
+			apply(x, y);
+			for (const int bn : boundary_nodes)
+				y[bn] = x[bn];
+			return (y - b).norm();
+		}
+
+		void log_solver_error(const double error)
+		{
+			if (error > 1e-4)
+				logger().error("Solver error: {}", error);
+			else
+				logger().debug("Solver error: {}", error);
+		}
+	} // namespace
+
 	void State::build_stiffness_mat(StiffnessMatrix &stiffness)
 	{
 		igl::Timer timer;
@@ -95,12 +125,7 @@ namespace polyfem
 
 		solver->get_info(stats.solver_info);
 
-		const auto error = (A * x - b).norm();
-
-		if (error > 1e-4)
-			logger().error("Solver error: {}", error);
-		else
-			logger().debug("Solver error: {}", error);
+		log_solver_error((A * x - b).norm());
 
 		if (mixed_assembler != nullptr)
 			sol_to_pressure(sol, pressure);
@@ -112,6 +137,77 @@ namespace polyfem
 		assert(assembler->is_linear() && !is_contact_enabled());
 
 		// --------------------------------------------------------------------
+
+		solve_data.rhs_assembler->set_bc(
+			local_boundary, boundary_nodes, n_boundary_samples(),
+			(assembler->name() != "Bilaplacian") ? local_neumann_boundary : std::vector<LocalBoundary>(), rhs);
+
+		const json &matrix_free = args["solver"]["advanced"]["matrix_free"];
+		if (matrix_free["enabled"])
+		{
+			const auto linear_assembler = std::dynamic_pointer_cast<assembler::LinearAssembler>(assembler);
+			if (mixed_assembler != nullptr || linear_assembler == nullptr || !is_spd_assembler(assembler->name()) || optimization_enabled != solver::CacheLevel::None)
+			{
+				logger().warn("Matrix-free solve is only supported for Laplacian and LinearElasticity without optimization, assembling the matrix");
+			}
+			else
+			{
+				logger().info("Matrix-free solve...");
+				const assembler::MatrixFreeOperator op(*linear_assembler, mesh->is_volume(), n_bases, bases, geom_bases(), ass_vals_cache, 0);
+				Eigen::VectorXd x;
+				const int iterations = op.solve(rhs, boundary_nodes, x, matrix_free["tolerance"], matrix_free["max_iterations"]);
+				if (iterations >= 0)
+				{
+					log_solver_error(dirichlet_residual(
+						[&op](const Eigen::VectorXd &in, Eigen::VectorXd &out) { op.apply(in, out); },
+						x, rhs, boundary_nodes));
+					sol = x;
+					stats.num_dofs = op.rows();
+					return;
+				}
+				logger().warn("Matrix-free conjugate gradient did not converge in {} iterations, assembling the matrix", -iterations);
+			}
+		}
+
+		const json &block_sparse = args["solver"]["advanced"]["block_sparse"];
+		if (block_sparse["enabled"])
+		{
+			const auto linear_assembler = std::dynamic_pointer_cast<assembler::LinearAssembler>(assembler);
+			if (mixed_assembler != nullptr || linear_assembler == nullptr || !is_spd_assembler(assembler->name()) || optimization_enabled != solver::CacheLevel::None)
+			{
+				logger().warn("Block sparse solve is only supported for Laplacian and LinearElasticity without optimization, using the linear solver");
+			}
+			else
+			{
+				igl::Timer timer;
+				timer.start();
+				logger().info("Assembling block sparse stiffness mat...");
+				BlockSparseMatrix A;
+				linear_assembler->assemble(mesh->is_volume(), n_bases, bases, geom_bases(), ass_vals_cache, 0, A);
+				timer.stop();
+				timings.assembling_stiffness_mat_time = timer.getElapsedTime();
+				logger().info(" took {}s", timings.assembling_stiffness_mat_time);
+
+				stats.nn_zero = A.non_zeros();
+				stats.num_dofs = A.rows();
+				stats.mat_size = (long long)A.rows() * (long long)A.cols();
+				logger().info("sparsity: {}/{}, {} blocks of size {}, index storage {} bytes", stats.nn_zero, stats.mat_size, A.non_zero_blocks(), A.block_size(), A.index_bytes());
+
+				logger().info("Block sparse solve...");
+				Eigen::VectorXd x;
+				const int iterations = A.solve(rhs, boundary_nodes, x, block_sparse["tolerance"], block_sparse["max_iterations"]);
+				if (iterations >= 0)
+				{
+					log_solver_error(dirichlet_residual(
+						[&A](const Eigen::VectorXd &in, Eigen::VectorXd &out) { A.multiply(in, out); },
+						x, rhs, boundary_nodes));
+					sol = x;
+					return;
+				}
+				logger().warn("Block sparse conjugate gradient did not converge in {} iterations, using the linear solver", -iterations);
+			}
+		}
+
 		if (lin_solver_cached)
 			lin_solver_cached.reset();
 
@@ -119,12 +215,6 @@ namespace polyfem
 			polysolve::linear::Solver::create(args["solver"]["linear"], logger());
 		logger().info("{}...", lin_solver_cached->name());
 
-		// --------------------------------------------------------------------
-
-		solve_data.rhs_assembler->set_bc(
-			local_boundary, boundary_nodes, n_boundary_samples(),
-			(assembler->name() != "Bilaplacian") ? local_neumann_boundary : std::vector<LocalBoundary>(), rhs);
-
 		StiffnessMatrix A;
 		build_stiffness_mat(A);
 
@@ -320,5 +410,9 @@ namespace polyfem
 		}
 
 		time_integrator->save_state(resolve_output_path(args["output"]["data"]["state"]));
+
+		const std::string snapshot_path = resolve_output_path(args["output"]["data"]["snapshot"]);
+		if (!snapshot_path.empty())
+			save_snapshot(snapshot_path, *time_integrator);
 	}
 } // namespace polyfem
@@ -128,6 +128,10 @@ namespace polyfem
 			if (!state_path.empty())
 				solve_data.time_integrator->save_state(state_path);
 
+			const std::string &snapshot_path = resolve_output_path(fmt::format(args["output"]["data"]["snapshot"], t));
+			if (!snapshot_path.empty())
+				save_snapshot(snapshot_path, *solve_data.time_integrator);
+
 			// save restart file
 			save_restart_json(t0, dt, t);
 			stats_csv.write(t, forward_solve_time, remeshing_time, global_relaxation_time, sol);
@@ -248,6 +252,11 @@ namespace polyfem
 		for (const auto &form : forms)
 			form->set_output_dir(output_dir);
 
+		build_element_coloring();
+		solve_data.elastic_form->set_element_coloring(&element_coloring);
+		if (solve_data.damping_form != nullptr)
+			solve_data.damping_form->set_element_coloring(&element_coloring);
+
 		if (solve_data.contact_form != nullptr)
 			solve_data.contact_form->save_ccd_debug_meshes = args["output"]["advanced"]["save_ccd_debug_meshes"];
 
@@ -0,0 +1,243 @@
+#include "BlockSparseMatrix.hpp"
+
+#include <polyfem/utils/ConjugateGradient.hpp>
+#include <polyfem/utils/Logger.hpp>
+#include <polyfem/utils/MaybeParallelFor.hpp>
+#include <polyfem/utils/Timer.hpp>
+
+#include <algorithm>
+
+namespace polyfem::utils
+{
+	namespace
+	{
+		// y = A x for the block rows [start, end), the block size is known at compile time
+		template <int B>
+		void multiply_block_rows(const BlockSparseMatrix &A, const Eigen::VectorXd &x, Eigen::VectorXd &y, const int start, const int end)
+		{
+			typedef Eigen::Matrix<double, B, B, B == 1 ? Eigen::ColMajor : Eigen::RowMajor> Block;
+			const std::vector<int> &outer = A.outer_index();
+			const std::vector<int> &inner = A.inner_index();
+
+			for (int r = start; r < end; ++r)
+			{
+				Eigen::Matrix<double, B, 1> acc = Eigen::Matrix<double, B, 1>::Zero();
+				for (int k = outer[r]; k < outer[r + 1]; ++k)
+					acc.noalias() += Eigen::Map<const Block>(A.block(k)) * x.segment<B>(inner[k] * B);
+				y.segment<B>(r * B) = acc;
+			}
+		}
+	} // namespace
+
+	BlockSparseMatrix::BlockSparseMatrix(const int block_rows, const int block_cols, const int block_size)
+	{
+		resize(block_rows, block_cols, block_size);
+	}
+
+	void BlockSparseMatrix::resize(const int block_rows, const int block_cols, const int block_size)
+	{
+		if (block_size < 1 || block_size > 3)
+			log_and_throw_error("Block sparse matrices support blocks of size 1, 2, or 3, not {}", block_size);
+
+		block_rows_ = block_rows;
+		block_cols_ = block_cols;
+		block_size_ = block_size;
+
+		outer_.assign(block_rows_ + 1, 0);
+		inner_.clear();
+		values_.clear();
+	}
+
+	void BlockSparseMatrix::init_pattern(std::vector<std::pair<int, int>> &pairs)
+	{
+		std::sort(pairs.begin(), pairs.end());
+		pairs.erase(std::unique(pairs.begin(), pairs.end()), pairs.end());
+
+		outer_.assign(block_rows_ + 1, 0);
+		inner_.resize(pairs.size());
+		for (size_t k = 0; k < pairs.size(); ++k)
+		{
+			assert(pairs[k].first >= 0 && pairs[k].first < block_rows_);
+			assert(pairs[k].second >= 0 && pairs[k].second < block_cols_);
+			++outer_[pairs[k].first + 1];
+			inner_[k] = pairs[k].second;
+		}
+		for (int r = 0; r < block_rows_; ++r)
+			outer_[r + 1] += outer_[r];
+
+		values_.assign(inner_.size() * block_size_ * block_size_, 0);
+	}
+
+	void BlockSparseMatrix::set_from_blocks(const std::vector<std::pair<int, int>> &blocks, const std::vector<double> &values)
+	{
+		POLYFEM_PROFILE_SCOPE("set from blocks");
+
+		const int n_values = block_size_ * block_size_;
+		assert(values.size() == blocks.size() * n_values);
+
+		std::vector<std::pair<int, int>> pairs = blocks;
+		init_pattern(pairs);
+
+		for (size_t k = 0; k < blocks.size(); ++k)
+		{
+			double *dst = block(find_block(blocks[k].first, blocks[k].second));
+			const double *src = values.data() + k * n_values;
+			for (int i = 0; i < n_values; ++i)
+				dst[i] += src[i];
+		}
+	}
+
+	void BlockSparseMatrix::set_from_sparse(const StiffnessMatrix &mat, const int block_size)
+	{
+		assert(mat.rows() % block_size == 0 && mat.cols() % block_size == 0);
+		resize(mat.rows() / block_size, mat.cols() / block_size, block_size);
+
+		std::vector<std::pair<int, int>> pairs;
+		pairs.reserve(mat.nonZeros());
+		for (int k = 0; k < mat.outerSize(); ++k)
+			for (StiffnessMatrix::InnerIterator it(mat, k); it; ++it)
+				pairs.emplace_back(it.row() / block_size, it.col() / block_size);
+		init_pattern(pairs);
+
+		for (int k = 0; k < mat.outerSize(); ++k)
+		{
+			for (StiffnessMatrix::InnerIterator it(mat, k); it; ++it)
+			{
+				double *values = block(find_block(it.row() / block_size, it.col() / block_size));
+				values[(it.row() % block_size) * block_size + it.col() % block_size] += it.value();
+			}
+		}
+	}
+
+	void BlockSparseMatrix::set_zero()
+	{
+		std::fill(values_.begin(), values_.end(), 0);
+	}
+
+	void BlockSparseMatrix::to_sparse(StiffnessMatrix &mat) const
+	{
+		std::vector<Eigen::Triplet<double>> triplets;
+		triplets.reserve(values_.size());
+
+		for (int r = 0; r < block_rows_; ++r)
+		{
+			for (int k = outer_[r]; k < outer_[r + 1]; ++k)
+			{
+				const double *values = block(k);
+				for (int i = 0; i < block_size_; ++i)
+					for (int j = 0; j < block_size_; ++j)
+						triplets.emplace_back(r * block_size_ + i, inner_[k] * block_size_ + j, values[i * block_size_ + j]);
+			}
+		}
+
+		mat.resize(rows(), cols());
+		mat.setFromTriplets(triplets.begin(), triplets.end());
+		mat.makeCompressed();
+	}
+
+	void BlockSparseMatrix::multiply(const Eigen::VectorXd &x, Eigen::VectorXd &y) const
+	{
+		POLYFEM_PROFILE_SCOPE("block sparse multiply");
+		assert(x.size() == cols());
+
+		y.resize(rows());
+		maybe_parallel_for(block_rows_, [&](int start, int end, int thread_id) {
+			switch (block_size_)
+			{
+			case 1:
+				multiply_block_rows<1>(*this, x, y, start, end);
+				break;
+			case 2:
+				multiply_block_rows<2>(*this, x, y, start, end);
+				break;
+			case 3:
+				multiply_block_rows<3>(*this, x, y, start, end);
+				break;
+			default:
+				assert(false);
+			}
+		});
+	}
+
+	Eigen::MatrixXd BlockSparseMatrix::diagonal_blocks() const
+	{
+		assert(block_rows_ == block_cols_);
+
+		Eigen::MatrixXd res = Eigen::MatrixXd::Zero(rows(), block_size_);
+		for (int r = 0; r < block_rows_; ++r)
+		{
+			const int k = find_block(r, r);
+			if (k < 0)
+				continue;
+
+			const double *values = block(k);
+			for (int i = 0; i < block_size_; ++i)
+				for (int j = 0; j < block_size_; ++j)
+					res(r * block_size_ + i, j) = values[i * block_size_ + j];
+		}
+
+		return res;
+	}
+
+	int BlockSparseMatrix::solve(
+		const Eigen::VectorXd &b,
+		const std::vector<int> &boundary_nodes,
+		Eigen::VectorXd &x,
+		const double tolerance,
+		const int max_iterations) const
+	{
+		POLYFEM_SCOPED_TIMER("block sparse solve");
+		assert(b.size() == rows() && rows() == cols());
+
+		const int bs = block_size_;
+		std::vector<bool> is_boundary(rows(), false);
+		for (const int i : boundary_nodes)
+			is_boundary[i] = true;
+
+		// block Jacobi, the Dirichlet rows and columns of the diagonal blocks are replaced by the identity
+		Eigen::MatrixXd inv_blocks = diagonal_blocks();
+		maybe_parallel_for(block_rows_, [&](int start, int end, int thread_id) {
+			Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3> D(bs, bs);
+			for (int r = start; r < end; ++r)
+			{
+				D = inv_blocks.middleRows(r * bs, bs);
+				for (int d = 0; d < bs; ++d)
+				{
+					if (!is_boundary[r * bs + d])
+						continue;
+					D.row(d).setZero();
+					D.col(d).setZero();
+					D(d, d) = 1;
+				}
+
+				const Eigen::FullPivLU<Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, 0, 3, 3>> lu(D);
+				if (lu.isInvertible())
+					inv_blocks.middleRows(r * bs, bs) = lu.inverse();
+				else
+					inv_blocks.middleRows(r * bs, bs).setZero();
+			}
+		});
+
+		return dirichlet_conjugate_gradient(
+			[&](const Eigen::VectorXd &v, Eigen::VectorXd &Av) { multiply(v, Av); },
+			[&](const Eigen::VectorXd &r, Eigen::VectorXd &z) {
+				z.resize(r.size());
+				for (int k = 0; k < block_rows_; ++k)
+					z.segment(k * bs, bs) = inv_blocks.middleRows(k * bs, bs) * r.segment(k * bs, bs);
+			},
+			b, boundary_nodes, x, tolerance, max_iterations);
+	}
+
+	int BlockSparseMatrix::find_block(const int block_row, const int block_col) const
+	{
+		assert(block_row >= 0 && block_row < block_rows_);
+
+		const auto begin = inner_.begin() + outer_[block_row];
+		const auto end = inner_.begin() + outer_[block_row + 1];
+		const auto it = std::lower_bound(begin, end, block_col);
+
+		if (it == end || *it != block_col)
+			return -1;
+		return int(it - inner_.begin());
+	}
+} // namespace polyfem::utils
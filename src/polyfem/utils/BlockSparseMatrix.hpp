@@ -0,0 +1,100 @@
+#pragma once
+
+#include <polyfem/utils/Types.hpp>
+
+#include <Eigen/Dense>
+#include <Eigen/Sparse>
+
+#include <utility>
+#include <vector>
+
+namespace polyfem::utils
+{
+	/// Block compressed sparse row (BSR) matrix with block_size x block_size dense blocks.
+	/// The matrices of vector problems couple all the components of two nodes, so storing one column index per
+	/// block instead of one per entry divides the index storage by up to block_size^2 and the products read
+	/// the values contiguously.
+	/// The blocks of each block row are sorted by column, the values of a block are stored row major.
+	class BlockSparseMatrix
+	{
+	public:
+		BlockSparseMatrix() {}
+
+		/// empty matrix of block_rows x block_cols blocks
+		BlockSparseMatrix(const int block_rows, const int block_cols, const int block_size);
+
+		/// resizes the matrix and removes all blocks
+		void resize(const int block_rows, const int block_cols, const int block_size);
+
+		/// sets the matrix from the blocks, the duplicated blocks are summed
+		/// @param[in] blocks (block row, block column) of every block
+		/// @param[in] values block_size^2 values (row major) of every block, stored contiguously
+		void set_from_blocks(const std::vector<std::pair<int, int>> &blocks, const std::vector<double> &values);
+
+		/// converts a scalar sparse matrix, its size must be a multiple of block_size
+		void set_from_sparse(const StiffnessMatrix &mat, const int block_size);
+
+		/// sets all the values to zero, the pattern is kept
+		void set_zero();
+
+		/// scalar sparse matrix with the same entries (e.g., to use the linear solvers)
+		void to_sparse(StiffnessMatrix &mat) const;
+
+		/// y = A x
+		void multiply(const Eigen::VectorXd &x, Eigen::VectorXd &y) const;
+
+		/// dense diagonal blocks, stacked vertically (rows() x block_size), zero if the block is not stored
+		Eigen::MatrixXd diagonal_blocks() const;
+
+		/// Solves A x = b with conjugate gradient preconditioned with the inverse of the diagonal blocks,
+		/// the rows and columns of boundary_nodes are eliminated and x is set to b on them (same as MatrixFreeOperator::solve).
+		/// @param[in] b right-hand side, contains the Dirichlet values on boundary_nodes
+		/// @param[in] boundary_nodes Dirichlet dofs
+		/// @param[in,out] x initial guess and solution
+		/// @param[in] tolerance relative tolerance on the preconditioned residual norm
+		/// @param[in] max_iterations maximum number of iterations
+		/// @return number of iterations, negative if not converged
+		int solve(
+			const Eigen::VectorXd &b,
+			const std::vector<int> &boundary_nodes,
+			Eigen::VectorXd &x,
+			const double tolerance,
+			const int max_iterations) const;
+
+		/// position of the block (block_row, block_col) in the stored blocks, -1 if not stored
+		int find_block(const int block_row, const int block_col) const;
+
+		/// values of the k-th stored block, row major
+		inline double *block(const int k) { return values_.data() + size_t(k) * block_size_ * block_size_; }
+		inline const double *block(const int k) const { return values_.data() + size_t(k) * block_size_ * block_size_; }
+
+		inline int block_size() const { return block_size_; }
+		inline int block_rows() const { return block_rows_; }
+		inline int block_cols() const { return block_cols_; }
+		inline int rows() const { return block_rows_ * block_size_; }
+		inline int cols() const { return block_cols_ * block_size_; }
+
+		/// number of stored blocks
+		inline int non_zero_blocks() const { return int(inner_.size()); }
+		/// number of stored scalar entries
+		inline size_t non_zeros() const { return values_.size(); }
+		/// memory used by the indices of the pattern, in bytes
+		inline size_t index_bytes() const { return (outer_.size() + inner_.size()) * sizeof(int); }
+
+		inline const std::vector<int> &outer_index() const { return outer_; }
+		inline const std::vector<int> &inner_index() const { return inner_; }
+		inline const std::vector<double> &values() const { return values_; }
+
+	private:
+		/// sets the pattern from (block_row, block_col) pairs, sorts and removes the duplicates of pairs
+		void init_pattern(std::vector<std::pair<int, int>> &pairs);
+
+		int block_rows_ = 0;
+		int block_cols_ = 0;
+		int block_size_ = 1;
+
+		std::vector<int> outer_;     ///< start of every block row in inner_, block_rows + 1 entries
+		std::vector<int> inner_;     ///< block column of every stored block
+		std::vector<double> values_; ///< block_size^2 values per stored block
+	};
+} // namespace polyfem::utils
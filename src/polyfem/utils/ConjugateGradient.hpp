@@ -0,0 +1,84 @@
+#pragma once
+
+#include <polyfem/utils/Logger.hpp>
+
+#include <Eigen/Dense>
+
+#include <cmath>
+#include <vector>
+
+namespace polyfem::utils
+{
+	/// Preconditioned conjugate gradient for A x = b, where A is only available through products.
+	/// The rows and columns of boundary_nodes are eliminated and x is set to b on them
+	/// (same convention as dirichlet_solve).
+	/// @param[in] apply function (x, y) computing y = A x
+	/// @param[in] precondition function (r, z) computing z = M^-1 r, r is zero on the boundary nodes
+	/// @param[in] b right-hand side, contains the Dirichlet values on boundary_nodes
+	/// @param[in] boundary_nodes Dirichlet dofs
+	/// @param[in,out] x initial guess and solution, resized to the size of b if needed
+	/// @param[in] tolerance relative tolerance on the preconditioned residual norm
+	/// @param[in] max_iterations maximum number of iterations
+	/// @return number of iterations, negative if not converged
+	template <typename Apply, typename Precondition>
+	int dirichlet_conjugate_gradient(
+		const Apply &apply,
+		const Precondition &precondition,
+		const Eigen::VectorXd &b,
+		const std::vector<int> &boundary_nodes,
+		Eigen::VectorXd &x,
+		const double tolerance,
+		const int max_iterations)
+	{
+		const int n = int(b.size());
+		if (x.size() != n)
+			x.setZero(n);
+
+		Eigen::VectorXd is_free = Eigen::VectorXd::Ones(n);
+		for (const int i : boundary_nodes)
+		{
+			is_free(i) = 0;
+			x(i) = b(i);
+		}
+
+		// r = b - A x on the free dofs, the Dirichlet values move to the right-hand side
+		Eigen::VectorXd r, z, Ap;
+		apply(x, Ap);
+		r = (b - Ap).cwiseProduct(is_free);
+
+		precondition(r, z);
+		z.array() *= is_free.array();
+		Eigen::VectorXd p = z;
+		double rz = r.dot(z);
+		const double rz0 = rz;
+
+		if (rz0 <= 0)
+			return 0;
+
+		for (int it = 1; it <= max_iterations; ++it)
+		{
+			apply(p, Ap);
+			Ap.array() *= is_free.array();
+
+			const double alpha = rz / p.dot(Ap);
+			x += alpha * p;
+			r -= alpha * Ap;
+
+			precondition(r, z);
+			z.array() *= is_free.array();
+			const double rz_new = r.dot(z);
+
+			if (std::sqrt(rz_new / rz0) < tolerance)
+			{
+				logger().debug("CG converged in {} iterations", it);
+				return it;
+			}
+
+			p = z + (rz_new / rz) * p;
+			rz = rz_new;
+		}
+
+		logger().warn("CG did not converge in {} iterations, relative residual {}", max_iterations, std::sqrt(rz / rz0));
+		return -max_iterations;
+	}
+} // namespace polyfem::utils
@@ -4,6 +4,7 @@
 #include <polyfem/assembler/AssemblerData.hpp>
 #include <polyfem/basis/ElementBases.hpp>
 #include <polyfem/utils/AutodiffTypes.hpp>
+#include <polyfem/utils/ElementArena.hpp>
 #include <polyfem/utils/Types.hpp>
 #include <polyfem/utils/MatrixUtils.hpp>
 
@@ -67,17 +68,16 @@ namespace polyfem
 
 	typedef std::array<double, 2> DampingParameters;
 
-	template <typename AutoDiffVect>
-	void get_local_disp(
+	// displacement of the local bases, local_dispv must have size entries per basis
+	template <typename Vector>
+	void gather_local_disp(
 		const assembler::NonLinearAssemblerData &data,
 		const int size,
-		AutoDiffVect &local_disp)
+		Vector &local_dispv)
 	{
-		typedef typename AutoDiffVect::Scalar T;
-
 		assert(data.x.cols() == 1);
+		assert(local_dispv.size() == int(data.vals.basis_values.size()) * size);
 
-		Eigen::Matrix<double, Eigen::Dynamic, 1> local_dispv(data.vals.basis_values.size() * size, 1);
 		local_dispv.setZero();
 		for (size_t i = 0; i < data.vals.basis_values.size(); ++i)
 		{
@@ -90,6 +90,21 @@ namespace polyfem
 				}
 			}
 		}
+	}
+
+	template <typename AutoDiffVect>
+	void get_local_disp(
+		const assembler::NonLinearAssemblerData &data,
+		const int size,
+		AutoDiffVect &local_disp)
+	{
+		typedef typename AutoDiffVect::Scalar T;
+
+		// the double gather only lives until the autodiff scalars are created
+		utils::ElementArena &arena = utils::ElementArena::thread_local_arena();
+		const utils::ElementArena::Scope scope(arena);
+		utils::ElementArena::VectorMap local_dispv = arena.vector(int(data.vals.basis_values.size()) * size);
+		gather_local_disp(data, size, local_dispv);
 
 		DiffScalarBase::setVariableCount(local_dispv.rows());
 		local_disp.resize(local_dispv.rows(), 1);
@@ -0,0 +1,57 @@
+#include "ElementArena.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace polyfem::utils
+{
+	namespace
+	{
+		// multiple of two doubles, every allocation is 16 bytes aligned
+		size_t padded(const size_t n) { return (n + 1) & ~size_t(1); }
+	} // namespace
+
+	ElementArena::ElementArena(const size_t capacity)
+		: block_(padded(capacity))
+	{
+	}
+
+	double *ElementArena::allocate(const size_t n)
+	{
+		const size_t size = std::max(padded(n), size_t(2));
+		double *ptr;
+
+		if (overflow_.empty() && used_ + size <= capacity())
+		{
+			ptr = block_.data() + used_;
+		}
+		else
+		{
+			// the main block is full, the pointers already handed out must stay valid
+			overflow_.emplace_back(used_, Eigen::VectorXd(size));
+			ptr = overflow_.back().second.data();
+		}
+
+		used_ += size;
+		high_water_ = std::max(high_water_, used_);
+		return ptr;
+	}
+
+	void ElementArena::release(const size_t mark)
+	{
+		assert(mark <= used_);
+		used_ = mark;
+
+		while (!overflow_.empty() && overflow_.back().first >= mark)
+			overflow_.pop_back();
+
+		if (used_ == 0 && high_water_ > capacity())
+			block_.resize(padded(high_water_));
+	}
+
+	ElementArena &ElementArena::thread_local_arena()
+	{
+		static thread_local ElementArena arena(4096);
+		return arena;
+	}
+} // namespace polyfem::utils
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <Eigen/Dense>
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace polyfem::utils
+{
+	/// Bump allocator for the temporaries of the element kernels.
+	/// Allocations only move a pointer forward in a preallocated block and are all released at once
+	/// (see Scope), so the per element scratch of the assembly loops does not go through malloc.
+	/// Every thread has its own arena (thread_local_arena), the memory is never shared between threads.
+	/// If the block is too small, an overflow block is allocated; once everything is released the arena
+	/// grows to the largest size used so far, so after the first elements the overflow does not happen again.
+	class ElementArena
+	{
+	public:
+		typedef Eigen::Map<Eigen::MatrixXd, Eigen::Aligned16> MatrixMap;
+		typedef Eigen::Map<Eigen::VectorXd, Eigen::Aligned16> VectorMap;
+
+		/// releases everything allocated since its construction when it goes out of scope
+		class Scope
+		{
+		public:
+			explicit Scope(ElementArena &arena) : arena_(arena), mark_(arena.mark()) {}
+			~Scope() { arena_.release(mark_); }
+
+			Scope(const Scope &) = delete;
+			Scope &operator=(const Scope &) = delete;
+
+		private:
+			ElementArena &arena_;
+			const size_t mark_;
+		};
+
+		/// @param[in] capacity initial number of doubles of the arena
+		explicit ElementArena(const size_t capacity = 0);
+
+		ElementArena(const ElementArena &) = delete;
+		ElementArena &operator=(const ElementArena &) = delete;
+
+		/// uninitialized storage for n doubles, valid until the memory is released
+		double *allocate(const size_t n);
+
+		/// uninitialized rows x cols matrix in the arena
+		MatrixMap matrix(const int rows, const int cols) { return MatrixMap(allocate(size_t(rows) * cols), rows, cols); }
+		/// uninitialized vector of size n in the arena
+		VectorMap vector(const int n) { return VectorMap(allocate(n), n); }
+
+		/// current position of the arena, pass it to release to free what was allocated after it
+		size_t mark() const { return used_; }
+		/// frees everything allocated after mark
+		void release(const size_t mark);
+
+		/// number of doubles of the main block
+		size_t capacity() const { return size_t(block_.size()); }
+		/// number of doubles in use
+		size_t used() const { return used_; }
+
+		/// arena of the calling thread
+		static ElementArena &thread_local_arena();
+
+	private:
+		Eigen::VectorXd block_;
+		size_t used_ = 0;
+
+		/// blocks allocated when the main one was full and their position in the arena
+		std::vector<std::pair<size_t, Eigen::VectorXd>> overflow_;
+		/// largest number of doubles used at once
+		size_t high_water_ = 0;
+	};
+} // namespace polyfem::utils
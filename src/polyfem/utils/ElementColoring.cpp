@@ -0,0 +1,81 @@
+#include "ElementColoring.hpp"
+
+#include <polyfem/utils/MaybeParallelFor.hpp>
+
+#include <algorithm>
+
+namespace polyfem::utils
+{
+	void ElementColoring::init(const std::vector<std::vector<int>> &element_nodes, const int n_nodes)
+	{
+		n_elements_ = element_nodes.size();
+		colors_.clear();
+
+		// colors already used by the elements touching every node
+		std::vector<std::vector<int>> node_colors(n_nodes);
+		std::vector<bool> forbidden;
+
+		for (int e = 0; e < n_elements_; ++e)
+		{
+			std::fill(forbidden.begin(), forbidden.end(), false);
+			for (const int n : element_nodes[e])
+			{
+				for (const int c : node_colors[n])
+					forbidden[c] = true;
+			}
+
+			const int c = std::find(forbidden.begin(), forbidden.end(), false) - forbidden.begin();
+			if (c == colors_.size())
+			{
+				colors_.emplace_back();
+				forbidden.push_back(false);
+			}
+			colors_[c].push_back(e);
+
+			for (const int n : element_nodes[e])
+			{
+				if (node_colors[n].empty() || node_colors[n].back() != c)
+					node_colors[n].push_back(c);
+			}
+		}
+	}
+
+	void ElementColoring::maybe_parallel_for(const std::function<void(int, int)> &body) const
+	{
+		for (const std::vector<int> &elements : colors_)
+		{
+			utils::maybe_parallel_for(elements.size(), [&](int start, int end, int thread_id) {
+				for (int i = start; i < end; ++i)
+					body(elements[i], thread_id);
+			});
+		}
+	}
+
+	bool ElementColoring::is_valid(const std::vector<std::vector<int>> &element_nodes, const int n_nodes) const
+	{
+		if (n_elements_ != element_nodes.size())
+			return false;
+
+		std::vector<int> node_element(n_nodes);
+		std::vector<bool> colored(n_elements_, false);
+		for (const std::vector<int> &elements : colors_)
+		{
+			std::fill(node_element.begin(), node_element.end(), -1);
+			for (const int e : elements)
+			{
+				if (colored[e])
+					return false;
+				colored[e] = true;
+
+				for (const int n : element_nodes[e])
+				{
+					if (node_element[n] >= 0 && node_element[n] != e)
+						return false;
+					node_element[n] = e;
+				}
+			}
+		}
+
+		return std::find(colored.begin(), colored.end(), false) == colored.end();
+	}
+} // namespace polyfem::utils
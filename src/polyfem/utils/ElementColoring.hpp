@@ -0,0 +1,43 @@
+#pragma once
+
+#include <functional>
+#include <vector>
+
+namespace polyfem::utils
+{
+	/// Partition of the elements in colors such that two elements with the same color never share a node.
+	/// Elements of the same color can be assembled concurrently directly in a shared output,
+	/// without per-thread copies and without atomics.
+	class ElementColoring
+	{
+	public:
+		/// greedy coloring of the elements
+		/// @param[in] element_nodes global nodes touched by every element
+		/// @param[in] n_nodes total number of nodes
+		void init(const std::vector<std::vector<int>> &element_nodes, const int n_nodes);
+
+		void clear()
+		{
+			colors_.clear();
+			n_elements_ = 0;
+		}
+
+		inline bool empty() const { return colors_.empty(); }
+		inline int n_colors() const { return colors_.size(); }
+		inline int n_elements() const { return n_elements_; }
+
+		/// elements of the color c
+		inline const std::vector<int> &color(const int c) const { return colors_[c]; }
+
+		/// calls body(element, thread_id) for every element,
+		/// colors are processed one after the other, the elements of a color (maybe) in parallel
+		void maybe_parallel_for(const std::function<void(int, int)> &body) const;
+
+		/// checks that no two elements of the same color share a node
+		bool is_valid(const std::vector<std::vector<int>> &element_nodes, const int n_nodes) const;
+
+	private:
+		std::vector<std::vector<int>> colors_; ///< elements of every color
+		int n_elements_ = 0;
+	};
+} // namespace polyfem::utils
@@ -0,0 +1,120 @@
+#include "ExpressionTree.hpp"
+
+#include <tinyexpr.h>
+
+#include <cassert>
+#include <limits>
+
+namespace polyfem::utils
+{
+	namespace
+	{
+		// the walker relies on the node layout of the tinyexpr version pinned in cmake/recipes/tinyexpr.cmake
+		static_assert(TE_VARIABLE == 0 && TE_FUNCTION0 == 8 && TE_FUNCTION7 == 15, "Unsupported tinyexpr node types");
+		static_assert(TE_CLOSURE0 == 16 && TE_CLOSURE7 == 23 && TE_FLAG_PURE == 32, "Unsupported tinyexpr node flags");
+
+		// Node type of folded constants, it is not exported by tinyexpr.h so it is read from a compiled constant
+		int constant_type()
+		{
+			static const int type = []() {
+				int err = 0;
+				te_expr *e = te_compile("0", nullptr, 0, &err);
+				assert(e != nullptr && err == 0);
+				const int res = e->type & 0x1F;
+				te_free(e);
+				assert(res != TE_VARIABLE && res < TE_FUNCTION0);
+				return res;
+			}();
+			return type;
+		}
+
+		typedef double (*fun0)();
+		typedef double (*fun1)(double);
+		typedef double (*fun2)(double, double);
+		typedef double (*fun3)(double, double, double);
+		typedef double (*fun4)(double, double, double, double);
+		typedef double (*fun5)(double, double, double, double, double);
+		typedef double (*fun6)(double, double, double, double, double, double);
+		typedef double (*fun7)(double, double, double, double, double, double, double);
+
+		typedef double (*closure0)(void *);
+		typedef double (*closure1)(void *, double);
+		typedef double (*closure2)(void *, double, double);
+		typedef double (*closure3)(void *, double, double, double);
+		typedef double (*closure4)(void *, double, double, double, double);
+		typedef double (*closure5)(void *, double, double, double, double, double);
+		typedef double (*closure6)(void *, double, double, double, double, double, double);
+		typedef double (*closure7)(void *, double, double, double, double, double, double, double);
+	} // namespace
+
+	double eval_expression_tree(const te_expr *n, const std::array<const double *, 4> &bindings, const std::array<double, 4> &values)
+	{
+		if (!n)
+			return std::numeric_limits<double>::quiet_NaN();
+
+		const int type = n->type & 0x1F;
+		if (type == constant_type())
+			return n->value;
+		if (type == TE_VARIABLE)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				if (n->bound == bindings[i])
+					return values[i];
+			}
+			return *n->bound;
+		}
+
+		const auto m = [&](const int i) { return eval_expression_tree(static_cast<const te_expr *>(n->parameters[i]), bindings, values); };
+
+		if (type >= TE_FUNCTION0 && type <= TE_FUNCTION7)
+		{
+			switch (type - TE_FUNCTION0)
+			{
+			case 0:
+				return reinterpret_cast<fun0>(n->function)();
+			case 1:
+				return reinterpret_cast<fun1>(n->function)(m(0));
+			case 2:
+				return reinterpret_cast<fun2>(n->function)(m(0), m(1));
+			case 3:
+				return reinterpret_cast<fun3>(n->function)(m(0), m(1), m(2));
+			case 4:
+				return reinterpret_cast<fun4>(n->function)(m(0), m(1), m(2), m(3));
+			case 5:
+				return reinterpret_cast<fun5>(n->function)(m(0), m(1), m(2), m(3), m(4));
+			case 6:
+				return reinterpret_cast<fun6>(n->function)(m(0), m(1), m(2), m(3), m(4), m(5));
+			case 7:
+				return reinterpret_cast<fun7>(n->function)(m(0), m(1), m(2), m(3), m(4), m(5), m(6));
+			}
+		}
+
+		// closures get their context as first argument, it is stored after the parameters
+		assert(type >= TE_CLOSURE0 && type <= TE_CLOSURE7);
+		const int arity = type - TE_CLOSURE0;
+		void *context = n->parameters[arity];
+		switch (arity)
+		{
+		case 0:
+			return reinterpret_cast<closure0>(n->function)(context);
+		case 1:
+			return reinterpret_cast<closure1>(n->function)(context, m(0));
+		case 2:
+			return reinterpret_cast<closure2>(n->function)(context, m(0), m(1));
+		case 3:
+			return reinterpret_cast<closure3>(n->function)(context, m(0), m(1), m(2));
+		case 4:
+			return reinterpret_cast<closure4>(n->function)(context, m(0), m(1), m(2), m(3));
+		case 5:
+			return reinterpret_cast<closure5>(n->function)(context, m(0), m(1), m(2), m(3), m(4));
+		case 6:
+			return reinterpret_cast<closure6>(n->function)(context, m(0), m(1), m(2), m(3), m(4), m(5));
+		case 7:
+			return reinterpret_cast<closure7>(n->function)(context, m(0), m(1), m(2), m(3), m(4), m(5), m(6));
+		}
+
+		assert(false);
+		return std::numeric_limits<double>::quiet_NaN();
+	}
+} // namespace polyfem::utils
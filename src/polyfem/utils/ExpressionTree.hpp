@@ -0,0 +1,18 @@
+#pragma once
+
+#include <array>
+
+struct te_expr;
+
+namespace polyfem::utils
+{
+	/// Evaluates a tree compiled by te_compile without writing to the bound variables.
+	/// te_eval reads the variables through the bound addresses, which is not thread safe if they are shared;
+	/// this walker substitutes the variables bound to one of the addresses in bindings with the matching entry of values.
+	/// All tinyexpr node types are supported: constants, variables, functions and closures of arity 0 to 7.
+	/// @param[in] expr compiled tree
+	/// @param[in] bindings addresses of the variables passed to te_compile
+	/// @param[in] values values used in place of the bound variables
+	/// @return value of the expression, NaN if expr is null
+	double eval_expression_tree(const te_expr *expr, const std::array<const double *, 4> &bindings, const std::array<double, 4> &values);
+} // namespace polyfem::utils
@@ -1,6 +1,7 @@
 #include "ExpressionValue.hpp"
 
 #include <polyfem/io/MatrixIO.hpp>
+#include <polyfem/utils/ExpressionTree.hpp>
 #include <polyfem/utils/Logger.hpp>
 
 #include <units/units.hpp>
@@ -42,6 +43,25 @@ namespace polyfem
 			return (0 < x) - (x < 0);
 		}
 
+		// te_compile binds the variables to the addresses of x, y, z, and t. Instead of writing
+		// to those (which is not thread safe), eval walks the tree (see eval_expression_tree)
+		// and substitutes the bound addresses with the values of the evaluation point.
+		struct ExpressionValue::CompiledExpression
+		{
+			CompiledExpression() = default;
+			CompiledExpression(const CompiledExpression &) = delete;
+			CompiledExpression &operator=(const CompiledExpression &) = delete;
+			~CompiledExpression() { te_free(expr); }
+
+			double eval(const double px, const double py, const double pz, const double pt) const
+			{
+				return eval_expression_tree(expr, {{&x, &y, &z, &t}}, {{px, py, pz, pt}});
+			}
+
+			double x = 0, y = 0, z = 0, t = 0;
+			te_expr *expr = nullptr;
+		};
+
 		ExpressionValue::ExpressionValue()
 		{
 			clear();
@@ -50,6 +70,7 @@ namespace polyfem
 		void ExpressionValue::clear()
 		{
 			expr_ = "";
+			compiled_ = nullptr;
 			mat_.resize(0, 0);
 			sfunc_ = nullptr;
 			tfunc_ = nullptr;
@@ -89,13 +110,13 @@ namespace polyfem
 
 			expr_ = expr;
 
-			double x = 0, y = 0, z = 0, t = 0;
+			auto compiled = std::make_shared<CompiledExpression>();
 
 			std::vector<te_variable> vars = {
-				{"x", &x, TE_VARIABLE},
-				{"y", &y, TE_VARIABLE},
-				{"z", &z, TE_VARIABLE},
-				{"t", &t, TE_VARIABLE},
+				{"x", &compiled->x, TE_VARIABLE},
+				{"y", &compiled->y, TE_VARIABLE},
+				{"z", &compiled->z, TE_VARIABLE},
+				{"t", &compiled->t, TE_VARIABLE},
 				{"min", (const void *)min, TE_FUNCTION2},
 				{"max", (const void *)max, TE_FUNCTION2},
 				{"deg2rad", (const void *)deg2rad, TE_FUNCTION1},
@@ -107,14 +128,15 @@ namespace polyfem
 			};
 
 			int err;
-			te_expr *tmp = te_compile(expr.c_str(), vars.data(), vars.size(), &err);
-			if (!tmp)
+			compiled->expr = te_compile(expr.c_str(), vars.data(), vars.size(), &err);
+			if (!compiled->expr)
 			{
 				logger().error("Unable to parse: {}", expr);
 				logger().error("Error near here: {0: >{1}}", "^", err - 1);
 				assert(false);
 			}
-			te_free(tmp);
+
+			compiled_ = compiled;
 		}
 
 		void ExpressionValue::init(const json &vals)
@@ -181,56 +203,60 @@ namespace polyfem
 			tfunc_coo_ = coo;
 		}
 
+		double ExpressionValue::evaluate_raw(double x, double y, double z, double t, int index) const
+		{
+			if (compiled_)
+				return compiled_->eval(x, y, z, t);
+			else if (mat_.size() > 0)
+				return mat_(index);
+			else if (sfunc_)
+				return sfunc_(x, y, z, t, index);
+			else if (tfunc_)
+				return tfunc_(x, y, z, t)(tfunc_coo_);
+
+			return value_;
+		}
+
 		double ExpressionValue::operator()(double x, double y, double z, double t, int index) const
 		{
 			assert(unit_type_set_);
 
-			double result;
-			if (expr_.empty())
+			double result = evaluate_raw(x, y, z, t, index);
+
+			if (!unit_.base_units().empty())
 			{
-				if (mat_.size() > 0)
-					result = mat_(index);
-				else if (sfunc_)
-					result = sfunc_(x, y, z, t, index);
-				else if (tfunc_)
-					result = tfunc_(x, y, z, t)(tfunc_coo_);
-				else
-					result = value_;
+				if (!unit_.is_convertible(unit_type_))
+					log_and_throw_error(fmt::format("Cannot convert {} to {}", units::to_string(unit_), units::to_string(unit_type_)));
+
+				result = units::convert(result, unit_, unit_type_);
 			}
-			else
-			{
 
-				std::vector<te_variable> vars = {
-					{"x", &x, TE_VARIABLE},
-					{"y", &y, TE_VARIABLE},
-					{"z", &z, TE_VARIABLE},
-					{"t", &t, TE_VARIABLE},
-					{"min", (const void *)min, TE_FUNCTION2},
-					{"max", (const void *)max, TE_FUNCTION2},
-					{"deg2rad", (const void *)deg2rad, TE_FUNCTION1},
-					{"rotate_2D_x", (const void *)rotate_2D_x, TE_FUNCTION3},
-					{"rotate_2D_y", (const void *)rotate_2D_y, TE_FUNCTION3},
-					{"if", (const void *)iflargerthanzerothenelse, TE_FUNCTION3},
-					{"smooth_abs", (const void *)smooth_abs, TE_FUNCTION2},
-					{"sign", (const void *)sign, TE_FUNCTION1},
-				};
-
-				int err;
-				te_expr *tmp = te_compile(expr_.c_str(), vars.data(), vars.size(), &err);
-				assert(tmp != nullptr);
-				result = te_eval(tmp);
-				te_free(tmp);
+			return result;
+		}
+
+		void ExpressionValue::evaluate(const Eigen::MatrixXd &pts, const double t, Eigen::VectorXd &out, const int index) const
+		{
+			assert(unit_type_set_);
+			assert(pts.cols() == 2 || pts.cols() == 3);
+
+			out.resize(pts.rows());
+
+			if (compiled_ || sfunc_ || tfunc_)
+			{
+				for (int p = 0; p < pts.rows(); ++p)
+					out(p) = evaluate_raw(pts(p, 0), pts(p, 1), pts.cols() == 3 ? pts(p, 2) : 0, t, index);
 			}
+			else
+				out.setConstant(mat_.size() > 0 ? mat_(index) : value_);
 
 			if (!unit_.base_units().empty())
 			{
 				if (!unit_.is_convertible(unit_type_))
 					log_and_throw_error(fmt::format("Cannot convert {} to {}", units::to_string(unit_), units::to_string(unit_type_)));
 
-				result = units::convert(result, unit_, unit_type_);
+				for (int p = 0; p < out.size(); ++p)
+					out(p) = units::convert(out(p), unit_, unit_type_);
 			}
-
-			return result;
 		}
 	} // namespace utils
 } // namespace polyfem
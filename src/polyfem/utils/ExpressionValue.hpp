@@ -4,6 +4,8 @@
 
 #include <units/units.hpp>
 
+#include <memory>
+
 namespace polyfem
 {
 	namespace utils
@@ -33,16 +35,30 @@ namespace polyfem
 
 			double operator()(double x, double y, double z = 0, double t = 0, int index = -1) const;
 
+			/// Evaluates the value at every row of pts (2 or 3 columns) at time t.
+			/// Expressions are compiled once in init, so this only walks the compiled tree per point.
+			/// @param[in] pts Evaluation points, one per row
+			/// @param[in] t Time
+			/// @param[out] out Values, one per point
+			/// @param[in] index Index passed to matrix and function values
+			void evaluate(const Eigen::MatrixXd &pts, const double t, Eigen::VectorXd &out, const int index = -1) const;
+
 			void clear();
 
 			bool is_zero() const { return expr_.empty() && fabs(value_) < 1e-10; }
 
 		private:
+			struct CompiledExpression;
+
+			double evaluate_raw(double x, double y, double z, double t, int index) const;
+
 			std::function<double(double x, double y, double z, double t, int index)> sfunc_;
 			std::function<Eigen::MatrixXd(double x, double y, double z, double t)> tfunc_;
 			int tfunc_coo_;
 
 			std::string expr_;
+			// Immutable after init, shared between copies and evaluated concurrently
+			std::shared_ptr<const CompiledExpression> compiled_;
 			double value_;
 			Eigen::MatrixXd mat_;
 
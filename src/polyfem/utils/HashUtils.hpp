@@ -1,7 +1,11 @@
 #pragma once
 
+#include <Eigen/Core>
+
+#include <algorithm>
 #include <cstddef> // size_t
 #include <array>
+#include <functional>
 #include <vector>
 
 namespace polyfem::utils
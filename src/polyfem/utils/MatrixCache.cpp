@@ -3,6 +3,8 @@
 #include <polyfem/utils/MaybeParallelFor.hpp>
 #include <polyfem/utils/Logger.hpp>
 
+#include <algorithm>
+
 namespace polyfem::utils
 {
 	SparseMatrixCache::SparseMatrixCache(const size_t size)
@@ -403,4 +405,136 @@ namespace polyfem::utils
 		mat_ += o.mat_;
 	}
 
-} // namespace polyfem::utils
\ No newline at end of file
+
+	// ========================================================================
+
+	BlockSparseMatrixCache::BlockSparseMatrixCache(const size_t size, const int block_size)
+		: block_size_(block_size)
+	{
+		init(size);
+	}
+
+	BlockSparseMatrixCache::BlockSparseMatrixCache(const size_t rows, const size_t cols, const int block_size)
+		: block_size_(block_size)
+	{
+		init(rows, cols);
+	}
+
+	BlockSparseMatrixCache::BlockSparseMatrixCache(const MatrixCache &other)
+	{
+		init(other);
+	}
+
+	void BlockSparseMatrixCache::init(const size_t size)
+	{
+		init(size, size);
+	}
+
+	void BlockSparseMatrixCache::init(const size_t rows, const size_t cols)
+	{
+		assert(rows % block_size_ == 0 && cols % block_size_ == 0);
+		mat_.resize(rows / block_size_, cols / block_size_, block_size_);
+		entry_blocks_.clear();
+		entry_values_.clear();
+	}
+
+	void BlockSparseMatrixCache::init(const MatrixCache &other)
+	{
+		assert(&other == &dynamic_cast<const BlockSparseMatrixCache &>(other));
+		init(dynamic_cast<const BlockSparseMatrixCache &>(other));
+	}
+
+	void BlockSparseMatrixCache::init(const BlockSparseMatrixCache &other)
+	{
+		block_size_ = other.block_size_;
+		init(other.mat_.rows(), other.mat_.cols());
+	}
+
+	void BlockSparseMatrixCache::set_zero()
+	{
+		mat_.set_zero();
+		entry_blocks_.clear();
+		entry_values_.clear();
+	}
+
+	void BlockSparseMatrixCache::add_value(const int e, const int i, const int j, const double value)
+	{
+		entry_blocks_.emplace_back(i / block_size_, j / block_size_);
+		entry_values_.resize(entry_values_.size() + block_size_ * block_size_, 0);
+		entry_values_[entry_values_.size() - block_size_ * block_size_ + (i % block_size_) * block_size_ + j % block_size_] = value;
+	}
+
+	void BlockSparseMatrixCache::add_block(const int e, const int block_row, const int block_col, const int block_size, const double *values)
+	{
+		assert(block_size == block_size_);
+
+		entry_blocks_.emplace_back(block_row, block_col);
+		entry_values_.insert(entry_values_.end(), values, values + block_size_ * block_size_);
+	}
+
+	void BlockSparseMatrixCache::append_matrix_blocks(std::vector<std::pair<int, int>> &blocks, std::vector<double> &values) const
+	{
+		for (int r = 0; r < mat_.block_rows(); ++r)
+		{
+			for (int k = mat_.outer_index()[r]; k < mat_.outer_index()[r + 1]; ++k)
+				blocks.emplace_back(r, mat_.inner_index()[k]);
+		}
+		// the stored blocks are contiguous and in the same order
+		values.insert(values.end(), mat_.values().begin(), mat_.values().end());
+	}
+
+	void BlockSparseMatrixCache::prune()
+	{
+		if (entry_blocks_.empty())
+			return;
+
+		append_matrix_blocks(entry_blocks_, entry_values_);
+		mat_.set_from_blocks(entry_blocks_, entry_values_);
+
+		entry_blocks_.clear();
+		entry_values_.clear();
+	}
+
+	const BlockSparseMatrix &BlockSparseMatrixCache::block_matrix()
+	{
+		prune();
+		return mat_;
+	}
+
+	polyfem::StiffnessMatrix BlockSparseMatrixCache::get_matrix(const bool compute_mapping)
+	{
+		StiffnessMatrix res;
+		block_matrix().to_sparse(res);
+		return res;
+	}
+
+	std::shared_ptr<MatrixCache> BlockSparseMatrixCache::operator+(const MatrixCache &a) const
+	{
+		assert(&a == &dynamic_cast<const BlockSparseMatrixCache &>(a));
+		return *this + dynamic_cast<const BlockSparseMatrixCache &>(a);
+	}
+
+	std::shared_ptr<MatrixCache> BlockSparseMatrixCache::operator+(const BlockSparseMatrixCache &a) const
+	{
+		std::shared_ptr<BlockSparseMatrixCache> out = std::make_shared<BlockSparseMatrixCache>(a);
+		*out += *this;
+		return out;
+	}
+
+	void BlockSparseMatrixCache::operator+=(const MatrixCache &o)
+	{
+		assert(&o == &dynamic_cast<const BlockSparseMatrixCache &>(o));
+		*this += dynamic_cast<const BlockSparseMatrixCache &>(o);
+	}
+
+	void BlockSparseMatrixCache::operator+=(const BlockSparseMatrixCache &o)
+	{
+		assert(o.block_size_ == block_size_);
+		assert(o.mat_.rows() == mat_.rows() && o.mat_.cols() == mat_.cols());
+
+		// the blocks are merged at the next prune
+		entry_blocks_.insert(entry_blocks_.end(), o.entry_blocks_.begin(), o.entry_blocks_.end());
+		entry_values_.insert(entry_values_.end(), o.entry_values_.begin(), o.entry_values_.end());
+		o.append_matrix_blocks(entry_blocks_, entry_values_);
+	}
+} // namespace polyfem::utils
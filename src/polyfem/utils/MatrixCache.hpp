@@ -1,5 +1,6 @@
 #pragma once
 
+#include <polyfem/utils/BlockSparseMatrix.hpp>
 #include <polyfem/utils/Types.hpp>
 
 #include <Eigen/Dense>
@@ -33,6 +34,13 @@ namespace polyfem::utils
 		bool is_dense() const { return !is_sparse(); }
 
 		virtual void add_value(const int e, const int i, const int j, const double value) = 0;
+		/// adds the block_size x block_size block (row major) at rows block_row * block_size and columns block_col * block_size
+		virtual void add_block(const int e, const int block_row, const int block_col, const int block_size, const double *values)
+		{
+			for (int i = 0; i < block_size; ++i)
+				for (int j = 0; j < block_size; ++j)
+					add_value(e, block_row * block_size + i, block_col * block_size + j, values[i * block_size + j]);
+		}
 		virtual StiffnessMatrix get_matrix(const bool compute_mapping = true) = 0;
 		virtual void prune() = 0;
 
@@ -175,4 +183,71 @@ namespace polyfem::utils
 	private:
 		Eigen::MatrixXd mat_;
 	};
+
+	/// cache of a block sparse matrix, the values are added in block_size x block_size blocks (see BlockSparseMatrix)
+	class BlockSparseMatrixCache : public MatrixCache
+	{
+	public:
+		BlockSparseMatrixCache() {}
+		BlockSparseMatrixCache(const size_t size, const int block_size);
+		BlockSparseMatrixCache(const size_t rows, const size_t cols, const int block_size);
+		BlockSparseMatrixCache(const MatrixCache &other);
+		BlockSparseMatrixCache(const BlockSparseMatrixCache &other) = default;
+
+		inline std::unique_ptr<MatrixCache> copy() const override
+		{
+			return std::make_unique<BlockSparseMatrixCache>(*this);
+		}
+
+		/// set matrix to be size x size, size must be a multiple of the block size
+		void init(const size_t size) override;
+		/// set matrix to be rows x cols, rows and cols must be multiples of the block size
+		void init(const size_t rows, const size_t cols) override;
+		/// set matrix to be a matrix of all zeros with same size and block size as other
+		void init(const MatrixCache &other) override;
+		void init(const BlockSparseMatrixCache &other);
+
+		void set_zero() override;
+
+		// the sizes are in scalar entries, to be comparable with the other caches
+		inline void reserve(const size_t size) override
+		{
+			entry_blocks_.reserve(size / (block_size_ * block_size_) + 1);
+			entry_values_.reserve(entry_blocks_.capacity() * block_size_ * block_size_);
+		}
+		inline size_t entries_size() const override { return entry_values_.size(); }
+		inline size_t capacity() const override { return entry_values_.capacity(); }
+		inline size_t non_zeros() const override { return mat_.non_zeros(); }
+		inline size_t triplet_count() const override { return entries_size() + mat_.non_zeros(); }
+		inline bool is_sparse() const override { return true; }
+
+		/// adds a single value, prefer add_block
+		void add_value(const int e, const int i, const int j, const double value) override;
+		void add_block(const int e, const int block_row, const int block_col, const int block_size, const double *values) override;
+		/// scalar sparse matrix with the accumulated values
+		StiffnessMatrix get_matrix(const bool compute_mapping = true) override;
+		/// merges the saved blocks in the stored matrix
+		void prune() override;
+
+		/// block sparse matrix with the accumulated values
+		const BlockSparseMatrix &block_matrix();
+
+		std::shared_ptr<MatrixCache> operator+(const MatrixCache &a) const override;
+		std::shared_ptr<MatrixCache> operator+(const BlockSparseMatrixCache &a) const;
+		void operator+=(const MatrixCache &o) override;
+		void operator+=(const BlockSparseMatrixCache &o);
+
+		inline int block_size() const { return block_size_; }
+		const BlockSparseMatrix &mat() const { return mat_; }
+
+	private:
+		/// appends the blocks of mat_ to blocks and values
+		void append_matrix_blocks(std::vector<std::pair<int, int>> &blocks, std::vector<double> &values) const;
+
+		int block_size_ = 1;
+		BlockSparseMatrix mat_;
+		/// blocks added since the last prune, block_size^2 values per block (see BlockSparseMatrix::set_from_blocks)
+		std::vector<std::pair<int, int>> entry_blocks_;
+		std::vector<double> entry_values_;
+	};
 } // namespace polyfem::utils
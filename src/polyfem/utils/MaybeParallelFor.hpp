@@ -1,5 +1,9 @@
 #pragma once
 
+#include <Eigen/Core>
+
+#include <functional>
+
 #if defined(POLYFEM_WITH_TBB)
 #include <tbb/parallel_for.h>
 #include <tbb/parallel_reduce.h>
@@ -30,6 +34,23 @@ namespace polyfem
 
 		template <typename Storages>
 		inline auto &get_local_thread_storage(Storages &storage, int thread_id);
+
+		// Templated versions of the loops above, the kernel type is known at compile time so the
+		// per-element call can be inlined; at most one indirect call is made per chunk of elements.
+
+		// Calls `kernel(e, thread_id)` for every e from 0 up to `size`.
+		template <typename Kernel>
+		inline void parallel_for_each_element(int size, Kernel &&kernel);
+
+		// Returns the sum over e of `kernel(e, scratch)`, where `scratch` is a thread local copy of
+		// `initial_scratch` (e.g., buffers for the element values).
+		template <typename Scratch, typename Kernel>
+		inline double parallel_reduce_sum(int size, const Scratch &initial_scratch, Kernel &&kernel);
+
+		// Computes `result` (of size `vec_size`) as the sum over e of the contributions added by
+		// `kernel(e, scratch, local_result)` to a thread local vector `local_result`.
+		template <typename Scratch, typename Kernel>
+		inline void parallel_reduce_vector(int size, int vec_size, const Scratch &initial_scratch, Kernel &&kernel, Eigen::MatrixXd &result);
 	} // namespace utils
 } // namespace polyfem
 
@@ -31,8 +31,10 @@ namespace polyfem
 		inline void maybe_parallel_for(int size, const std::function<void(int)> &body)
 		{
 #if defined(POLYFEM_WITH_CPP_THREADS)
-			for (int i = 0; i < size; ++i)
-				body(i);
+			par_for(size, [&](int start, int end, int thread_id) {
+				for (int i = start; i < end; ++i)
+					body(i);
+			});
 #elif defined(POLYFEM_WITH_TBB)
 			tbb::parallel_for(0, size, body);
 #else
@@ -66,5 +68,79 @@ namespace polyfem
 			return storage[0];
 #endif
 		}
+
+		namespace internal
+		{
+			// calls chunk(start, end, thread_id) on a partition of [0, size)
+			template <typename Chunk>
+			inline void for_each_chunk(int size, Chunk &&chunk)
+			{
+#if defined(POLYFEM_WITH_CPP_THREADS)
+				par_for(size, chunk);
+#elif defined(POLYFEM_WITH_TBB)
+				tbb::parallel_for(tbb::blocked_range<int>(0, size), [&](const tbb::blocked_range<int> &r) {
+					chunk(r.begin(), r.end(), tbb::this_task_arena::current_thread_index());
+				});
+#else
+				chunk(0, size, /*thread_id=*/0);
+#endif
+			}
+		} // namespace internal
+
+		template <typename Kernel>
+		inline void parallel_for_each_element(int size, Kernel &&kernel)
+		{
+			internal::for_each_chunk(size, [&](int start, int end, int thread_id) {
+				for (int e = start; e < end; ++e)
+					kernel(e, thread_id);
+			});
+		}
+
+		template <typename Scratch, typename Kernel>
+		inline double parallel_reduce_sum(int size, const Scratch &initial_scratch, Kernel &&kernel)
+		{
+			struct LocalStorage
+			{
+				Scratch scratch;
+				double val;
+			};
+			auto storage = create_thread_storage(LocalStorage{initial_scratch, 0.});
+
+			internal::for_each_chunk(size, [&](int start, int end, int thread_id) {
+				LocalStorage &local_storage = get_local_thread_storage(storage, thread_id);
+				double val = 0;
+				for (int e = start; e < end; ++e)
+					val += kernel(e, local_storage.scratch);
+				local_storage.val += val;
+			});
+
+			double res = 0;
+			// Serially merge local storages
+			for (const LocalStorage &local_storage : storage)
+				res += local_storage.val;
+			return res;
+		}
+
+		template <typename Scratch, typename Kernel>
+		inline void parallel_reduce_vector(int size, int vec_size, const Scratch &initial_scratch, Kernel &&kernel, Eigen::MatrixXd &result)
+		{
+			struct LocalStorage
+			{
+				Scratch scratch;
+				Eigen::MatrixXd vec;
+			};
+			auto storage = create_thread_storage(LocalStorage{initial_scratch, Eigen::MatrixXd::Zero(vec_size, 1)});
+
+			internal::for_each_chunk(size, [&](int start, int end, int thread_id) {
+				LocalStorage &local_storage = get_local_thread_storage(storage, thread_id);
+				for (int e = start; e < end; ++e)
+					kernel(e, local_storage.scratch, local_storage.vec);
+			});
+
+			result.setZero(vec_size, 1);
+			// Serially merge local storages
+			for (const LocalStorage &local_storage : storage)
+				result += local_storage.vec;
+		}
 	} // namespace utils
 } // namespace polyfem
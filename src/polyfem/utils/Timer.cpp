@@ -0,0 +1,268 @@
+#include "Timer.hpp"
+
+#include <polyfem/Common.hpp>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <new>
+#include <set>
+
+namespace polyfem::utils
+{
+	namespace
+	{
+		// bytes allocated with operator new by the current thread (only counted with POLYFEM_WITH_ALLOCATION_PROFILING)
+		thread_local size_t allocated_bytes = 0;
+
+		struct OpenScope
+		{
+			std::string name;
+			std::string path;
+			size_t allocated_bytes = 0;
+		};
+
+		// scopes currently open on this thread, innermost last
+		thread_local std::vector<OpenScope> open_scopes;
+
+		int thread_index()
+		{
+			static std::atomic<int> n_threads{0};
+			thread_local const int index = n_threads++;
+			return index;
+		}
+	} // namespace
+
+	std::atomic<bool> Profiler::enabled_{false};
+
+	Profiler::Profiler()
+	{
+		origin_ = now();
+	}
+
+	Profiler &Profiler::get()
+	{
+		static Profiler instance;
+		return instance;
+	}
+
+	double Profiler::now() const
+	{
+		using namespace std::chrono;
+		return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+	}
+
+	void Profiler::clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		events_.clear();
+		origin_ = now();
+	}
+
+	bool Profiler::tracks_allocations()
+	{
+#ifdef POLYFEM_WITH_ALLOCATION_PROFILING
+		return true;
+#else
+		return false;
+#endif
+	}
+
+	double Profiler::begin_scope(const std::string &name)
+	{
+		OpenScope scope;
+		scope.name = name;
+		scope.path = open_scopes.empty() ? name : (open_scopes.back().path + "/" + name);
+		open_scopes.push_back(std::move(scope));
+		// after the bookkeeping allocations of the profiler
+		open_scopes.back().allocated_bytes = allocated_bytes;
+
+		return get().now();
+	}
+
+	void Profiler::end_scope(const double start)
+	{
+		const size_t end_bytes = allocated_bytes;
+		Profiler &profiler = get();
+		const double end = profiler.now();
+
+		if (open_scopes.empty())
+			return;
+
+		Event event;
+		event.name = std::move(open_scopes.back().name);
+		event.path = std::move(open_scopes.back().path);
+		event.bytes = end_bytes - open_scopes.back().allocated_bytes;
+		open_scopes.pop_back();
+		event.depth = open_scopes.size();
+		event.thread = thread_index();
+		event.duration = end - start;
+
+		std::lock_guard<std::mutex> lock(profiler.mutex_);
+		event.start = start - profiler.origin_;
+		profiler.events_.push_back(std::move(event));
+	}
+
+	std::vector<Profiler::Event> Profiler::events() const
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		return events_;
+	}
+
+	json Profiler::summary() const
+	{
+		const std::vector<Event> events = this->events();
+
+		struct Stats
+		{
+			size_t count = 0;
+			double total = 0;
+			double min = std::numeric_limits<double>::max();
+			double max = 0;
+			size_t bytes = 0;
+			std::set<int> threads;
+		};
+		std::map<std::string, Stats> scopes;
+		std::map<int, double> busy;
+		double first = std::numeric_limits<double>::max(), last = 0;
+
+		for (const Event &e : events)
+		{
+			Stats &s = scopes[e.path];
+			++s.count;
+			s.total += e.duration;
+			s.min = std::min(s.min, e.duration);
+			s.max = std::max(s.max, e.duration);
+			s.bytes += e.bytes;
+			s.threads.insert(e.thread);
+
+			if (e.depth == 0)
+				busy[e.thread] += e.duration;
+
+			first = std::min(first, e.start);
+			last = std::max(last, e.start + e.duration);
+		}
+
+		json j;
+		j["scopes"] = json::object();
+		for (const auto &[path, s] : scopes)
+		{
+			j["scopes"][path] = {
+				{"count", s.count},
+				{"total", s.total * 1e-6},
+				{"min", s.min * 1e-6},
+				{"max", s.max * 1e-6},
+				{"threads", s.threads.size()},
+			};
+			if (tracks_allocations())
+				j["scopes"][path]["bytes"] = s.bytes;
+		}
+
+		j["threads"] = json::array();
+		for (const auto &[thread, t] : busy)
+			j["threads"].push_back({{"thread", thread}, {"busy", t * 1e-6}});
+
+		j["wall"] = events.empty() ? 0. : (last - first) * 1e-6;
+
+		return j;
+	}
+
+	void Profiler::write_trace(const std::string &path) const
+	{
+		std::ofstream file(path);
+		if (!file.good())
+		{
+			logger().error("Unable to write profiler trace to {}", path);
+			return;
+		}
+
+		json trace_events = json::array();
+		for (const Event &e : events())
+		{
+			json args = {{"path", e.path}};
+			if (tracks_allocations())
+				args["bytes"] = e.bytes;
+
+			trace_events.push_back({
+				{"name", e.name},
+				{"cat", "polyfem"},
+				{"ph", "X"},
+				{"ts", e.start},
+				{"dur", e.duration},
+				{"pid", 0},
+				{"tid", e.thread},
+				{"args", args},
+			});
+		}
+
+		json j;
+		j["traceEvents"] = trace_events;
+		j["displayTimeUnit"] = "ms";
+		j["otherData"] = summary();
+
+		file << j.dump() << std::endl;
+	}
+} // namespace polyfem::utils
+
+#ifdef POLYFEM_WITH_ALLOCATION_PROFILING
+// Replaceable allocation functions counting the bytes of the calling thread.
+// The aligned overloads are not replaced, they keep the default implementation.
+namespace
+{
+	void *counted_malloc(std::size_t size)
+	{
+		polyfem::utils::allocated_bytes += size;
+		if (size == 0)
+			size = 1;
+
+		while (true)
+		{
+			if (void *ptr = std::malloc(size))
+				return ptr;
+
+			const std::new_handler handler = std::get_new_handler();
+			if (!handler)
+				return nullptr;
+			handler();
+		}
+	}
+} // namespace
+
+void *operator new(std::size_t size)
+{
+	if (void *ptr = counted_malloc(size))
+		return ptr;
+	throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+	try
+	{
+		return counted_malloc(size);
+	}
+	catch (...)
+	{
+		return nullptr;
+	}
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &tag) noexcept
+{
+	return operator new(size, tag);
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+#endif
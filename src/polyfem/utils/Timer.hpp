@@ -7,7 +7,18 @@
 
 #include <igl/Timer.h>
 
+#include <nlohmann/json_fwd.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
 #define POLYFEM_SCOPED_TIMER(...) polyfem::utils::Timer __polyfem_timer(__VA_ARGS__)
+#define POLYFEM_PROFILE_CONCAT_IMPL(a, b) a##b
+#define POLYFEM_PROFILE_CONCAT(a, b) POLYFEM_PROFILE_CONCAT_IMPL(a, b)
+#define POLYFEM_PROFILE_SCOPE(...) polyfem::utils::ProfileScope POLYFEM_PROFILE_CONCAT(__polyfem_profile_scope_, __LINE__)(__VA_ARGS__)
 
 namespace polyfem
 {
@@ -27,6 +38,117 @@ namespace polyfem
 			size_t count = 0;
 		};
 
+		/// Hierarchical profiler collecting named scopes (timings, call counts, allocated bytes, and threads).
+		/// Scopes are opened by named Timers (i.e., POLYFEM_SCOPED_TIMER("name")) and POLYFEM_PROFILE_SCOPE;
+		/// nested scopes on the same thread are recorded as "parent/child". Disabled by default, when
+		/// disabled the scopes cost a single atomic load.
+		///
+		/// The allocated bytes are only counted when built with POLYFEM_WITH_ALLOCATION_PROFILING, which replaces
+		/// the global operator new with one that counts the bytes of the calling thread. They include the
+		/// std containers and the Eigen sparse matrices, but not the Eigen dense matrices, which call malloc directly.
+		/// A scope counts the allocations of its own thread only (the workers of a parallel loop report them in their scopes).
+		class Profiler
+		{
+		public:
+			struct Event
+			{
+				/// name of the scope
+				std::string name;
+				/// full path of the scope, i.e., the names of the enclosing scopes separated by '/'
+				std::string path;
+				/// nesting depth on its thread
+				int depth;
+				/// profiler thread index
+				int thread;
+				/// start time and duration in microseconds, relative to the last clear
+				double start;
+				double duration;
+				/// bytes allocated by the thread while the scope was open, including the nested scopes
+				size_t bytes;
+			};
+
+			static Profiler &get();
+
+			static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+			void enable(const bool val) { enabled_.store(val, std::memory_order_relaxed); }
+
+			/// removes all recorded events and resets the time origin
+			void clear();
+
+			/// true if the allocated bytes are counted, see POLYFEM_WITH_ALLOCATION_PROFILING
+			static bool tracks_allocations();
+
+			/// opens a scope on the current thread, returns its start time
+			static double begin_scope(const std::string &name);
+			/// closes the innermost scope of the current thread
+			static void end_scope(const double start);
+
+			std::vector<Event> events() const;
+
+			/// per scope path: count, total/min/max time (s), allocated bytes (if tracked), and number of threads;
+			/// per thread: busy time (s) of the top-level scopes; and the wall time (s) between the first and last event
+			nlohmann::json summary() const;
+
+			/// writes the events in the Chrome trace format (chrome://tracing or https://ui.perfetto.dev),
+			/// the summary is stored in "otherData"
+			void write_trace(const std::string &path) const;
+
+		private:
+			Profiler();
+
+			double now() const;
+
+			static std::atomic<bool> enabled_;
+
+			mutable std::mutex mutex_;
+			std::vector<Event> events_;
+			double origin_;
+		};
+
+		/// RAII profiler scope, does nothing when the profiler is disabled. The name can be given
+		/// as a callable so it is only built when profiling, e.g. [&] { return name() + " value"; }
+		class ProfileScope
+		{
+		public:
+			ProfileScope(const std::string &name)
+			{
+				if (Profiler::enabled())
+					begin(name);
+			}
+
+			ProfileScope(const char *name)
+			{
+				if (Profiler::enabled())
+					begin(name);
+			}
+
+			template <typename NameFn, typename = std::enable_if_t<std::is_invocable_r_v<std::string, NameFn>>>
+			ProfileScope(NameFn &&name)
+			{
+				if (Profiler::enabled())
+					begin(name());
+			}
+
+			~ProfileScope()
+			{
+				if (is_running)
+					Profiler::end_scope(m_start);
+			}
+
+			ProfileScope(const ProfileScope &) = delete;
+			ProfileScope &operator=(const ProfileScope &) = delete;
+
+		private:
+			void begin(const std::string &name)
+			{
+				m_start = Profiler::begin_scope(name);
+				is_running = true;
+			}
+
+			double m_start = 0;
+			bool is_running = false;
+		};
+
 		class Timer
 		{
 		public:
@@ -72,6 +194,12 @@ namespace polyfem
 
 			inline void start()
 			{
+				if (is_profiled)
+					Profiler::end_scope(m_profile_start);
+				is_profiled = !m_name.empty() && Profiler::enabled();
+				if (is_profiled)
+					m_profile_start = Profiler::begin_scope(m_name);
+
 				is_running = true;
 				m_timer.start();
 			}
@@ -82,6 +210,11 @@ namespace polyfem
 					return;
 				m_timer.stop();
 				is_running = false;
+				if (is_profiled)
+				{
+					Profiler::end_scope(m_profile_start);
+					is_profiled = false;
+				}
 				log_msg();
 				if (m_total_time)
 					*m_total_time += getElapsedTimeInSec();
@@ -116,6 +249,8 @@ namespace polyfem
 			double *m_total_time = nullptr;
 			size_t *m_count = nullptr;
 			bool is_running = false;
+			bool is_profiled = false;
+			double m_profile_start = 0;
 		};
 	} // namespace utils
 } // namespace polyfem
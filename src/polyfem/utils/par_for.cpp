@@ -3,30 +3,236 @@
 #include <vector>
 #include <algorithm>
 
+#ifdef POLYFEM_WITH_CPP_THREADS
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#endif
+
 namespace polyfem
 {
 	namespace utils
 	{
-		void par_for(const int size, const std::function<void(int, int, int)> &func)
-		{
 #ifdef POLYFEM_WITH_CPP_THREADS
-			const size_t n_threads = get_n_threads();
-			if (n_threads == 1)
-				func(0, size, /*thread_id=*/0); // actually the full for loop
-			else
+		namespace
+		{
+			// true on the pool workers and on a thread running a parallel loop, nested loops run serially
+			thread_local bool in_parallel_region = false;
+
+			/// Persistent pool of workers executing one loop at a time. The iteration range is split evenly
+			/// between the threads, every thread processes its own range in chunks of `grain` iterations
+			/// and, when it is empty, steals the back half of the range of another thread.
+			class ThreadPool
 			{
-				std::vector<std::thread> threads(n_threads);
+			public:
+				static ThreadPool &get()
+				{
+					static ThreadPool instance;
+					return instance;
+				}
+
+				~ThreadPool()
+				{
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						stop_ = true;
+					}
+					start_cv_.notify_all();
+					for (std::thread &w : workers_)
+						w.join();
+				}
+
+				/// runs func on [0, size) with n_threads threads (the calling thread has id 0),
+				/// returns false if the pool is busy with another loop
+				bool run(const int size, const std::function<void(int, int, int)> &func, const int n_threads)
+				{
+					std::unique_lock<std::mutex> run_lock(run_mutex_, std::try_to_lock);
+					if (!run_lock.owns_lock())
+						return false;
+
+					ensure_workers(n_threads - 1);
+
+					ranges_.reset(new Range[n_threads]);
+					for (int t = 0; t < n_threads; ++t)
+					{
+						ranges_[t].begin = int(long(t) * size / n_threads);
+						ranges_[t].end = int(long(t + 1) * size / n_threads);
+					}
+					// small chunks balance uneven elements, the stealing keeps them mostly contiguous
+					grain_ = std::max(1, size / (8 * n_threads));
+					func_ = &func;
+					n_threads_ = n_threads;
+					exception_ = nullptr;
+					cancelled_ = false;
+
+					{
+						std::lock_guard<std::mutex> lock(mutex_);
+						n_running_ = n_threads - 1;
+						++generation_;
+					}
+					start_cv_.notify_all();
+
+					in_parallel_region = true;
+					execute(0);
+					in_parallel_region = false;
+
+					{
+						std::unique_lock<std::mutex> lock(mutex_);
+						done_cv_.wait(lock, [&] { return n_running_ == 0; });
+					}
+
+					func_ = nullptr;
+					if (exception_)
+						std::rethrow_exception(exception_);
+
+					return true;
+				}
+
+			private:
+				struct alignas(64) Range
+				{
+					std::mutex mutex;
+					// modified under the mutex, atomic so that thieves can estimate the remaining size
+					std::atomic<int> begin{0};
+					std::atomic<int> end{0};
+				};
+
+				ThreadPool() {}
 
-				for (int t = 0; t < n_threads; t++)
+				void ensure_workers(const int n_workers)
 				{
-					threads[t] = std::thread(std::bind(
-						func,
-						t * size / n_threads,
-						(t + 1) == n_threads ? size : (t + 1) * size / n_threads,
-						t));
+					std::lock_guard<std::mutex> lock(mutex_);
+					for (int t = workers_.size(); t < n_workers; ++t)
+						workers_.emplace_back(&ThreadPool::worker_loop, this, t + 1, generation_);
 				}
-				std::for_each(threads.begin(), threads.end(), [](std::thread &x) { x.join(); });
-			}
+
+				void worker_loop(const int thread_id, size_t generation)
+				{
+					in_parallel_region = true;
+
+					while (true)
+					{
+						{
+							std::unique_lock<std::mutex> lock(mutex_);
+							start_cv_.wait(lock, [&] { return stop_ || generation_ != generation; });
+							if (stop_)
+								return;
+							generation = generation_;
+							if (thread_id >= n_threads_)
+								continue;
+						}
+
+						execute(thread_id);
+
+						{
+							std::lock_guard<std::mutex> lock(mutex_);
+							--n_running_;
+						}
+						done_cv_.notify_one();
+					}
+				}
+
+				void execute(const int thread_id)
+				{
+					int start, end;
+					while (!cancelled_ && next_chunk(thread_id, start, end))
+					{
+						try
+						{
+							(*func_)(start, end, thread_id);
+						}
+						catch (...)
+						{
+							std::lock_guard<std::mutex> lock(mutex_);
+							if (!exception_)
+								exception_ = std::current_exception();
+							cancelled_ = true;
+						}
+					}
+				}
+
+				bool next_chunk(const int thread_id, int &start, int &end)
+				{
+					Range &own = ranges_[thread_id];
+					{
+						std::lock_guard<std::mutex> lock(own.mutex);
+						if (own.begin < own.end)
+						{
+							start = own.begin;
+							end = std::min<int>(own.end, own.begin + grain_);
+							own.begin = end;
+							return true;
+						}
+					}
+
+					// steal the back half of the largest remaining range
+					while (true)
+					{
+						int victim = -1, victim_size = 0;
+						for (int t = 0; t < n_threads_; ++t)
+						{
+							const int s = ranges_[t].end - ranges_[t].begin; // estimate, checked under the lock below
+							if (t != thread_id && s > victim_size)
+							{
+								victim = t;
+								victim_size = s;
+							}
+						}
+						if (victim < 0)
+							return false;
+
+						Range &other = ranges_[victim];
+						int stolen_begin, stolen_end;
+						{
+							std::lock_guard<std::mutex> lock(other.mutex);
+							if (other.begin >= other.end)
+								continue;
+							const int mid = other.begin + (other.end - other.begin) / 2;
+							stolen_begin = mid;
+							stolen_end = other.end;
+							other.end = mid;
+						}
+
+						start = stolen_begin;
+						end = std::min(stolen_end, stolen_begin + grain_);
+						std::lock_guard<std::mutex> lock(own.mutex);
+						own.begin = end;
+						own.end = stolen_end;
+						return true;
+					}
+				}
+
+				std::vector<std::thread> workers_;
+
+				std::mutex run_mutex_;
+				std::mutex mutex_;
+				std::condition_variable start_cv_;
+				std::condition_variable done_cv_;
+				size_t generation_ = 0;
+				int n_running_ = 0;
+				bool stop_ = false;
+
+				const std::function<void(int, int, int)> *func_ = nullptr;
+				std::unique_ptr<Range[]> ranges_;
+				int n_threads_ = 0;
+				int grain_ = 1;
+				std::atomic<bool> cancelled_{false};
+				std::exception_ptr exception_;
+			};
+		} // namespace
+#endif
+
+		void par_for(const int size, const std::function<void(int, int, int)> &func)
+		{
+#ifdef POLYFEM_WITH_CPP_THREADS
+			if (size <= 0)
+				return;
+
+			const int n_threads = std::min<size_t>(std::max<size_t>(get_n_threads(), 1), size);
+			if (n_threads == 1 || in_parallel_region || !ThreadPool::get().run(size, func, n_threads))
+				func(0, size, /*thread_id=*/0); // actually the full for loop
 #endif
 		}
 	} // namespace utils
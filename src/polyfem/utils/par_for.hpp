@@ -39,7 +39,7 @@ namespace polyfem
 		private:
 			NThread() {}
 
-			size_t num_threads_;
+			size_t num_threads_ = 1;
 
 #ifdef POLYFEM_WITH_TBB
 			/// limits the number of used threads
@@ -47,6 +47,9 @@ namespace polyfem
 #endif
 		};
 
+		/// Parallel loop over [0, size) on a persistent pool of get_n_threads() threads (the calling thread has id 0).
+		/// func(start, end, thread_id) is called on chunks of the range; threads with no work left steal
+		/// from the others, so the same thread_id can process several chunks. Nested calls run serially.
 		void par_for(const int size, const std::function<void(int, int, int)> &func);
 		inline size_t get_n_threads() { return NThread::get().num_threads(); }
 	} // namespace utils
@@ -1,10 +1,17 @@
 #include <polyfem/State.hpp>
 
+#include <polyfem/assembler/GenericProblem.hpp>
 #include <polyfem/assembler/NeoHookeanElasticity.hpp>
 #include <polyfem/assembler/NeoHookeanElasticityAutodiff.hpp>
+#include <polyfem/assembler/MatrixFreeOperator.hpp>
+#include <polyfem/assembler/MaterialStateBuffer.hpp>
+#include <polyfem/utils/BlockSparseMatrix.hpp>
+#include <polyfem/utils/par_for.hpp>
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <catch2/generators/catch_generators.hpp>
+#include <catch2/benchmark/catch_benchmark.hpp>
 
 #include <iostream>
 
@@ -124,6 +131,551 @@ TEST_CASE("hessian_hooke", "[assembler]")
 	}
 }
 
+namespace
+{
+	std::shared_ptr<State> get_neohookean_state(const int discr_order, const std::string &mesh = "/plane_hole.obj")
+	{
+		const std::string path = POLYFEM_DATA_DIR;
+		json in_args = json({});
+		in_args["geometry"] = {};
+		in_args["geometry"]["mesh"] = path + mesh;
+		in_args["geometry"]["surface_selection"] = 7;
+		in_args["space"]["discr_order"] = discr_order;
+
+		in_args["preset_problem"] = {};
+		in_args["preset_problem"]["type"] = "ElasticExact";
+
+		in_args["materials"] = {};
+		in_args["materials"]["type"] = "NeoHookean";
+		in_args["materials"]["E"] = 1e5;
+		in_args["materials"]["nu"] = 0.3;
+
+		auto state = std::make_shared<State>();
+		state->init_logger("", spdlog::level::err, spdlog::level::off, false);
+		state->init(in_args, true);
+		state->load_mesh();
+		state->build_basis();
+
+		return state;
+	}
+} // namespace
+
+TEST_CASE("hessian_scatter_map", "[assembler]")
+{
+	const auto state_ptr = get_neohookean_state(1);
+	const State &state = *state_ptr;
+
+	SparseMatrixCache mat_cache;
+	ElementScatterMap scatter_map;
+	StiffnessMatrix hessian, scatter_hessian, repeated_hessian;
+	Eigen::MatrixXd disp(state.n_bases * 2, 1);
+	disp.setZero();
+
+	for (int rand = 0; rand < 4; ++rand)
+	{
+		state.assembler->assemble_hessian(false, state.n_bases, false,
+										  state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, Eigen::MatrixXd(), mat_cache, hessian);
+		state.assembler->assemble_hessian(false, state.n_bases, false,
+										  state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, Eigen::MatrixXd(), scatter_map, scatter_hessian);
+
+		REQUIRE(scatter_map.is_valid_for(state.n_bases, 2, state.bases));
+		REQUIRE(scatter_hessian.rows() == hessian.rows());
+		REQUIRE(scatter_hessian.cols() == hessian.cols());
+
+		const StiffnessMatrix tmp = hessian - scatter_hessian;
+		const auto val = Catch::Approx(0).margin(1e-8);
+
+		for (int k = 0; k < tmp.outerSize(); ++k)
+		{
+			for (StiffnessMatrix::InnerIterator it(tmp, k); it; ++it)
+			{
+				REQUIRE(it.value() == val);
+			}
+		}
+
+		// the elements are scattered one color at the time, the sums are bitwise reproducible
+		state.assembler->assemble_hessian(false, state.n_bases, false,
+										  state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, Eigen::MatrixXd(), scatter_map, repeated_hessian);
+		REQUIRE(repeated_hessian.nonZeros() == scatter_hessian.nonZeros());
+		for (int k = 0; k < scatter_hessian.nonZeros(); ++k)
+			REQUIRE(repeated_hessian.valuePtr()[k] == scatter_hessian.valuePtr()[k]);
+
+		disp.setRandom();
+		disp *= 0.01;
+	}
+
+	INFO("scatter map " << scatter_map.memory_size() << " bytes, " << scatter_map.non_zeros() << " non zeros");
+	CHECK(scatter_map.memory_size() > 0);
+}
+
+TEST_CASE("element_coloring", "[assembler]")
+{
+	const auto state_ptr = get_neohookean_state(2);
+	state_ptr->build_element_coloring();
+	const State &state = *state_ptr;
+
+	const auto element_nodes = AssemblerUtils::element_global_nodes(state.bases);
+	REQUIRE(state.element_coloring.n_elements() == state.bases.size());
+	REQUIRE(state.element_coloring.n_colors() > 1);
+	REQUIRE(state.element_coloring.is_valid(element_nodes, state.n_bases));
+
+	Eigen::MatrixXd disp(state.n_bases * 2, 1);
+	disp.setRandom();
+	disp *= 0.01;
+
+	Eigen::MatrixXd grad, colored_grad;
+	state.assembler->assemble_gradient(false, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, grad);
+	state.assembler->assemble_gradient(false, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, state.element_coloring, colored_grad);
+
+	REQUIRE(colored_grad.size() == grad.size());
+	for (int i = 0; i < grad.size(); ++i)
+		REQUIRE(colored_grad(i) == Catch::Approx(grad(i)).margin(1e-8));
+
+	ElementScatterMap atomic_map, colored_map;
+	colored_map.set_element_coloring(&state.element_coloring);
+
+	StiffnessMatrix hessian, colored_hessian;
+	state.assembler->assemble_hessian(false, state.n_bases, false, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, atomic_map, hessian);
+	state.assembler->assemble_hessian(false, state.n_bases, false, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, colored_map, colored_hessian);
+
+	const StiffnessMatrix tmp = hessian - colored_hessian;
+	const auto val = Catch::Approx(0).margin(1e-8);
+	for (int k = 0; k < tmp.outerSize(); ++k)
+	{
+		for (StiffnessMatrix::InnerIterator it(tmp, k); it; ++it)
+		{
+			REQUIRE(it.value() == val);
+		}
+	}
+}
+
+TEST_CASE("element_coloring_benchmark", "[.][benchmark][assembler]")
+{
+	const auto state_ptr = get_neohookean_state(3);
+	state_ptr->build_element_coloring();
+	const State &state = *state_ptr;
+
+	Eigen::MatrixXd disp(state.n_bases * 2, 1);
+	disp.setRandom();
+	disp *= 0.01;
+
+	Eigen::MatrixXd grad;
+	StiffnessMatrix hessian;
+	SparseMatrixCache mat_cache;
+	ElementScatterMap atomic_map, colored_map;
+	colored_map.set_element_coloring(&state.element_coloring);
+
+	// the number of threads is capped to the hardware concurrency
+	for (const int n_threads : {8, 32, 64})
+	{
+		NThread::get().set_num_threads(n_threads);
+		const int actual_threads = NThread::get().num_threads();
+
+		BENCHMARK(fmt::format("gradient thread storage {}/{} threads", actual_threads, n_threads))
+		{
+			state.assembler->assemble_gradient(false, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, grad);
+			return grad.sum();
+		};
+
+		BENCHMARK(fmt::format("gradient coloring {}/{} threads", actual_threads, n_threads))
+		{
+			state.assembler->assemble_gradient(false, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, state.element_coloring, grad);
+			return grad.sum();
+		};
+
+		BENCHMARK(fmt::format("hessian thread storage {}/{} threads", actual_threads, n_threads))
+		{
+			state.assembler->assemble_hessian(false, state.n_bases, false, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, mat_cache, hessian);
+			return hessian.nonZeros();
+		};
+
+		BENCHMARK(fmt::format("hessian scatter atomic {}/{} threads", actual_threads, n_threads))
+		{
+			state.assembler->assemble_hessian(false, state.n_bases, false, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, atomic_map, hessian);
+			return hessian.nonZeros();
+		};
+
+		BENCHMARK(fmt::format("hessian scatter coloring {}/{} threads", actual_threads, n_threads))
+		{
+			state.assembler->assemble_hessian(false, state.n_bases, false, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, colored_map, hessian);
+			return hessian.nonZeros();
+		};
+	}
+
+	NThread::get().set_num_threads(-1);
+}
+
+TEST_CASE("batched_kernels", "[assembler]")
+{
+	const std::string mesh = GENERATE(std::string("/plane_hole.obj"), std::string("/contact/meshes/3D/simple/bar/bar-186.msh"));
+	const int discr_order = GENERATE(1, 2);
+
+	const auto state_ptr = get_neohookean_state(discr_order, mesh);
+	const State &state = *state_ptr;
+	const bool is_volume = state.mesh->is_volume();
+	const int dim = state.mesh->dimension();
+
+	auto nl_assembler = std::dynamic_pointer_cast<NLAssembler>(state.assembler);
+	REQUIRE(nl_assembler != nullptr);
+	REQUIRE(nl_assembler->has_batched_kernels());
+
+	Eigen::MatrixXd disp(state.n_bases * dim, 1);
+	disp.setRandom();
+	disp *= 0.01;
+
+	nl_assembler->set_use_batched_kernels(false);
+	const double energy = nl_assembler->assemble_energy(is_volume, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp);
+	Eigen::MatrixXd grad;
+	nl_assembler->assemble_gradient(is_volume, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, grad);
+
+	nl_assembler->set_use_batched_kernels(true);
+	REQUIRE(nl_assembler->use_batched_kernels());
+	const double batched_energy = nl_assembler->assemble_energy(is_volume, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp);
+	Eigen::MatrixXd batched_grad;
+	nl_assembler->assemble_gradient(is_volume, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, batched_grad);
+	nl_assembler->set_use_batched_kernels(false);
+
+	CHECK(batched_energy == Catch::Approx(energy).epsilon(1e-10));
+	REQUIRE(batched_grad.size() == grad.size());
+	CHECK((batched_grad - grad).norm() <= 1e-10 * std::max(1.0, grad.norm()));
+}
+
+TEST_CASE("material_state_buffer", "[assembler]")
+{
+	const std::string mesh = GENERATE(std::string("/plane_hole.obj"), std::string("/contact/meshes/3D/simple/bar/bar-186.msh"));
+	const int discr_order = GENERATE(1, 2);
+
+	const auto state_ptr = get_neohookean_state(discr_order, mesh);
+	const State &state = *state_ptr;
+	const bool is_volume = state.mesh->is_volume();
+	const int dim = state.mesh->dimension();
+
+	auto nl_assembler = std::dynamic_pointer_cast<NLAssembler>(state.assembler);
+	REQUIRE(nl_assembler != nullptr);
+
+	Eigen::MatrixXd disp(state.n_bases * dim, 1);
+	disp.setRandom();
+	disp *= 0.01;
+
+	const double energy = nl_assembler->assemble_energy(is_volume, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp);
+	Eigen::MatrixXd grad;
+	nl_assembler->assemble_gradient(is_volume, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, grad);
+	SparseMatrixCache mat_cache;
+	StiffnessMatrix hessian;
+	nl_assembler->assemble_hessian(is_volume, state.n_bases, false, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, mat_cache, hessian);
+
+	auto material_state = std::make_shared<MaterialStateBuffer>();
+	nl_assembler->set_material_state(material_state);
+	material_state->update(*nl_assembler, is_volume, state.bases, state.bases, state.ass_vals_cache, 0, disp);
+	REQUIRE(material_state->is_valid(0, disp));
+	REQUIRE(!material_state->is_valid(1, disp));
+	REQUIRE(material_state->params().cols() == 2);
+
+	const double state_energy = nl_assembler->assemble_energy(is_volume, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp);
+	Eigen::MatrixXd state_grad;
+	nl_assembler->assemble_gradient(is_volume, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, state_grad);
+	SparseMatrixCache state_mat_cache;
+	StiffnessMatrix state_hessian;
+	nl_assembler->assemble_hessian(is_volume, state.n_bases, false, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, state_mat_cache, state_hessian);
+
+	// a different solution does not use the stale state
+	Eigen::MatrixXd other_disp = 2 * disp;
+	REQUIRE(!material_state->is_valid(0, other_disp));
+	const double other_energy = nl_assembler->assemble_energy(is_volume, state.bases, state.bases, state.ass_vals_cache, 0, 0, other_disp, other_disp);
+	nl_assembler->set_material_state(nullptr);
+	const double expected_other_energy = nl_assembler->assemble_energy(is_volume, state.bases, state.bases, state.ass_vals_cache, 0, 0, other_disp, other_disp);
+
+	CHECK(state_energy == Catch::Approx(energy).epsilon(1e-10));
+	CHECK(other_energy == Catch::Approx(expected_other_energy).epsilon(1e-10));
+	REQUIRE(state_grad.size() == grad.size());
+	CHECK((state_grad - grad).norm() <= 1e-10 * std::max(1.0, grad.norm()));
+	CHECK((state_hessian - hessian).norm() <= 1e-10 * std::max(1.0, hessian.norm()));
+}
+
+TEST_CASE("batched_kernels_benchmark", "[.][benchmark][assembler]")
+{
+	const std::string mesh = GENERATE(std::string("/plane_hole.obj"), std::string("/contact/meshes/3D/simple/bar/bar-186.msh"));
+
+	const auto state_ptr = get_neohookean_state(1, mesh);
+	const State &state = *state_ptr;
+	const bool is_volume = state.mesh->is_volume();
+
+	auto nl_assembler = std::dynamic_pointer_cast<NLAssembler>(state.assembler);
+	REQUIRE(nl_assembler != nullptr);
+
+	Eigen::MatrixXd disp(state.n_bases * state.mesh->dimension(), 1);
+	disp.setRandom();
+	disp *= 0.01;
+
+	Eigen::MatrixXd grad;
+	for (const bool batched : {false, true})
+	{
+		nl_assembler->set_use_batched_kernels(batched);
+		const std::string name = fmt::format("{} {}", is_volume ? "tets" : "triangles", batched ? "batched" : "per element");
+
+		BENCHMARK("energy " + name)
+		{
+			return nl_assembler->assemble_energy(is_volume, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp);
+		};
+
+		BENCHMARK("gradient " + name)
+		{
+			nl_assembler->assemble_gradient(is_volume, state.n_bases, state.bases, state.bases, state.ass_vals_cache, 0, 0, disp, disp, grad);
+			return grad.sum();
+		};
+	}
+	nl_assembler->set_use_batched_kernels(false);
+}
+
+TEST_CASE("matrix_free_operator", "[assembler]")
+{
+	const std::string material = GENERATE(std::string("Laplacian"), std::string("LinearElasticity"));
+	const int discr_order = GENERATE(1, 3);
+
+	const std::string path = POLYFEM_DATA_DIR;
+	json in_args = json({});
+	in_args["geometry"] = {};
+	in_args["geometry"]["mesh"] = path + "/plane_hole.obj";
+	in_args["geometry"]["surface_selection"] = 7;
+	in_args["space"]["discr_order"] = discr_order;
+	in_args["materials"] = {};
+	in_args["materials"]["type"] = material;
+	if (material == "Laplacian")
+	{
+		in_args["boundary_conditions"]["dirichlet_boundary"] = {{{"id", "all"}, {"value", 0}}};
+	}
+	else
+	{
+		in_args["preset_problem"] = {};
+		in_args["preset_problem"]["type"] = "ElasticExact";
+		in_args["materials"]["E"] = 1e5;
+		in_args["materials"]["nu"] = 0.3;
+	}
+
+	State state;
+	state.init_logger("", spdlog::level::err, spdlog::level::off, false);
+	state.init(in_args, true);
+	state.load_mesh();
+	state.build_basis();
+
+	StiffnessMatrix stiffness;
+	state.build_stiffness_mat(stiffness);
+
+	const auto linear_assembler = std::dynamic_pointer_cast<LinearAssembler>(state.assembler);
+	REQUIRE(linear_assembler != nullptr);
+	const MatrixFreeOperator op(*linear_assembler, state.mesh->is_volume(), state.n_bases, state.bases, state.geom_bases(), state.ass_vals_cache, 0);
+	REQUIRE(op.rows() == stiffness.rows());
+
+	const Eigen::VectorXd x = Eigen::VectorXd::Random(op.rows());
+	Eigen::VectorXd y;
+	op.apply(x, y);
+	const Eigen::VectorXd expected = stiffness * x;
+	CHECK((y - expected).norm() <= 1e-10 * expected.norm());
+
+	const Eigen::VectorXd diag = stiffness.diagonal();
+	CHECK((op.diagonal() - diag).norm() <= 1e-10 * diag.norm());
+
+	// Dirichlet solve, the free rows of the residual vanish and the boundary is set to b
+	Eigen::VectorXd b = Eigen::VectorXd::Random(op.rows());
+	Eigen::VectorXd sol;
+	REQUIRE(op.solve(b, state.boundary_nodes, sol, 1e-12, 10000) > 0);
+
+	Eigen::VectorXd residual = stiffness * sol - b;
+	for (const int i : state.boundary_nodes)
+	{
+		CHECK(sol(i) == b(i));
+		residual(i) = 0;
+	}
+	CHECK(residual.norm() <= 1e-8 * b.norm() * std::max(1.0, stiffness.diagonal().maxCoeff()));
+}
+
+TEST_CASE("block_sparse_assembly", "[assembler]")
+{
+	const std::string mesh = GENERATE(std::string("/plane_hole.obj"), std::string("/contact/meshes/3D/simple/bar/bar-186.msh"));
+	const int discr_order = GENERATE(1, 2);
+
+	const std::string path = POLYFEM_DATA_DIR;
+	json in_args = json({});
+	in_args["geometry"] = {};
+	in_args["geometry"]["mesh"] = path + mesh;
+	in_args["geometry"]["surface_selection"] = 7;
+	in_args["space"]["discr_order"] = discr_order;
+	in_args["preset_problem"] = {};
+	in_args["preset_problem"]["type"] = "ElasticExact";
+	in_args["materials"] = {};
+	in_args["materials"]["type"] = "LinearElasticity";
+	in_args["materials"]["E"] = 1e5;
+	in_args["materials"]["nu"] = 0.3;
+
+	State state;
+	state.init_logger("", spdlog::level::err, spdlog::level::off, false);
+	state.init(in_args, true);
+	state.load_mesh();
+	state.build_basis();
+
+	StiffnessMatrix stiffness;
+	state.build_stiffness_mat(stiffness);
+
+	const auto linear_assembler = std::dynamic_pointer_cast<LinearAssembler>(state.assembler);
+	REQUIRE(linear_assembler != nullptr);
+	BlockSparseMatrix bsr;
+	linear_assembler->assemble(state.mesh->is_volume(), state.n_bases, state.bases, state.geom_bases(), state.ass_vals_cache, 0, bsr);
+	REQUIRE(bsr.rows() == stiffness.rows());
+	REQUIRE(bsr.block_size() == state.mesh->dimension());
+
+	StiffnessMatrix converted;
+	bsr.to_sparse(converted);
+	const double scale = stiffness.diagonal().maxCoeff();
+	CHECK((converted - stiffness).norm() <= 1e-12 * scale);
+
+	// the static kernel of LinearElasticity and the virtual local assemble give the same matrix
+	StiffnessMatrix virtual_stiffness;
+	linear_assembler->LinearAssembler::assemble(state.mesh->is_volume(), state.n_bases, state.bases, state.geom_bases(), state.ass_vals_cache, 0, virtual_stiffness);
+	CHECK((virtual_stiffness - stiffness).norm() <= 1e-14 * scale);
+
+	// one column index per block instead of one per entry
+	const size_t csr_index_bytes = (stiffness.nonZeros() + stiffness.cols() + 1) * sizeof(int);
+	CHECK(bsr.index_bytes() < csr_index_bytes);
+
+	const Eigen::VectorXd x = Eigen::VectorXd::Random(bsr.rows());
+	Eigen::VectorXd y;
+	bsr.multiply(x, y);
+	const Eigen::VectorXd expected = stiffness * x;
+	CHECK((y - expected).norm() <= 1e-10 * expected.norm());
+
+	// Dirichlet solve, the free rows of the residual vanish and the boundary is set to b
+	Eigen::VectorXd b = Eigen::VectorXd::Random(bsr.rows());
+	Eigen::VectorXd sol;
+	REQUIRE(bsr.solve(b, state.boundary_nodes, sol, 1e-12, 10000) > 0);
+
+	Eigen::VectorXd residual = stiffness * sol - b;
+	for (const int i : state.boundary_nodes)
+	{
+		CHECK(sol(i) == b(i));
+		residual(i) = 0;
+	}
+	CHECK(residual.norm() <= 1e-8 * b.norm() * std::max(1.0, scale));
+}
+
+TEST_CASE("reference_assembly_cache", "[assembler]")
+{
+	const std::string mesh = GENERATE(std::string("/plane_hole.obj"), std::string("/contact/meshes/3D/simple/bar/bar-186.msh"));
+	const int discr_order = GENERATE(1, 2);
+	const bool is_mass = GENERATE(false, true);
+
+	const std::string path = POLYFEM_DATA_DIR;
+	json in_args = json({});
+	in_args["geometry"] = {};
+	in_args["geometry"]["mesh"] = path + mesh;
+	in_args["space"]["discr_order"] = discr_order;
+	in_args["materials"] = {};
+	in_args["materials"]["type"] = "Laplacian";
+	in_args["boundary_conditions"]["dirichlet_boundary"] = {{{"id", "all"}, {"value", 0}}};
+	// the reference tables are only used when the full cache does not fit
+	in_args["solver"]["advanced"]["cache_size"] = 0;
+
+	State state;
+	state.init_logger("", spdlog::level::err, spdlog::level::off, false);
+	state.init(in_args, true);
+	state.load_mesh();
+	state.build_basis();
+	REQUIRE(state.ass_vals_cache.uses_reference_tables());
+	REQUIRE(state.mass_ass_vals_cache.uses_reference_tables());
+
+	const bool is_volume = state.mesh->is_volume();
+	const auto &bases = state.bases;
+	const auto &gbases = state.geom_bases();
+
+	AssemblyValsCache full, reference;
+	full.init(is_volume, bases, gbases, is_mass, false);
+	reference.init(is_volume, bases, gbases, is_mass, true);
+	REQUIRE(!full.uses_reference_tables());
+	REQUIRE(reference.uses_reference_tables());
+
+	ElementAssemblyValues tmp_full, tmp_reference;
+	for (int e = 0; e < int(bases.size()); ++e)
+	{
+		const ElementAssemblyValues &expected = full.get(e, is_volume, bases[e], gbases[e], tmp_full);
+		const ElementAssemblyValues &vals = reference.get(e, is_volume, bases[e], gbases[e], tmp_reference);
+
+		REQUIRE(vals.element_id == e);
+		REQUIRE(vals.quadrature.points == expected.quadrature.points);
+		REQUIRE(vals.quadrature.weights == expected.quadrature.weights);
+		CHECK((vals.val - expected.val).norm() < 1e-12);
+		CHECK((vals.det - expected.det).norm() <= 1e-12 * expected.det.norm());
+
+		REQUIRE(vals.jac_it.size() == expected.jac_it.size());
+		for (size_t k = 0; k < vals.jac_it.size(); ++k)
+			CHECK((vals.jac_it[k] - expected.jac_it[k]).norm() <= 1e-12 * expected.jac_it[k].norm());
+
+		REQUIRE(vals.basis_values.size() == expected.basis_values.size());
+		for (size_t j = 0; j < vals.basis_values.size(); ++j)
+		{
+			const AssemblyValues &a = vals.basis_values[j];
+			const AssemblyValues &b = expected.basis_values[j];
+
+			CHECK((a.val - b.val).norm() < 1e-12);
+			CHECK((a.grad - b.grad).norm() < 1e-12);
+			CHECK((a.grad_t_m - b.grad_t_m).norm() <= 1e-12 * std::max(1.0, b.grad_t_m.norm()));
+
+			REQUIRE(a.global.size() == b.global.size());
+			for (size_t i = 0; i < a.global.size(); ++i)
+			{
+				CHECK(a.global[i].index == b.global[i].index);
+				CHECK(a.global[i].val == b.global[i].val);
+			}
+		}
+	}
+}
+
+TEST_CASE("lsq_bc_refit", "[assembler]")
+{
+	const std::string path = POLYFEM_DATA_DIR;
+	json in_args = json({});
+	in_args["geometry"] = {};
+	in_args["geometry"]["mesh"] = path + "/plane_hole.obj";
+	in_args["geometry"]["surface_selection"] = 7;
+	in_args["space"]["discr_order"] = 2;
+	in_args["space"]["advanced"]["bc_method"] = "lsq";
+	in_args["materials"] = {};
+	in_args["materials"]["type"] = "Laplacian";
+	in_args["boundary_conditions"]["dirichlet_boundary"] = {{{"id", 7}, {"value", 1}}};
+
+	State state;
+	state.init_logger("", spdlog::level::err, spdlog::level::off, false);
+	state.init(in_args, true);
+	state.load_mesh();
+	state.build_basis();
+	REQUIRE(!state.boundary_nodes.empty());
+
+	const auto rhs_assembler = state.build_rhs_assembler();
+	const double t = 0.5;
+
+	Eigen::MatrixXd constant_rhs = Eigen::MatrixXd::Zero(state.n_bases, 1);
+	rhs_assembler->set_bc(state.local_boundary, state.boundary_nodes, state.n_boundary_samples(), {}, constant_rhs, Eigen::MatrixXd(), t);
+	for (const int b : state.boundary_nodes)
+		CHECK(constant_rhs(b) == Catch::Approx(1).margin(1e-10));
+
+	// same boundary and same t, different function
+	auto &problem = dynamic_cast<GenericScalarProblem &>(*state.problem);
+	const std::function<double(double, double, double, double)> quadratic = [](double x, double y, double, double) { return x * x + y; };
+	problem.update_dirichlet_boundary(7, quadratic);
+
+	Eigen::MatrixXd refit_rhs = Eigen::MatrixXd::Zero(state.n_bases, 1);
+	rhs_assembler->set_bc(state.local_boundary, state.boundary_nodes, state.n_boundary_samples(), {}, refit_rhs, Eigen::MatrixXd(), t);
+
+	Eigen::MatrixXd expected = Eigen::MatrixXd::Zero(state.n_bases, 1);
+	state.build_rhs_assembler()->set_bc(state.local_boundary, state.boundary_nodes, state.n_boundary_samples(), {}, expected, Eigen::MatrixXd(), t);
+
+	double diff = 0;
+	for (const int b : state.boundary_nodes)
+	{
+		CHECK(refit_rhs(b) == Catch::Approx(expected(b)).margin(1e-10));
+		diff = std::max(diff, std::abs(refit_rhs(b) - constant_rhs(b)));
+	}
+	CHECK(diff > 1e-2);
+}
+
 TEST_CASE("generic_elastic_assembler", "[assembler]")
 {
 
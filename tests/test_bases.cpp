@@ -7,15 +7,19 @@
 #include <polyfem/quadrature/HexQuadrature.hpp>
 
 #include <polyfem/basis/LagrangeBasis3d.hpp>
+#include <polyfem/basis/TensorProductBases.hpp>
 #include <polyfem/autogen/auto_p_bases.hpp>
 #include <polyfem/autogen/auto_q_bases.hpp>
 
 #include <polyfem/basis/barycentric/MVPolygonalBasis2d.hpp>
 #include <polyfem/basis/barycentric/WSPolygonalBasis2d.hpp>
 
+#include <polyfem/utils/Logger.hpp>
+
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
 
+#include <chrono>
 #include <iostream>
 ////////////////////////////////////////////////////////////////////////////////
 
@@ -1047,6 +1051,75 @@ TEST_CASE("Qk_3d", "[bases]")
 	}
 }
 
+TEST_CASE("Qk_3d_tensor", "[bases]")
+{
+	HexQuadrature rule;
+	Quadrature quad;
+	rule.get_quadrature(8, quad);
+
+	for (int k = 1; k <= polyfem::autogen::MAX_Q_BASES; ++k)
+	{
+		const TensorProductBases3d tensor(k);
+
+		std::vector<AssemblyValues> vals;
+		tensor.evaluate_bases(quad.points, vals);
+		tensor.evaluate_grads(quad.points, vals);
+		REQUIRE(int(vals.size()) == tensor.n_bases());
+
+		Eigen::MatrixXd expected;
+		for (int i = 0; i < tensor.n_bases(); ++i)
+		{
+			polyfem::autogen::q_basis_value_3d(k, i, quad.points, expected);
+			REQUIRE(vals[i].val.size() == expected.size());
+			for (int j = 0; j < expected.size(); ++j)
+				REQUIRE(vals[i].val(j) == Catch::Approx(expected(j)).margin(1e-10));
+
+			polyfem::autogen::q_grad_basis_value_3d(k, i, quad.points, expected);
+			REQUIRE(vals[i].grad.rows() == expected.rows());
+			REQUIRE(vals[i].grad.cols() == expected.cols());
+			for (int j = 0; j < expected.size(); ++j)
+				REQUIRE(vals[i].grad(j) == Catch::Approx(expected(j)).margin(1e-10));
+		}
+	}
+}
+
+TEST_CASE("Qk_3d_tensor_benchmark", "[.][benchmark]")
+{
+	HexQuadrature rule;
+	const int n_repeats = 2000;
+
+	for (int k = 1; k <= polyfem::autogen::MAX_Q_BASES; ++k)
+	{
+		Quadrature quad;
+		rule.get_quadrature(2 * k + 1, quad);
+
+		const TensorProductBases3d tensor(k);
+		const int n_bases = tensor.n_bases();
+		std::vector<AssemblyValues> vals(n_bases);
+
+		const auto t0 = std::chrono::steady_clock::now();
+		for (int r = 0; r < n_repeats; ++r)
+		{
+			for (int i = 0; i < n_bases; ++i)
+			{
+				polyfem::autogen::q_basis_value_3d(k, i, quad.points, vals[i].val);
+				polyfem::autogen::q_grad_basis_value_3d(k, i, quad.points, vals[i].grad);
+			}
+		}
+		const auto t1 = std::chrono::steady_clock::now();
+		for (int r = 0; r < n_repeats; ++r)
+		{
+			tensor.evaluate_bases(quad.points, vals);
+			tensor.evaluate_grads(quad.points, vals);
+		}
+		const auto t2 = std::chrono::steady_clock::now();
+
+		const double autogen = std::chrono::duration<double>(t1 - t0).count();
+		const double sum_factorized = std::chrono::duration<double>(t2 - t1).count();
+		logger().info("Q{} with {} points: autogen {}s, sum factorization {}s, speedup {}", k, quad.points.rows(), autogen, sum_factorized, autogen / sum_factorized);
+	}
+}
+
 TEST_CASE("MV_2d", "[bases]")
 {
 	Eigen::MatrixXd b, b_prime, b_dx, b_dy;
@@ -15,6 +15,8 @@
 #include <polyfem/solver/forms/LaggedRegForm.hpp>
 #include <polyfem/solver/forms/RayleighDampingForm.hpp>
 
+#include <polyfem/solver/problems/StaticBoundaryNLProblem.hpp>
+
 #include <polyfem/time_integrator/ImplicitEuler.hpp>
 
 #include <finitediff.hpp>
@@ -22,8 +24,10 @@
 #include <polyfem/State.hpp>
 
 #include <catch2/catch_test_macros.hpp>
+#include <catch2/catch_approx.hpp>
 #include <catch2/generators/catch_generators.hpp>
 
+#include <algorithm>
 #include <iostream>
 #include <memory>
 ////////////////////////////////////////////////////////////////////////////////
@@ -35,7 +39,7 @@ using namespace polyfem::assembler;
 
 namespace
 {
-	std::shared_ptr<State> get_state(int dim)
+	std::shared_ptr<State> get_state(int dim, const std::string &material = "NeoHookean")
 	{
 		const std::string path = POLYFEM_DATA_DIR;
 		json in_args = R"(
@@ -111,6 +115,15 @@ namespace
 				"rhs": [0, 0, 0]
 			})"_json;
 		}
+		if (material == "MooneyRivlin")
+		{
+			in_args["materials"].erase("E");
+			in_args["materials"].erase("nu");
+			in_args["materials"]["c1"] = 400;
+			in_args["materials"]["c2"] = 200;
+			in_args["materials"]["k"] = 2000;
+		}
+		in_args["materials"]["type"] = material;
 
 		auto state = std::make_shared<State>();
 		state->init(in_args, true);
@@ -138,6 +151,17 @@ void test_form(Form &form, const State &state)
 
 	for (int rand = 0; rand < n_rand; ++rand)
 	{
+		// Test the fused value and gradient against the separate ones
+		{
+			Eigen::VectorXd grad, fused_grad;
+			form.first_derivative(x, grad);
+			const double fused_val = form.value_and_first_derivative(x, fused_grad);
+
+			CHECK(std::abs(fused_val - form.value(x)) <= 1e-10 * std::max(1.0, std::abs(fused_val)));
+			REQUIRE(fused_grad.size() == grad.size());
+			CHECK((fused_grad - grad).norm() <= 1e-10 * std::max(1.0, grad.norm()));
+		}
+
 		// Test gradient with finite differences
 		{
 			Eigen::VectorXd grad;
@@ -264,10 +288,72 @@ TEST_CASE("contact form derivatives", "[form][form_derivatives][contact_form]")
 	test_form(form, *state_ptr);
 }
 
+TEST_CASE("contact form candidate reuse", "[form][contact_form]")
+{
+	const auto state_ptr = get_state(2);
+	const State &state = *state_ptr;
+	const int ndof = state.n_bases * state.mesh->dimension();
+
+	// dhat larger than the edges, so the surface has active constraints at rest
+	const Eigen::MatrixXd &rest = state.collision_mesh.rest_positions();
+	const double dhat = 0.1 * (rest.colwise().maxCoeff() - rest.colwise().minCoeff()).norm();
+
+	const auto make_form = [&]() {
+		auto form = std::make_shared<ContactForm>(
+			state.collision_mesh, dhat, state.avg_mass,
+			/*use_convergent_formulation=*/false, /*use_adaptive_barrier_stiffness=*/false,
+			/*is_time_dependent=*/false, /*enable_shape_derivatives=*/false,
+			ipc::BroadPhaseMethod::HASH_GRID, /*ccd_tolerance=*/1e-6, /*ccd_max_iterations=*/int(1e6));
+		form->set_barrier_stiffness(1e3);
+		return form;
+	};
+
+	const auto check_same_as_fresh = [&](const ContactForm &form, const Eigen::VectorXd &x) {
+		const auto fresh = make_form();
+		fresh->init(x);
+		REQUIRE(!fresh->get_constraint_set().empty());
+		CHECK(form.get_constraint_set().size() == fresh->get_constraint_set().size());
+		CHECK(form.value(x) == Catch::Approx(fresh->value(x)).epsilon(1e-10));
+	};
+
+	const auto form = make_form();
+	const double slack = form->candidates_slack();
+
+	const Eigen::VectorXd x0 = Eigen::VectorXd::Zero(ndof);
+	form->init(x0);
+	const Eigen::MatrixXd V0 = form->compute_displaced_surface(x0);
+	REQUIRE(form->candidates_surface() == V0);
+
+	// small displacement: the candidates of x0 are reused and give the same collisions as a fresh broad phase
+	Eigen::VectorXd x1 = Eigen::VectorXd::Random(ndof) * (0.5 * slack / std::sqrt(2.));
+	const Eigen::MatrixXd V1 = form->compute_displaced_surface(x1);
+	REQUIRE((V1 - V0).rowwise().norm().maxCoeff() <= slack);
+	REQUIRE((V1 - V0).norm() > 0);
+
+	form->solution_changed(x1);
+	CHECK(form->candidates_surface() == V0);
+	check_same_as_fresh(*form, x1);
+
+	// displacement larger than the slack: the broad phase is run again
+	Eigen::VectorXd x2 = x1;
+	for (int i = 0; i < ndof; i += 2)
+		x2[i] += 3 * slack;
+	const Eigen::MatrixXd V2 = form->compute_displaced_surface(x2);
+	REQUIRE((V2 - V0).rowwise().norm().maxCoeff() > slack);
+
+	form->solution_changed(x2);
+	CHECK(form->candidates_surface() == V2);
+	check_same_as_fresh(*form, x2);
+}
+
 TEST_CASE("elastic form derivatives", "[form][form_derivatives][elastic_form]")
 {
 	const int dim = GENERATE(2, 3);
-	const auto state_ptr = get_state(dim);
+	// NeoHookean and GenericElastic have their own element loops
+	const std::string material = GENERATE("NeoHookean", "MooneyRivlin");
+	// the nonlinear solve always installs the coloring
+	const bool use_coloring = GENERATE(true, false);
+	const auto state_ptr = get_state(dim, material);
 	ElasticForm form(
 		state_ptr->n_bases,
 		state_ptr->bases,
@@ -277,6 +363,11 @@ TEST_CASE("elastic form derivatives", "[form][form_derivatives][elastic_form]")
 		0,
 		state_ptr->args["time"]["dt"],
 		state_ptr->mesh->is_volume());
+	if (use_coloring)
+	{
+		state_ptr->build_element_coloring();
+		form.set_element_coloring(&state_ptr->element_coloring);
+	}
 	test_form(form, *state_ptr);
 }
 
@@ -503,3 +594,261 @@ TEST_CASE("L2 projection form derivatives", "[form][form_derivatives][L2]")
 
 	test_form(form, *state_ptr);
 }
+
+namespace
+{
+	// quadratic form with a user-defined hessian, used to test the hessian pattern
+	class QuadraticForm : public Form
+	{
+	public:
+		std::string name() const override { return "quadratic"; }
+
+		StiffnessMatrix A;
+
+	protected:
+		double value_unweighted(const Eigen::VectorXd &x) const override { return 0.5 * x.dot(A * x); }
+		void first_derivative_unweighted(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const override { gradv = A * x; }
+		void second_derivative_unweighted(const Eigen::VectorXd &x, StiffnessMatrix &hessian) const override { hessian = A; }
+	};
+
+	StiffnessMatrix random_sparse(const int n, const int nnz_per_col)
+	{
+		std::vector<Eigen::Triplet<double>> entries;
+		for (int i = 0; i < n; ++i)
+		{
+			entries.emplace_back(i, i, 10);
+			for (int k = 0; k < nnz_per_col; ++k)
+			{
+				const int j = rand() % n;
+				entries.emplace_back(i, j, 1);
+				entries.emplace_back(j, i, 1);
+			}
+		}
+		StiffnessMatrix A(n, n);
+		A.setFromTriplets(entries.begin(), entries.end());
+		return A;
+	}
+} // namespace
+
+TEST_CASE("NL problem reduced hessian", "[solver][nl_problem]")
+{
+	const int n = 30;
+	const std::vector<int> boundary_nodes = {0, 7, 29};
+	auto form = std::make_shared<QuadraticForm>();
+	StaticBoundaryNLProblem problem(n, boundary_nodes, Eigen::VectorXd::Zero(n), {form});
+
+	const Eigen::VectorXd x = Eigen::VectorXd::Zero(problem.reduced_size());
+
+	const auto check = [&](const StiffnessMatrix &hessian) {
+		StiffnessMatrix expected;
+		utils::full_to_reduced_matrix(n, problem.reduced_size(), boundary_nodes, form->A, expected);
+		REQUIRE(hessian.rows() == expected.rows());
+		CHECK((Eigen::MatrixXd(hessian) - Eigen::MatrixXd(expected)).norm() == 0);
+	};
+
+	form->A = random_sparse(n, 3);
+	StiffnessMatrix h0;
+	problem.hessian(x, h0);
+	check(h0);
+
+	// a different pattern
+	form->A = random_sparse(n, 5);
+	StiffnessMatrix h1;
+	problem.hessian(x, h1);
+	check(h1);
+
+	// the pattern only depends on the current Hessian
+	StiffnessMatrix diag(n, n);
+	diag.setIdentity();
+	form->A = diag;
+	StiffnessMatrix h2;
+	problem.hessian(x, h2);
+	check(h2);
+	CHECK(h2.nonZeros() == problem.reduced_size());
+}
+
+TEST_CASE("NL problem reduced hessian of several forms", "[solver][nl_problem]")
+{
+	const int n = 40;
+	const std::vector<int> boundary_nodes = {0, 3, 4, 18, 39};
+	auto form0 = std::make_shared<QuadraticForm>();
+	auto form1 = std::make_shared<QuadraticForm>();
+	form0->A = random_sparse(n, 3);
+	form1->A = random_sparse(n, 4);
+	StaticBoundaryNLProblem problem(n, boundary_nodes, Eigen::VectorXd::Zero(n), {form0, form1});
+
+	// old path: sum the full Hessians and reduce with P^T H P, P selects the free variables
+	const int reduced_size = problem.reduced_size();
+	std::vector<Eigen::Triplet<double>> entries;
+	for (int i = 0; i < reduced_size; ++i)
+		entries.emplace_back(problem.reduced_to_full_indices()[i], i, 1);
+	StiffnessMatrix P(n, reduced_size);
+	P.setFromTriplets(entries.begin(), entries.end());
+	const StiffnessMatrix full_hessian = form0->A + form1->A;
+	const StiffnessMatrix expected = P.transpose() * full_hessian * P;
+
+	StiffnessMatrix hessian;
+	problem.hessian(Eigen::VectorXd::Zero(reduced_size), hessian);
+	REQUIRE(hessian.rows() == reduced_size);
+	REQUIRE(hessian.cols() == reduced_size);
+	CHECK((Eigen::MatrixXd(hessian) - Eigen::MatrixXd(expected)).norm() < 1e-12);
+
+	problem.use_full_size();
+	problem.hessian(Eigen::VectorXd::Zero(n), hessian);
+	CHECK((Eigen::MatrixXd(hessian) - Eigen::MatrixXd(full_hessian)).norm() < 1e-12);
+}
+
+TEST_CASE("NL problem fused value and gradient", "[solver][nl_problem]")
+{
+	const int n = 30;
+	const std::vector<int> boundary_nodes = {0, 7, 29};
+	auto form = std::make_shared<QuadraticForm>();
+	form->A = random_sparse(n, 3);
+	StaticBoundaryNLProblem problem(n, boundary_nodes, Eigen::VectorXd::Zero(n), {form});
+
+	Eigen::VectorXd x = Eigen::VectorXd::Random(problem.reduced_size());
+
+	Eigen::VectorXd expected_grad;
+	problem.gradient(x, expected_grad);
+	const double expected_val = problem.value(x);
+
+	Eigen::VectorXd grad;
+	CHECK(problem.value_and_gradient(x, grad) == expected_val);
+	CHECK((grad - expected_grad).norm() == 0);
+
+	// nothing is kept between the calls, a change of the form is seen by the next gradient at the same x
+	form->A *= 2;
+	problem.gradient(x, grad);
+	CHECK((grad - 2 * expected_grad).norm() <= 1e-12 * expected_grad.norm());
+}
+
+TEST_CASE("NL problem reduced and full vectors", "[solver][nl_problem]")
+{
+	const int n = 30;
+	const std::vector<int> boundary_nodes = {0, 7, 8, 29};
+	const Eigen::VectorXd boundary_values = Eigen::VectorXd::Random(n);
+	auto form = std::make_shared<QuadraticForm>();
+	StaticBoundaryNLProblem problem(n, boundary_nodes, boundary_values, {form});
+
+	REQUIRE(problem.reduced_to_full_indices().size() == problem.reduced_size());
+	REQUIRE(problem.full_to_reduced_indices().size() == n);
+
+	const Eigen::VectorXd reduced = Eigen::VectorXd::Random(problem.reduced_size());
+	const Eigen::VectorXd full = problem.reduced_to_full(reduced);
+	REQUIRE(full.size() == n);
+
+	int j = 0;
+	for (int i = 0; i < n; ++i)
+	{
+		if (std::find(boundary_nodes.begin(), boundary_nodes.end(), i) != boundary_nodes.end())
+		{
+			CHECK(full(i) == boundary_values(i));
+			CHECK(problem.full_to_reduced_indices()(i) == -1);
+		}
+		else
+		{
+			CHECK(full(i) == reduced(j));
+			CHECK(problem.reduced_to_full_indices()(j) == i);
+			CHECK(problem.full_to_reduced_indices()(i) == j);
+			++j;
+		}
+	}
+
+	// the in-place versions reuse the storage and agree with the allocating ones
+	Eigen::VectorXd full_buffer = Eigen::VectorXd::Zero(n), reduced_buffer = Eigen::VectorXd::Zero(problem.reduced_size());
+	const double *full_data = full_buffer.data();
+	const double *reduced_data = reduced_buffer.data();
+	problem.reduced_to_full(reduced, full_buffer);
+	problem.full_to_reduced(full, reduced_buffer);
+	CHECK(full_buffer.data() == full_data);
+	CHECK(reduced_buffer.data() == reduced_data);
+	CHECK((full_buffer - full).norm() == 0);
+	CHECK((reduced_buffer - reduced).norm() == 0);
+	CHECK((problem.full_to_reduced(full) - reduced).norm() == 0);
+}
+
+namespace
+{
+	/// x^T x / 2, counts the evaluations of the value
+	class CountingForm : public Form
+	{
+	public:
+		std::string name() const override { return "counting"; }
+
+		mutable int n_evaluations = 0;
+
+	protected:
+		double value_unweighted(const Eigen::VectorXd &x) const override
+		{
+			++n_evaluations;
+			return x.squaredNorm() / 2;
+		}
+		void first_derivative_unweighted(const Eigen::VectorXd &x, Eigen::VectorXd &gradv) const override { gradv = x; }
+		void second_derivative_unweighted(const Eigen::VectorXd &x, StiffnessMatrix &hessian) const override
+		{
+			hessian.resize(x.size(), x.size());
+			hessian.setIdentity();
+		}
+	};
+} // namespace
+
+TEST_CASE("form value memo", "[form]")
+{
+	const Eigen::VectorXd x = Eigen::VectorXd::Random(10);
+	const Eigen::VectorXd y = Eigen::VectorXd::Random(10);
+
+	auto f = std::make_shared<CountingForm>();
+	auto g = std::make_shared<CountingForm>();
+	g->set_weight(3);
+
+	// disabled by default, the value is always computed
+	f->value(x);
+	CHECK(f->memoized_value(x) == x.squaredNorm() / 2);
+	CHECK(f->n_evaluations == 2);
+	f->n_evaluations = 0;
+
+	FullNLProblem problem({f, g});
+	problem.enable_value_memos(true);
+
+	// nothing memoized yet
+	CHECK(f->memoized_value(x) == x.squaredNorm() / 2);
+	CHECK(f->n_evaluations == 1);
+
+	// same x, the weight is applied to the memoized value
+	f->set_weight(2);
+	CHECK(f->memoized_value(x) == x.squaredNorm());
+	CHECK(f->n_evaluations == 1);
+
+	// the memo follows the last value computed by the solver
+	f->value(y);
+	CHECK(f->n_evaluations == 2);
+	CHECK(f->memoized_value(y) == y.squaredNorm());
+	CHECK(f->n_evaluations == 2);
+	CHECK(f->memoized_value(x) == x.squaredNorm());
+	CHECK(f->n_evaluations == 3);
+
+	// the solution is compared exactly, not through a hash
+	Eigen::VectorXd x_close = x;
+	x_close(3) = std::nextafter(x_close(3), 2.0);
+	CHECK(f->memoized_value(x_close) == x_close.squaredNorm());
+	CHECK(f->n_evaluations == 4);
+
+	f->clear_value_memo();
+	f->memoized_value(x);
+	CHECK(f->n_evaluations == 5);
+
+	g->value(x);
+	CHECK(problem.memoized_value(x) == 5 * x.squaredNorm() / 2);
+	CHECK(f->n_evaluations == 5);
+	CHECK(g->n_evaluations == 1);
+
+	// changing the forms drops the memos
+	problem.init(x);
+	problem.memoized_value(x);
+	CHECK(f->n_evaluations == 6);
+	CHECK(g->n_evaluations == 2);
+
+	g->disable();
+	CHECK(problem.memoized_value(x) == x.squaredNorm());
+	CHECK(g->n_evaluations == 2);
+}
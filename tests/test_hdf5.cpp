@@ -1,9 +1,15 @@
 #include <catch2/catch_test_macros.hpp>
 
+#include <polyfem/io/HDF5TimeSeriesWriter.hpp>
+
 #include <nlohmann/json.hpp>
 
 #include <h5pp/h5pp.h>
 
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
 TEST_CASE("HDF5", "[hdf5]")
 {
 	using MatrixXl = Eigen::Matrix<int64_t, Eigen::Dynamic, Eigen::Dynamic>;
@@ -28,4 +34,62 @@ TEST_CASE("HDF5", "[hdf5]")
 		cells[i] = file.readDataset<MatrixXl>("/meshes/" + name + "/c").cast<int>();
 		vertices[i] = file.readDataset<Eigen::MatrixXd>("/meshes/" + name + "/v");
 	}
-}
\ No newline at end of file
+}
+
+TEST_CASE("hdf5_time_series", "[hdf5]")
+{
+	using RowMatrixXd = Eigen::Matrix<double, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+	const std::filesystem::path dir = std::filesystem::temp_directory_path();
+	const std::string hdf5_path = (dir / "polyfem_test_series.hdf5").string();
+	const std::string xdmf_path = (dir / "polyfem_test_series.xdmf").string();
+
+	Eigen::MatrixXd V(4, 2);
+	V << 0, 0, 1, 0, 0, 1, 1, 1;
+	Eigen::MatrixXi F(2, 3);
+	F << 0, 1, 2, 1, 3, 2;
+
+	{
+		polyfem::io::HDF5TimeSeriesWriter writer(hdf5_path, xdmf_path, 4);
+		writer.write_mesh("volume", V, F);
+
+		for (int t = 0; t < 3; ++t)
+		{
+			std::map<std::string, std::vector<polyfem::io::HDF5TimeSeriesWriter::NamedMatrix>> fields;
+			fields["volume"].emplace_back("scalar", Eigen::MatrixXd::Constant(V.rows(), 1, t));
+			fields["volume"].emplace_back("solution", Eigen::MatrixXd::Constant(V.rows(), 2, t));
+			writer.write_step(t, 0.1 * t, fields);
+		}
+		CHECK(writer.n_steps() == 3);
+	}
+
+	h5pp::File file(hdf5_path, h5pp::FileAccess::READONLY);
+	const RowMatrixXd geometry = file.readDataset<RowMatrixXd>("/meshes/volume_0/geometry");
+	REQUIRE(geometry.rows() == V.rows());
+	REQUIRE(geometry.cols() == 3);
+	CHECK(geometry.leftCols(2) == V);
+	CHECK(geometry.col(2).isZero());
+
+	// 2D vectors are padded to 3D
+	const RowMatrixXd solution = file.readDataset<RowMatrixXd>("/steps/2/volume/solution");
+	REQUIRE(solution.cols() == 3);
+	CHECK(solution.leftCols(2).isConstant(2));
+	CHECK(solution.col(2).isZero());
+
+	std::ifstream in(xdmf_path);
+	std::stringstream ss;
+	ss << in.rdbuf();
+	const std::string xdmf = ss.str();
+
+	int n_steps = 0;
+	for (size_t pos = xdmf.find("<Time Value="); pos != std::string::npos; pos = xdmf.find("<Time Value=", pos + 1))
+		++n_steps;
+	CHECK(n_steps == 3);
+	CHECK(xdmf.find("polyfem_test_series.hdf5:/steps/1/volume/scalar") != std::string::npos);
+	const std::string footer = "</Grid>\n</Domain>\n</Xdmf>\n";
+	REQUIRE(xdmf.size() >= footer.size());
+	CHECK(xdmf.substr(xdmf.size() - footer.size()) == footer);
+
+	std::filesystem::remove(hdf5_path);
+	std::filesystem::remove(xdmf_path);
+}
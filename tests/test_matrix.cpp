@@ -1,16 +1,20 @@
 ////////////////////////////////////////////////////////////////////////////////
+#include <polyfem/utils/BlockSparseMatrix.hpp>
 #include <polyfem/utils/MatrixCache.hpp>
 #include <polyfem/utils/MatrixUtils.hpp>
 #include <polyfem/autogen/auto_eigs.hpp>
 #include <polyfem/utils/AutodiffTypes.hpp>
 
-#include <iostream>
+#include <array>
 #include <cmath>
+#include <cstdlib>
+#include <iostream>
 
 #include <Eigen/Dense>
 
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <catch2/generators/catch_generators.hpp>
 ////////////////////////////////////////////////////////////////////////////////
 
 using namespace polyfem;
@@ -247,3 +251,65 @@ TEST_CASE("cache", "[matrix]")
 	REQUIRE(tmp2.coeff(9, 4) == 6);
 	REQUIRE(tmp2.coeff(9, 9) == 4);
 }
+
+TEST_CASE("block_sparse_matrix", "[matrix]")
+{
+	const int block_size = GENERATE(1, 2, 3);
+	const int n_blocks = 20;
+	const int n = n_blocks * block_size;
+
+	// random pattern with duplicated entries
+	std::vector<Eigen::Triplet<double>> triplets;
+	for (int k = 0; k < 200; ++k)
+		triplets.emplace_back(std::rand() % n, std::rand() % n, double(std::rand()) / RAND_MAX);
+	for (int i = 0; i < n; ++i)
+		triplets.emplace_back(i, i, 10);
+	StiffnessMatrix mat(n, n);
+	mat.setFromTriplets(triplets.begin(), triplets.end());
+
+	BlockSparseMatrix bsr;
+	bsr.set_from_sparse(mat, block_size);
+	REQUIRE(bsr.rows() == n);
+	REQUIRE(bsr.block_size() == block_size);
+	CHECK(bsr.non_zeros() >= size_t(mat.nonZeros()));
+	CHECK(bsr.non_zero_blocks() * block_size * block_size == bsr.non_zeros());
+
+	StiffnessMatrix back;
+	bsr.to_sparse(back);
+	CHECK((Eigen::MatrixXd(back) - Eigen::MatrixXd(mat)).norm() == 0);
+
+	const Eigen::VectorXd x = Eigen::VectorXd::Random(n);
+	Eigen::VectorXd y;
+	bsr.multiply(x, y);
+	const Eigen::VectorXd expected = mat * x;
+	CHECK((y - expected).norm() <= 1e-12 * expected.norm());
+
+	const Eigen::MatrixXd diag = bsr.diagonal_blocks();
+	for (int r = 0; r < n_blocks; ++r)
+		CHECK((diag.middleRows(r * block_size, block_size) - Eigen::MatrixXd(mat).block(r * block_size, r * block_size, block_size, block_size)).norm() == 0);
+
+	// same values through the block cache, added in blocks, single values, and from two caches
+	BlockSparseMatrixCache cache(n, block_size), other(n, block_size);
+	SparseMatrixCache expected_cache(n);
+	for (int k = 0; k < 50; ++k)
+	{
+		const int bi = std::rand() % n_blocks;
+		const int bj = std::rand() % n_blocks;
+		std::array<double, 9> block;
+		for (int i = 0; i < block_size * block_size; ++i)
+			block[i] = double(std::rand()) / RAND_MAX;
+
+		(k % 2 ? cache : other).add_block(0, bi, bj, block_size, block.data());
+		expected_cache.add_block(0, bi, bj, block_size, block.data());
+		if (k == 25)
+			cache.prune();
+	}
+	cache.add_value(0, 0, n - 1, 1);
+	expected_cache.add_value(0, 0, n - 1, 1);
+	cache += other;
+
+	const StiffnessMatrix cached = cache.get_matrix();
+	const StiffnessMatrix expected_cached = expected_cache.get_matrix();
+	CHECK((Eigen::MatrixXd(cached) - Eigen::MatrixXd(expected_cached)).norm() <= 1e-12);
+	CHECK(cache.block_matrix().index_bytes() <= (cache.block_matrix().non_zero_blocks() + n_blocks + 1) * sizeof(int));
+}
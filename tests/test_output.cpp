@@ -4,10 +4,19 @@
 
 #include <polyfem/State.hpp>
 #include <polyfem/Common.hpp>
+#include <polyfem/io/AsyncWriter.hpp>
+#include <polyfem/io/Evaluator.hpp>
+#include <polyfem/io/PVDAppender.hpp>
+#include <polyfem/io/Snapshot.hpp>
 #include <polyfem/utils/JSONUtils.hpp>
+#include <polyfem/utils/MatrixUtils.hpp>
+#include <polyfem/utils/RefElementSampler.hpp>
 
+#include <atomic>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <sstream>
 ////////////////////////////////////////////////////////////////////////////////
 
 using namespace polyfem;
@@ -82,3 +91,181 @@ TEST_CASE("full sim", "[.][full_sim]")
 
 	std::filesystem::remove_all(outdir);
 }
+
+TEST_CASE("vis_interpolation_matrix", "[output]")
+{
+	const std::string path = POLYFEM_DATA_DIR;
+	json in_args = json({});
+	in_args["geometry"] = {};
+	in_args["geometry"]["mesh"] = path + "/plane_hole.obj";
+	in_args["space"]["discr_order"] = GENERATE(1, 2);
+	in_args["materials"] = {};
+	in_args["materials"]["type"] = "LinearElasticity";
+	in_args["materials"]["E"] = 1e5;
+	in_args["materials"]["nu"] = 0.3;
+
+	State state;
+	state.init_logger("", spdlog::level::err, spdlog::level::off, false);
+	state.init(in_args, true);
+	state.load_mesh();
+	state.build_basis();
+	REQUIRE(state.mesh->is_simplicial());
+
+	RefElementSampler sampler;
+	sampler.init(state.mesh->is_volume(), state.mesh->n_elements(), 0.1);
+	const int n_points = state.mesh->n_elements() * sampler.simplex_points().rows();
+	const int dim = state.mesh->dimension();
+
+	StiffnessMatrix interpolation;
+	io::Evaluator::interpolation_matrix(
+		*state.mesh, state.n_bases, state.bases, state.disc_orders, state.polys, state.polys_3d,
+		sampler, n_points, /*use_sampler=*/true, /*boundary_only=*/false, interpolation);
+	REQUIRE(interpolation.rows() == n_points);
+	REQUIRE(interpolation.cols() == state.n_bases);
+
+	const Eigen::MatrixXd sol = Eigen::VectorXd::Random(state.n_bases * dim);
+	Eigen::MatrixXd expected;
+	io::Evaluator::interpolate_function(
+		*state.mesh, dim, state.bases, state.disc_orders, state.polys, state.polys_3d,
+		sampler, n_points, sol, expected, /*use_sampler=*/true, /*boundary_only=*/false);
+
+	const Eigen::MatrixXd nodal = utils::unflatten(sol, dim);
+	const Eigen::MatrixXd actual = interpolation * nodal;
+	CHECK((actual - expected).norm() <= 1e-12 * std::max(1.0, expected.norm()));
+}
+
+TEST_CASE("async_writer", "[output]")
+{
+	const int n_threads = GENERATE(0, 1, 3);
+	const int n_tasks = 50;
+
+	std::atomic<int> done(0);
+	std::vector<int> written(n_tasks, 0);
+	{
+		io::AsyncWriter writer(n_threads, 2);
+		REQUIRE(writer.n_threads() == n_threads);
+
+		for (int i = 0; i < n_tasks; ++i)
+		{
+			writer.submit([i, &done, &written]() {
+				written[i] = i + 1;
+				++done;
+			});
+		}
+		writer.flush();
+		CHECK(done == n_tasks);
+
+		// the destructor waits for the tasks submitted after the flush
+		writer.submit([&done]() { ++done; });
+	}
+	CHECK(done == n_tasks + 1);
+
+	for (int i = 0; i < n_tasks; ++i)
+		CHECK(written[i] == i + 1);
+}
+
+TEST_CASE("pvd_appender", "[output]")
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "polyfem_test_pvd_appender.pvd").string();
+
+	const auto read = [&path]() {
+		std::ifstream in(path);
+		std::stringstream ss;
+		ss << in.rdbuf();
+		return ss.str();
+	};
+
+	const std::string header = "<?xml version=\"1.0\"?>\n"
+							   "<VTKFile type=\"Collection\" version=\"0.1\" byte_order=\"LittleEndian\" compressor=\"vtkZLibDataCompressor\">\n"
+							   "<Collection>\n";
+	const std::string footer = "</Collection>\n</VTKFile>\n";
+
+	io::PVDAppender pvd;
+	pvd.open(path);
+	REQUIRE(pvd.is_open());
+	CHECK(read() == header + footer);
+
+	pvd.append(0, "step_0.vtm");
+	pvd.append(0.5, "step_1.vtm");
+	CHECK(read() == header
+						+ "<DataSet timestep=\"0\" group=\"\" part=\"0\" file=\"step_0.vtm\"/>\n"
+						+ "<DataSet timestep=\"0.5\" group=\"\" part=\"0\" file=\"step_1.vtm\"/>\n"
+						+ footer);
+
+	// reopening starts a new series
+	pvd.open(path);
+	pvd.append(1, "step_2.vtm");
+	pvd.close();
+	CHECK(read() == header + "<DataSet timestep=\"1\" group=\"\" part=\"0\" file=\"step_2.vtm\"/>\n" + footer);
+
+	// a second simulation with the same name (e.g., solve_problem called again) restarts the series
+	io::OutGeometryData out_geom;
+	const auto names = [](int i) { return fmt::format("step_{}.vtm", i); };
+	for (int run = 0; run < 2; ++run)
+		for (int t = 0; t < 3; ++t)
+			out_geom.append_pvd(path, names, t, 0, 0.5);
+	out_geom.close_time_sequence();
+
+	const std::string content = read();
+	size_t n_datasets = 0;
+	for (size_t pos = content.find("<DataSet"); pos != std::string::npos; pos = content.find("<DataSet", pos + 1))
+		++n_datasets;
+	CHECK(n_datasets == 3);
+
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("snapshot", "[output]")
+{
+	const std::string path = (std::filesystem::temp_directory_path() / "polyfem_test_snapshot.bin").string();
+
+	const Eigen::MatrixXd dense = Eigen::MatrixXd::Random(7, 3);
+	const Eigen::MatrixXi ints = (Eigen::MatrixXi(2, 3) << 1, -2, 3, 4, 5, -6).finished();
+
+	std::vector<Eigen::Triplet<double>> triplets = {{0, 0, 2}, {1, 0, -1}, {3, 1, 4}, {2, 3, 1.5}, {3, 3, 7}};
+	StiffnessMatrix sparse(4, 5);
+	sparse.setFromTriplets(triplets.begin(), triplets.end());
+
+	{
+		io::SnapshotWriter writer;
+		writer.add("dense", dense);
+		writer.add("ints", ints);
+		writer.add("sparse", sparse);
+		writer.add("empty", Eigen::MatrixXd(0, 2));
+		writer.write(path);
+	}
+
+	{
+		io::SnapshotReader reader(path);
+		CHECK(reader.has("dense"));
+		CHECK(!reader.has("missing"));
+
+		// the arrays are aligned in the file, the maps can be used by the vectorized kernels
+		CHECK(reinterpret_cast<std::uintptr_t>(reader.matrix("dense").data()) % 64 == 0);
+
+		CHECK(Eigen::MatrixXd(reader.matrix("dense")) == dense);
+		CHECK(Eigen::MatrixXi(reader.int_matrix("ints")) == ints);
+		CHECK(reader.matrix("empty").rows() == 0);
+		CHECK(reader.matrix("empty").cols() == 2);
+
+		const StiffnessMatrix loaded = reader.sparse("sparse");
+		CHECK(loaded.rows() == sparse.rows());
+		CHECK(loaded.cols() == sparse.cols());
+		CHECK(loaded.nonZeros() == sparse.nonZeros());
+		CHECK(Eigen::MatrixXd(loaded) == Eigen::MatrixXd(sparse));
+
+		CHECK_THROWS(reader.int_matrix("dense"));
+		CHECK_THROWS(reader.matrix("missing"));
+	}
+
+	// other versions are rejected
+	{
+		std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(12);
+		const uint32_t version = io::SnapshotReader::VERSION + 1;
+		file.write(reinterpret_cast<const char *>(&version), sizeof(version));
+	}
+	CHECK_THROWS(io::SnapshotReader(path));
+
+	std::filesystem::remove(path);
+}
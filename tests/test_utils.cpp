@@ -3,9 +3,14 @@
 #include <polyfem/utils/RBFInterpolation.hpp>
 #include <polyfem/utils/Bessel.hpp>
 #include <polyfem/utils/ExpressionValue.hpp>
+#include <polyfem/utils/ExpressionTree.hpp>
+#include <polyfem/utils/ElementArena.hpp>
 #include <polyfem/io/MshReader.hpp>
 #include <polyfem/mesh/Mesh.hpp>
 #include <polyfem/utils/MatrixUtils.hpp>
+#include <polyfem/utils/MaybeParallelFor.hpp>
+#include <polyfem/utils/par_for.hpp>
+#include <polyfem/utils/Timer.hpp>
 
 #ifdef POLYFEM_WITH_REMESHING
 #include <wmtk/TriMesh.h>
@@ -13,8 +18,15 @@
 
 #include <Eigen/Dense>
 
+#include <tinyexpr.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/catch_approx.hpp>
+#include <catch2/generators/catch_generators.hpp>
 ////////////////////////////////////////////////////////////////////////////////
 
 using namespace polyfem;
@@ -107,6 +119,92 @@ TEST_CASE("expression", "[utils]")
 	REQUIRE(expr(2, 3, 4) == Catch::Approx(2. * 2. + sqrt(2. * 3.) + sin(4.) * 2.).margin(1e-10));
 	REQUIRE(expr2d(2, 3) == Catch::Approx(2. * 2. + sqrt(2. * 3.)).margin(1e-10));
 	REQUIRE(val(2, 3, 4) == Catch::Approx(1).margin(1e-16));
+
+	Eigen::MatrixXd pts(5, 3);
+	pts.setRandom();
+	pts.array() += 1;
+
+	Eigen::VectorXd res;
+	expr.evaluate(pts, 0, res);
+	REQUIRE(res.size() == pts.rows());
+	for (int i = 0; i < pts.rows(); ++i)
+		REQUIRE(res(i) == Catch::Approx(expr(pts(i, 0), pts(i, 1), pts(i, 2))).margin(1e-12));
+
+	val.evaluate(pts, 0, res);
+	REQUIRE((res.array() - 1).abs().maxCoeff() == Catch::Approx(0).margin(1e-16));
+
+	// copies share the compiled expression
+	utils::ExpressionValue tdep;
+	tdep.init(std::string("if(t - 1, x * t, max(y, z))"));
+	tdep.set_unit_type("");
+	const utils::ExpressionValue tdep_copy = tdep;
+	for (const double t : {0., 2.})
+	{
+		tdep_copy.evaluate(pts, t, res);
+		for (int i = 0; i < pts.rows(); ++i)
+		{
+			const double expected = t >= 1 ? pts(i, 0) * t : std::max(pts(i, 1), pts(i, 2));
+			REQUIRE(res(i) == Catch::Approx(expected).margin(1e-12));
+			REQUIRE(tdep(pts(i, 0), pts(i, 1), pts(i, 2), t) == Catch::Approx(expected).margin(1e-12));
+		}
+	}
+}
+
+namespace
+{
+	double sum5(double a, double b, double c, double d, double e) { return a + 2 * b + 3 * c + 4 * d + 5 * e; }
+	double sum7(double a, double b, double c, double d, double e, double f, double g) { return a - b + c - d + e - f + g; }
+	double scaled0(void *context) { return *static_cast<const double *>(context); }
+	double scaled2(void *context, double a, double b) { return *static_cast<const double *>(context) * (a - b); }
+	double scaled6(void *context, double a, double b, double c, double d, double e, double f)
+	{
+		return *static_cast<const double *>(context) * (a * b + c * d + e * f);
+	}
+} // namespace
+
+TEST_CASE("expression_tree", "[utils]")
+{
+	// the walker must agree with te_eval on every node type, including the ones no builtin uses
+	double x = 0, y = 0, z = 0, t = 0;
+	double scale = 1.5;
+	const te_variable vars[] = {
+		{"x", &x, TE_VARIABLE, nullptr},
+		{"y", &y, TE_VARIABLE, nullptr},
+		{"z", &z, TE_VARIABLE, nullptr},
+		{"t", &t, TE_VARIABLE, nullptr},
+		{"sum5", (const void *)sum5, TE_FUNCTION5, nullptr},
+		{"sum7", (const void *)sum7, TE_FUNCTION7, nullptr},
+		{"scaled0", (const void *)scaled0, TE_CLOSURE0, &scale},
+		{"scaled2", (const void *)scaled2, TE_CLOSURE2, &scale},
+		{"scaled6", (const void *)scaled6, TE_CLOSURE6, &scale},
+	};
+
+	int err = 0;
+	te_expr *expr = te_compile(
+		"sum5(x, y, z, t, 1) + sum7(x, y, z, t, x*y, y*z, 2) + scaled0 + scaled2(x, t) + scaled6(x, y, z, t, sin(x), cos(y))",
+		vars, int(sizeof(vars) / sizeof(te_variable)), &err);
+	REQUIRE(expr != nullptr);
+	REQUIRE(err == 0);
+
+	Eigen::MatrixXd pts(10, 4);
+	pts.setRandom();
+	for (int i = 0; i < pts.rows(); ++i)
+	{
+		x = pts(i, 0);
+		y = pts(i, 1);
+		z = pts(i, 2);
+		t = pts(i, 3);
+		const double expected = te_eval(expr);
+
+		const double value = utils::eval_expression_tree(expr, {{&x, &y, &z, &t}}, {{pts(i, 0), pts(i, 1), pts(i, 2), pts(i, 3)}});
+		CHECK(value == Catch::Approx(expected).margin(1e-12));
+
+		// the bound variables are not read
+		x = y = z = t = std::nan("");
+		CHECK(utils::eval_expression_tree(expr, {{&x, &y, &z, &t}}, {{pts(i, 0), pts(i, 1), pts(i, 2), pts(i, 3)}}) == Catch::Approx(expected).margin(1e-12));
+	}
+
+	te_free(expr);
 }
 
 TEST_CASE("mshreader", "[utils]")
@@ -132,6 +230,203 @@ TEST_CASE("inverse", "[utils]")
 	REQUIRE(((utils::inverse(mat3) - mat3_inv)).norm() == Catch::Approx(0).margin(1e-12));
 }
 
+TEST_CASE("profiler", "[utils]")
+{
+	Profiler &profiler = Profiler::get();
+	profiler.clear();
+
+	{
+		POLYFEM_SCOPED_TIMER("disabled");
+	}
+	CHECK(profiler.events().empty());
+
+	profiler.enable(true);
+	for (int i = 0; i < 3; ++i)
+	{
+		POLYFEM_SCOPED_TIMER("outer");
+		{
+			POLYFEM_PROFILE_SCOPE([&] { return std::string("inner"); });
+		}
+	}
+	{
+		Timer timer;
+		timer.stop();
+	}
+	profiler.enable(false);
+
+	const auto events = profiler.events();
+	REQUIRE(events.size() == 6);
+	CHECK(events[0].path == "outer/inner");
+	CHECK(events[0].depth == 1);
+	CHECK(events[1].path == "outer");
+	CHECK(events[1].depth == 0);
+	CHECK(events[1].duration >= events[0].duration);
+
+	const json summary = profiler.summary();
+	REQUIRE(summary["scopes"].size() == 2);
+	CHECK(summary["scopes"]["outer"]["count"] == 3);
+	CHECK(summary["scopes"]["outer/inner"]["count"] == 3);
+	CHECK(summary["threads"].size() == 1);
+
+	if (Profiler::tracks_allocations())
+	{
+		profiler.clear();
+		profiler.enable(true);
+		{
+			POLYFEM_PROFILE_SCOPE([&] { return std::string("allocation"); });
+			std::vector<char> buffer(1024);
+			CHECK(buffer.size() == 1024);
+		}
+		profiler.enable(false);
+
+		REQUIRE(profiler.events().size() == 1);
+		CHECK(profiler.events()[0].bytes >= 1024);
+		CHECK(profiler.summary()["scopes"]["allocation"]["bytes"] >= 1024);
+	}
+
+	profiler.clear();
+	CHECK(profiler.events().empty());
+}
+
+namespace
+{
+	// element of very uneven cost, e.g. a few high order or polygonal elements among P1 ones
+	double uneven_work(const int i, const int size)
+	{
+		const int n = (i % 10 == 0 || i < size / 20) ? 20000 : 200;
+		double val = 0;
+		for (int k = 0; k < n; ++k)
+			val += std::sin(k * 1e-3 + i);
+		return val;
+	}
+} // namespace
+
+TEST_CASE("parallel_for", "[utils]")
+{
+	const int n_threads = GENERATE(1, 2, 8);
+	NThread::get().set_num_threads(n_threads);
+
+	for (const int size : {0, 1, 3, 17, 1000, 100000})
+	{
+		std::vector<std::atomic<int>> visited(size);
+		std::atomic<int> bad_thread_ids = 0;
+		maybe_parallel_for(size, [&](int start, int end, int thread_id) {
+			if (thread_id < 0 || thread_id >= int(get_n_threads()))
+				++bad_thread_ids;
+			for (int i = start; i < end; ++i)
+				++visited[i];
+		});
+#if defined(POLYFEM_WITH_CPP_THREADS)
+		CHECK(bad_thread_ids == 0);
+#endif
+		for (const auto &v : visited)
+			REQUIRE(v == 1);
+
+		// single index overload with nested loops
+		std::vector<std::atomic<int>> nested(size);
+		maybe_parallel_for(size, [&](int i) {
+			maybe_parallel_for(3, [&](int j) { ++nested[i]; });
+		});
+		for (const auto &v : nested)
+			REQUIRE(v == 3);
+	}
+
+	// uneven elements, the result must not depend on the scheduling
+	const int size = 2000;
+	std::vector<double> result(size);
+	maybe_parallel_for(size, [&](int i) { result[i] = uneven_work(i, size); });
+	for (int i = 0; i < size; i += 97)
+		CHECK(result[i] == uneven_work(i, size));
+
+	// templated loops and reductions
+	std::vector<std::atomic<int>> visited(size);
+	parallel_for_each_element(size, [&](int e, int thread_id) { ++visited[e]; });
+	for (const auto &v : visited)
+		REQUIRE(v == 1);
+
+	const double sum = parallel_reduce_sum(size, 0, [&](int e, int &scratch) { return double(e); });
+	CHECK(sum == double(size) * (size - 1) / 2);
+
+	Eigen::MatrixXd histogram;
+	parallel_reduce_vector(
+		size, 7, 0, [&](int e, int &scratch, Eigen::MatrixXd &local) { local(e % 7) += 1; }, histogram);
+	REQUIRE(histogram.size() == 7);
+	CHECK(histogram.sum() == size);
+	CHECK(histogram(0) == (size + 6) / 7);
+
+	CHECK_THROWS(maybe_parallel_for(1000, [&](int i) {
+		if (i == 500)
+			throw std::runtime_error("error in parallel loop");
+	}));
+
+	NThread::get().set_num_threads(-1);
+}
+
+TEST_CASE("parallel_for_benchmark", "[.][benchmark]")
+{
+	// compare with a build using POLYFEM_THREADING=TBB, the timings should be similar
+	NThread::get().set_num_threads(-1);
+	const int size = 20000;
+
+	std::vector<double> result(size);
+	const auto t0 = std::chrono::steady_clock::now();
+	for (int i = 0; i < size; ++i)
+		result[i] = uneven_work(i, size);
+	const auto t1 = std::chrono::steady_clock::now();
+	maybe_parallel_for(size, [&](int start, int end, int thread_id) {
+		for (int i = start; i < end; ++i)
+			result[i] = uneven_work(i, size);
+	});
+	const auto t2 = std::chrono::steady_clock::now();
+
+	const double serial = std::chrono::duration<double>(t1 - t0).count();
+	const double parallel = std::chrono::duration<double>(t2 - t1).count();
+	logger().info("uneven loop with {} threads: serial {}s, parallel {}s, speedup {}", get_n_threads(), serial, parallel, serial / parallel);
+}
+
+TEST_CASE("element_arena", "[utils]")
+{
+	ElementArena arena(16);
+	REQUIRE(arena.capacity() == 16);
+
+	{
+		const ElementArena::Scope scope(arena);
+		ElementArena::VectorMap a = arena.vector(3);
+		ElementArena::MatrixMap b = arena.matrix(2, 3);
+		CHECK(reinterpret_cast<std::uintptr_t>(a.data()) % 16 == 0);
+		CHECK(reinterpret_cast<std::uintptr_t>(b.data()) % 16 == 0);
+		CHECK(b.data() >= a.data() + 3);
+
+		a.setConstant(1);
+		b.setConstant(2);
+		CHECK(a.sum() == 3);
+		CHECK(b.sum() == 12);
+
+		{
+			const ElementArena::Scope inner(arena);
+			const size_t used = arena.used();
+			arena.vector(5).setZero();
+			CHECK(arena.used() > used);
+		}
+		CHECK(arena.used() == 4 + 6);
+	}
+	CHECK(arena.used() == 0);
+
+	// larger than the block, the memory is still usable and the arena grows once everything is released
+	{
+		const ElementArena::Scope scope(arena);
+		ElementArena::VectorMap a = arena.vector(10);
+		ElementArena::VectorMap b = arena.vector(20);
+		a.setConstant(1);
+		b.setConstant(2);
+		CHECK(a.sum() == 10);
+		CHECK(b.sum() == 40);
+		CHECK(arena.capacity() == 16);
+	}
+	CHECK(arena.used() == 0);
+	CHECK(arena.capacity() >= 30);
+}
+
 #ifdef POLYFEM_WITH_REMESHING
 TEST_CASE("wmtk_instatiation", "[utils]")
 {